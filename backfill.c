@@ -0,0 +1,562 @@
+/** @file backfill.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "libworkload/libworkload.h"
+
+
+/**
+  Schemes for parallel jobs.  Both start jobs in arrival order only once as
+  many cores as they need are free; EASY also lets later jobs start early
+  when that does not delay the reservation of the job at the head.
+*/
+typedef enum {GANG_FCFS = 0, GANG_EASY} gang_scheme_t;
+
+/**
+  A step of the profile of free cores: cores that running jobs release at time.
+*/
+typedef struct _release_t
+{
+	int time, cores;
+} release_t;
+
+/**
+  State of a simulation of one machine running parallel jobs.
+
+  Run times are known exactly, so the profile of running jobs' releases is
+  also the schedule of completions.  It is kept sorted by time, latest
+  first, so that releases are taken off the end.  Waiting jobs form a
+  doubly linked list in arrival order, and are also indexed for backfilling
+  by a tree over blocks of their places in the arrival order.  Each node
+  holds the least cores of the waiting jobs below it and, for each class of
+  cores (1, 2, 3-4, 5-8, ...), their least run time; a search for a job that
+  fits in so many cores for so long skips every subtree without one.
+*/
+typedef struct _machine_t
+{
+	int cores, free;
+	gang_scheme_t scheme;
+
+	release_t *profile;
+	int profile_count;
+
+	int job_count;
+	int *arrival_time, *run_time, *width;
+	int *order;            // job ids by arrival time
+	int *rank;             // place of each job in order
+	int *start;            // time each job started, or -1
+	int *next, *prev;      // links of the waiting queue, or -1
+	int head, tail;
+
+	int *waiting_width;    // cores of the job at each place in order if it is waiting, else INT_MAX
+	int *waiting_run;      // run time of the job at each place in order if it is waiting, else INT_MAX
+	int index_size;        // leaves of the index (blocks of INDEX_BLOCK places), a power of two
+	int classes;           // classes of cores up to the machine's
+	int *least_width;      // of each node
+	int *least_run;        // of each node and class of cores
+
+	int reserved_for;      // job whose reservation shadow and extra hold, or -1
+	int shadow;            // time the head job is guaranteed its cores
+	int extra;             // cores free at shadow beyond what the head job needs
+
+	long long busy;        // core time units spent running jobs
+	int backfilled;
+	int time;
+} machine_t;
+
+/**
+  Places in the arrival order per leaf of the backfilling index.
+*/
+#define INDEX_BLOCK 16
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -c <cores> [-s <scheme>] [-t <threshold>] [-v] <input file>\n", program_name);
+	fprintf(stderr, "       %s -c 128 -s easy jobs.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Simulates parallel jobs on a machine of the given cores.  A job needs the cores of the \"Cores\" column\n");
+	fprintf(stderr, "of the input (a fourth column; one if there is none) at once, and only starts once they are all free.\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs (jobs start strictly in arrival order) and easy (default; EASY backfilling:\n");
+	fprintf(stderr, "the first waiting job gets a reservation, and later jobs may start ahead of it if they do not delay it)\n");
+	fprintf(stderr, "Prints the makespan, the average waiting and turnaround times, the average bounded slowdown (with run\n");
+	fprintf(stderr, "times below the threshold, default 10, counted as the threshold) and the utilization; with -v, also\n");
+	fprintf(stderr, "every job's schedule.\n");
+}
+
+/**
+  Adds a release to the profile, merging it with any at the same time.
+ */
+void machine_add_release(machine_t *machine, int time, int cores)
+{
+	int low = 0, high = machine->profile_count;
+
+	// Find the first step that is earlier than time
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (machine->profile[middle].time > time)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low < machine->profile_count && machine->profile[low].time == time)
+	{
+		machine->profile[low].cores += cores;
+		return;
+	}
+
+	memmove(&machine->profile[low + 1], &machine->profile[low], (machine->profile_count - low) * sizeof(release_t));
+	machine->profile[low].time = time;
+	machine->profile[low].cores = cores;
+	machine->profile_count++;
+}
+
+/**
+  Returns the class of a number of cores: 0 for 1, and c for 2^(c-1)+1 to 2^c.
+ */
+int width_class(int width)
+{
+	return (width <= 1) ? 0 : 32 - __builtin_clz(width - 1);
+}
+
+/**
+  Returns the fewest cores a job of a class of cores needs.
+ */
+int class_least_width(int class)
+{
+	return (class == 0) ? 1 : (1 << (class - 1)) + 1;
+}
+
+/**
+  Recomputes a node of the index from its children, or a leaf from its block.
+ */
+void machine_index_node(machine_t *machine, int node)
+{
+	int *runs = &machine->least_run[node * machine->classes];
+	int c, i;
+
+	if (node >= machine->index_size)
+	{
+		int first = (node - machine->index_size) * INDEX_BLOCK;
+
+		machine->least_width[node] = INT_MAX;
+		for (c = 0; c < machine->classes; c++)
+			runs[c] = INT_MAX;
+
+		for (i = first; i < first + INDEX_BLOCK && i < machine->job_count; i++)
+		{
+			if (machine->waiting_width[i] == INT_MAX)
+				continue;
+			if (machine->waiting_width[i] < machine->least_width[node])
+				machine->least_width[node] = machine->waiting_width[i];
+			c = width_class(machine->waiting_width[i]);
+			if (machine->waiting_run[i] < runs[c])
+				runs[c] = machine->waiting_run[i];
+		}
+		return;
+	}
+
+	int *left = &machine->least_run[2 * node * machine->classes], *right = left + machine->classes;
+
+	machine->least_width[node] = (machine->least_width[2 * node] < machine->least_width[2 * node + 1]) ?
+			machine->least_width[2 * node] : machine->least_width[2 * node + 1];
+	for (c = 0; c < machine->classes; c++)
+		runs[c] = (left[c] < right[c]) ? left[c] : right[c];
+}
+
+/**
+  Sets the cores and run time the index holds for a place in the arrival
+  order; INT_MAX for both if the job there is not waiting.
+ */
+void machine_index(machine_t *machine, int rank, int width, int run_time)
+{
+	int node;
+
+	machine->waiting_width[rank] = width;
+	machine->waiting_run[rank] = run_time;
+	for (node = machine->index_size + rank / INDEX_BLOCK; node >= 1; node /= 2)
+		machine_index_node(machine, node);
+}
+
+/**
+  Finds the earliest waiting job below a node of the index that fits in free
+  cores and either runs for at most limit time units or fits in spare cores.
+  A node is only searched if its least cores fit in spare or, for some class
+  of cores whose jobs may fit in free, its least run time is within limit.
+
+  @return the job's place in the arrival order, or -1 if there is none
+ */
+int machine_find(machine_t *machine, int node, int free, int spare, long long limit)
+{
+	const int *runs = &machine->least_run[node * machine->classes];
+	int c, i;
+
+	if (machine->least_width[node] > spare)
+	{
+		for (c = 0; c < machine->classes && class_least_width(c) <= free; c++)
+			if (runs[c] <= limit)
+				break;
+		if (c == machine->classes || class_least_width(c) > free)
+			return -1;
+	}
+
+	if (node >= machine->index_size)
+	{
+		int first = (node - machine->index_size) * INDEX_BLOCK;
+
+		for (i = first; i < first + INDEX_BLOCK && i < machine->job_count; i++)
+			if (machine->waiting_width[i] <= spare || (machine->waiting_width[i] <= free && machine->waiting_run[i] <= limit))
+				return i;
+		return -1;
+	}
+
+	int found = machine_find(machine, 2 * node, free, spare, limit);
+	return (found != -1) ? found : machine_find(machine, 2 * node + 1, free, spare, limit);
+}
+
+void machine_enqueue(machine_t *machine, int job)
+{
+	machine->next[job] = -1;
+	machine->prev[job] = machine->tail;
+	if (machine->tail != -1)
+		machine->next[machine->tail] = job;
+	else
+		machine->head = job;
+	machine->tail = job;
+
+	machine_index(machine, machine->rank[job], machine->width[job], machine->run_time[job]);
+}
+
+void machine_dequeue(machine_t *machine, int job)
+{
+	if (machine->prev[job] != -1)
+		machine->next[machine->prev[job]] = machine->next[job];
+	else
+		machine->head = machine->next[job];
+	if (machine->next[job] != -1)
+		machine->prev[machine->next[job]] = machine->prev[job];
+	else
+		machine->tail = machine->prev[job];
+
+	machine_index(machine, machine->rank[job], INT_MAX, INT_MAX);
+}
+
+/**
+  Starts a waiting job on as many free cores as it needs.
+ */
+void machine_start(machine_t *machine, int job)
+{
+	machine_dequeue(machine, job);
+	machine->free -= machine->width[job];
+	machine_add_release(machine, machine->time + machine->run_time[job], machine->width[job]);
+	machine->start[job] = machine->time;
+	machine->busy += (long long)machine->run_time[job] * machine->width[job];
+}
+
+/**
+  Works out when the head job can start at the latest, by walking the profile
+  from now until enough cores are released, and how many cores will be free
+  then beyond its own.
+ */
+void machine_reserve(machine_t *machine)
+{
+	int job = machine->head, available = machine->free, i;
+
+	machine->reserved_for = job;
+	for (i = machine->profile_count - 1; i >= 0 && available < machine->width[job]; i--)
+	{
+		available += machine->profile[i].cores;
+		machine->shadow = machine->profile[i].time;
+	}
+	machine->extra = available - machine->width[job];
+}
+
+/**
+  Starts every job that can start now: jobs at the head while they fit and,
+  under EASY, later jobs that fit now and either finish by the head job's
+  reservation or only use cores it leaves spare.  Later jobs are taken in
+  arrival order, each found through the index rather than by walking the
+  queue.
+ */
+void machine_schedule(machine_t *machine)
+{
+	int place;
+
+	while (machine->head != -1 && machine->width[machine->head] <= machine->free)
+		machine_start(machine, machine->head);
+
+	if (machine->scheme != GANG_EASY || machine->head == -1)
+		return;
+
+	if (machine->reserved_for != machine->head)
+		machine_reserve(machine);
+
+	// The head job itself never fits, so it is never found
+	while (machine->free > 0 && (place = machine_find(machine, 1, machine->free, (machine->extra < machine->free) ? machine->extra : machine->free,
+			(long long)machine->shadow - machine->time)) != -1)
+	{
+		int job = machine->order[place];
+
+		if (machine->time + machine->run_time[job] > machine->shadow)
+			machine->extra -= machine->width[job];
+		machine_start(machine, job);
+		machine->backfilled++;
+	}
+}
+
+/**
+  Runs the simulation, jumping from one arrival or release to the next.
+ */
+void machine_run(machine_t *machine)
+{
+	int next_arrival = 0;
+
+	machine->time = 0;
+	while (next_arrival < machine->job_count || machine->profile_count > 0)
+	{
+		int time = -1;
+		if (machine->profile_count > 0)
+			time = machine->profile[machine->profile_count - 1].time;
+		if (next_arrival < machine->job_count && (time == -1 || machine->arrival_time[machine->order[next_arrival]] < time))
+			time = machine->arrival_time[machine->order[next_arrival]];
+		if (time > machine->time)
+			machine->time = time;
+
+		while (machine->profile_count > 0 && machine->profile[machine->profile_count - 1].time <= machine->time)
+			machine->free += machine->profile[--machine->profile_count].cores;
+
+		while (next_arrival < machine->job_count && machine->arrival_time[machine->order[next_arrival]] <= machine->time)
+			machine_enqueue(machine, machine->order[next_arrival++]);
+
+		machine_schedule(machine);
+	}
+}
+
+static int *sort_keys;
+
+int compare_keys(const void *a, const void *b)
+{
+	int x = sort_keys[*(const int *)a], y = sort_keys[*(const int *)b];
+
+	if (x != y)
+		return (x < y) ? -1 : 1;
+	return *(const int *)a - *(const int *)b;
+}
+
+/**
+  Prints the metrics of a finished simulation and, if asked, every job's schedule.
+ */
+void machine_report(machine_t *machine, int threshold, int verbose)
+{
+	int n = machine->job_count, makespan = 0, i;
+	long long waiting = 0, turnaround = 0;
+	double slowdown = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		int finish = machine->start[i] + machine->run_time[i];
+		int bound = (machine->run_time[i] > threshold) ? machine->run_time[i] : threshold;
+		double bounded = (double)(finish - machine->arrival_time[i]) / bound;
+
+		if (finish > makespan)
+			makespan = finish;
+		waiting += machine->start[i] - machine->arrival_time[i];
+		turnaround += finish - machine->arrival_time[i];
+		slowdown += (bounded > 1) ? bounded : 1;
+	}
+
+	printf("Scheduled %d job(s) on %d core(s) using %s.\n\n", n, machine->cores,
+			(machine->scheme == GANG_EASY) ? "EASY backfilling" : "First Come First Served (FCFS)");
+	printf("Makespan: %d\n", makespan);
+	if (n > 0)
+	{
+		printf("Average Waiting Time: %.2f\n", (double)waiting / n);
+		printf("Average Turnaround Time: %.2f\n", (double)turnaround / n);
+		printf("Average Bounded Slowdown: %.2f (threshold %d)\n", slowdown / n, threshold);
+	}
+	printf("Utilization: %.1f%%\n", (makespan > 0) ? 100.0 * machine->busy / ((double)machine->cores * makespan) : 0.0);
+	if (machine->scheme == GANG_EASY)
+		printf("Backfilled: %d job(s)\n", machine->backfilled);
+
+	if (verbose)
+	{
+		printf("\n\"Job\",\"Cores\",\"Arrival Time\",\"Run Time\",\"Start Time\",\"Finish Time\"\n");
+		for (i = 0; i < n; i++)
+			printf("%d,%d,%d,%d,%d,%d\n", i, machine->width[i], machine->arrival_time[i], machine->run_time[i], machine->start[i],
+					machine->start[i] + machine->run_time[i]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	machine_t machine;
+	int c, i, cores = 0, threshold = 10, verbose = 0;
+	gang_scheme_t scheme = GANG_EASY;
+
+	while ((c = getopt(argc, argv, "c:s:t:v")) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				cores = atoi(optarg);
+				if (cores <= 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 's':
+				if (strcasecmp(optarg, "fcfs") == 0) { scheme = GANG_FCFS; }
+				else if (strcasecmp(optarg, "easy") == 0) { scheme = GANG_EASY; }
+				else
+				{
+					fprintf(stderr, "Option -s <scheme> requires either fcfs or easy.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 't':
+				threshold = atoi(optarg);
+				if (threshold <= 0)
+				{
+					fprintf(stderr, "Option -t <threshold> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'v':
+				verbose = 1;
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (cores == 0)
+	{
+		fprintf(stderr, "Required option -c <cores> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "A single input file is required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	workload_t workload;
+	workload_init(&workload);
+	workload_status_t status = workload_load(&workload, argv[optind]);
+	if (status != WORKLOAD_OK)
+	{
+		if (status == WORKLOAD_ERROR_OPEN)
+			fprintf(stderr, "Unable to open file \"%s\".\n", argv[optind]);
+		else if (status == WORKLOAD_ERROR_FORMAT && workload.m_error_line > 0)
+			fprintf(stderr, "Illegal file format on line %d.\n", workload.m_error_line);
+		else if (status == WORKLOAD_ERROR_FORMAT)
+			fprintf(stderr, "Illegal file format.\n");
+		else
+			fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	if (workload.m_burst_start != NULL)
+	{
+		fprintf(stderr, "The workload has CPU bursts, which are only simulated by ./simulator.\n");
+		return 2;
+	}
+	if (workload.m_dependency_start != NULL)
+	{
+		fprintf(stderr, "The workload has a \"Dependencies\" column; jobs that depend on others are only simulated by ./dag.\n");
+		return 2;
+	}
+
+	int n = workload.m_count, size = (n > 0) ? n : 1;
+	machine.cores = machine.free = cores;
+	machine.scheme = scheme;
+	machine.job_count = n;
+	machine.arrival_time = workload.m_arrival_time;
+	machine.run_time = workload.m_run_time;
+	machine.width = malloc(size * sizeof(int));
+	machine.order = malloc(size * sizeof(int));
+	machine.rank = malloc(size * sizeof(int));
+	machine.start = malloc(size * sizeof(int));
+	machine.next = malloc(size * sizeof(int));
+	machine.prev = malloc(size * sizeof(int));
+	machine.profile = malloc(size * sizeof(release_t));
+	machine.waiting_width = malloc(size * sizeof(int));
+	machine.waiting_run = malloc(size * sizeof(int));
+	for (machine.index_size = 1; machine.index_size * INDEX_BLOCK < n; machine.index_size *= 2)
+		;
+	machine.classes = width_class(cores) + 1;
+	machine.least_width = malloc(2 * machine.index_size * sizeof(int));
+	machine.least_run = malloc(2 * machine.index_size * machine.classes * sizeof(int));
+	if (machine.width == NULL || machine.order == NULL || machine.rank == NULL || machine.start == NULL || machine.next == NULL
+			|| machine.prev == NULL || machine.profile == NULL || machine.waiting_width == NULL || machine.waiting_run == NULL
+			|| machine.least_width == NULL || machine.least_run == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		machine.width[i] = (workload.m_cores != NULL) ? workload.m_cores[i] : 1;
+		if (machine.width[i] <= 0 || machine.width[i] > cores || machine.run_time[i] < 0)
+		{
+			fprintf(stderr, "Job %d needs %d core(s) for %d time unit(s), which a machine of %d core(s) cannot run.\n", i,
+					machine.width[i], machine.run_time[i], cores);
+			return 2;
+		}
+		machine.order[i] = i;
+		machine.start[i] = -1;
+	}
+	sort_keys = machine.arrival_time;
+	qsort(machine.order, n, sizeof(int), compare_keys);
+	for (i = 0; i < n; i++)
+		machine.rank[machine.order[i]] = i;
+	for (i = 0; i < n; i++)
+		machine.waiting_width[i] = machine.waiting_run[i] = INT_MAX;
+	for (i = 0; i < 2 * machine.index_size; i++)
+		machine.least_width[i] = INT_MAX;
+	for (i = 0; i < 2 * machine.index_size * machine.classes; i++)
+		machine.least_run[i] = INT_MAX;
+
+	machine.profile_count = 0;
+	machine.head = machine.tail = -1;
+	machine.reserved_for = -1;
+	machine.shadow = machine.extra = 0;
+	machine.busy = 0;
+	machine.backfilled = 0;
+
+	machine_run(&machine);
+	machine_report(&machine, threshold, verbose);
+
+	workload_destroy(&workload);
+	free(machine.width);
+	free(machine.order);
+	free(machine.rank);
+	free(machine.start);
+	free(machine.next);
+	free(machine.prev);
+	free(machine.profile);
+	free(machine.waiting_width);
+	free(machine.waiting_run);
+	free(machine.least_width);
+	free(machine.least_run);
+	return 0;
+}
@@ -0,0 +1,1256 @@
+/** @file cluster.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libeventq/libeventq.h"
+#include "libworkload/libworkload.h"
+
+
+/**
+  Kinds of events on the cluster's event queue.  Completions sharing a time
+  are delivered before quantum expiries, and both before arrivals.
+*/
+typedef enum {EVENT_COMPLETION = 0, EVENT_QUANTUM_EXPIRY} event_type_t;
+
+/**
+  Policies the front end dispatches jobs to nodes with.
+*/
+typedef enum {DISPATCH_RANDOM = 0, DISPATCH_ROUND_ROBIN, DISPATCH_JSQ, DISPATCH_POWER_OF_TWO, DISPATCH_LWL} dispatch_t;
+
+static const char *dispatch_names[] = {"random", "rr", "jsq", "p2c", "lwl"};
+
+/**
+  What a core that runs out of jobs does: stay idle, or take a waiting job
+  from the busiest core of its node.  Under affinity, jobs that have not
+  run yet are taken first, as the others would lose their caches.
+*/
+typedef enum {BALANCE_NONE = 0, BALANCE_STEAL, BALANCE_AFFINITY} balance_t;
+
+static const char *balance_names[] = {"none", "steal", "affinity"};
+
+/**
+  How a node places jobs on its cores.  By load, an arriving job goes to the
+  core with the fewest jobs (the least work under lwl).  By speed, it goes to
+  the fastest idle core, or the core that would finish it first, and a core
+  that runs out of jobs takes the job that would run next on the slowest core
+  with jobs waiting.
+*/
+typedef enum {PLACEMENT_LOAD = 0, PLACEMENT_SPEED} placement_t;
+
+static const char *placement_names[] = {"load", "speed"};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof(array[0])))
+
+/**
+  A core of a node.  libscheduler instances place jobs on core 0 only, so
+  every core has a scheduler of its own and the node picks the core.
+*/
+typedef struct _cluster_core_t
+{
+	scheduler_t scheduler;
+	int job;               // running job, or -1
+	int since;             // time the running job was placed on the core
+	int generation;        // bumped whenever the core changes jobs, invalidating its pending deadlines
+	int jobs;              // jobs on the core, running or queued
+	double speed;          // run time done per time unit
+	double work;           // remaining run time of the core's jobs, as of when each last left it
+	long long busy;        // time units the core has run jobs
+} cluster_core_t;
+
+/**
+  A node: cores behind their schedulers, and what the dispatcher knows of it.
+*/
+typedef struct _cluster_node_t
+{
+	int scheme, quantum;
+	int first_core, cores;
+	int jobs;              // jobs on the node, running or queued
+	int running;           // cores running a job
+	double speed;          // sum of speed over the cores
+	double work;           // remaining run time of the node's jobs, as of when each last left a core
+	double running_speed;  // sum of speed over the running cores
+	double since_sum;      // sum of speed times since over the running cores
+	long long busy;        // time units its cores have run jobs
+	int dispatched;
+	int stamp;             // arrivals dispatched when the node was last picked, breaking ties under jsq and lwl
+} cluster_node_t;
+
+/**
+  State of a cluster simulation.
+*/
+typedef struct _cluster_t
+{
+	cluster_node_t *nodes;
+	int node_count;
+	cluster_core_t *cores;
+	int core_count;
+
+	dispatch_t dispatch;
+	int next_node;         // round robin position
+	int dispatches;        // arrivals dispatched
+	uint64_t seed;
+	balance_t balance;
+	placement_t placement;
+	int migration_cost;    // time units a job loses when it resumes on another core than it last ran on
+
+	eventq_t events;
+
+	// A tournament over the nodes for jsq and lwl: entry i (of 2 * leaves,
+	// node j being leaf leaves + j) holds the node its subtree prefers, and
+	// the time until which that is known to hold.  Under lwl, nodes run
+	// their work off at different rates, so the preferred node can change
+	// between events; it is looked at again once that time is reached.
+	int leaves;
+	int *winner;
+	double *until;
+
+	int job_count;
+	int *arrival_time, *run_time, *priority;
+	int *order;            // job ids by arrival time
+	double *remaining;     // run time left, as of when each job last left a core
+	int *service;          // time units each job has run
+	int *core;             // core each job is queued on
+	int *last_core;        // core each job last ran on, or -1
+	int *first_start;      // time each job first ran, or -1
+	int *finish;           // time each job finished, or -1
+	int alive;
+	int time;
+
+	int steals, takes, migrations;
+	long long lost;        // time units added to jobs by migrations
+} cluster_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -n <nodes> [-d <dispatch>] [-p <placement>] [-b <balance>] [-M <cost>] [-r <seed>] [-u] <input file>\n", program_name);
+	fprintf(stderr, "       %s -n <nodes> [options] -g <workload specification>\n", program_name);
+	fprintf(stderr, "       %s -n 1000x64:fcfs -d p2c -g n=1000000,arrival=poisson:2000,run=exp:30\n", program_name);
+	fprintf(stderr, "       %s -n 8x4:psjf,8x16:rr4 -d lwl examples/proc3.csv\n", program_name);
+	fprintf(stderr, "       %s -n 100x8:sjf@2/2/1 -d lwl -p speed -g n=100000,arrival=poisson:40,run=exp:20\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Simulates a cluster of nodes, each scheduling its own cores, behind a front end that dispatches\n");
+	fprintf(stderr, "every job to a node on arrival.  Nodes are given as a comma-separated list of <count>x<cores>:<scheme>\n");
+	fprintf(stderr, "groups.  Within a node, a job goes to the core with the fewest jobs, or under lwl, the least work.\n");
+	fprintf(stderr, "A group may end in @<speed>/<speed>/..., the run time each core of a node does per time unit (default 1);\n");
+	fprintf(stderr, "the last speed given holds for the remaining cores.\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#\n");
+	fprintf(stderr, "Acceptable dispatch policies are: random (default), rr (round robin), jsq (join the shortest queue),\n");
+	fprintf(stderr, "p2c (the shorter queue of two random nodes) and lwl (least work left).  Queues and work are\n");
+	fprintf(stderr, "compared per unit of speed of the node.\n");
+	fprintf(stderr, "Acceptable placements are: load (default, as above) and speed (a job goes to the fastest idle core, or the\n");
+	fprintf(stderr, "core that would finish it first, and a core that runs out of jobs takes the job that would run next, the\n");
+	fprintf(stderr, "shortest or highest-priority one, on the slowest core of its node with jobs waiting).\n");
+	fprintf(stderr, "Acceptable balance policies, for cores that run out of jobs, are: none (default, stay idle), steal (take\n");
+	fprintf(stderr, "the job that would run last on the core of the node with the most jobs) and affinity (likewise, but\n");
+	fprintf(stderr, "prefer jobs that have not run yet).  A job that resumes on another core than it last ran on runs for\n");
+	fprintf(stderr, "the migration cost (-M, default 0) longer; with a cost, the makespan with free migrations is also shown.\n");
+	fprintf(stderr, "Prints the average metrics, turnaround percentiles and utilization; with -u, also every node's and core's.\n");
+	fprintf(stderr, "With -g, jobs are generated instead of read from a file.  ");
+	workgen_usage(stderr);
+}
+
+int parse_scheme(const char *name, int *quantum)
+{
+	*quantum = 0;
+
+	if (strcasecmp(name, "FCFS") == 0) { return FCFS; }
+	else if (strcasecmp(name, "SJF") == 0) { return SJF; }
+	else if (strcasecmp(name, "PSJF") == 0) { return PSJF; }
+	else if (strcasecmp(name, "PRI") == 0) { return PRI; }
+	else if (strcasecmp(name, "PPRI") == 0) { return PPRI; }
+	else if (strncasecmp(name, "RR", 2) == 0)
+	{
+		*quantum = atoi(name + 2);
+		return (*quantum > 0) ? RR : -1;
+	}
+
+	return -1;
+}
+
+/**
+  Parses the speeds of a group's cores, a list of positive numbers separated
+  by '/', the last of which holds for the cores not listed.
+
+  @return 0 on success, 1 if the list is illegal
+ */
+int parse_speeds(const char *list, double *speeds, int cores)
+{
+	int i = 0;
+	char *end = (char *)list;
+
+	while (i < cores)
+	{
+		speeds[i] = strtod(list, &end);
+		if (end == list || !(speeds[i] > 0))
+			return 1;
+		i++;
+		if (*end == '\0')
+			break;
+		if (*end != '/')
+			return 1;
+		list = end + 1;
+	}
+	if (*end != '\0')
+		return 1;
+
+	for (; i < cores; i++)
+		speeds[i] = speeds[i - 1];
+	return 0;
+}
+
+/**
+  Grows an array of speeds to hold at least count, freeing it if it cannot.
+
+  @return the array, or NULL if out of memory
+ */
+double *reserve_speeds(double *speeds, int *size, int count)
+{
+	while (count > *size)
+	{
+		*size *= 2;
+		double *grown = realloc(speeds, *size * sizeof(double));
+		if (grown == NULL)
+		{
+			free(speeds);
+			return NULL;
+		}
+		speeds = grown;
+	}
+
+	return speeds;
+}
+
+/**
+  Builds the nodes from a list of <count>x<cores>:<scheme>[@<speeds>] groups,
+  and starts up the scheduler of every core.
+
+  @return 0 on success, 1 if the list is illegal, 2 if out of memory
+ */
+int cluster_init(cluster_t *cluster, const char *list)
+{
+	char *copy = strdup(list), *cursor = copy, *group;
+	int size = 16, speed_size = 16, i, j;
+	double *speeds = malloc(speed_size * sizeof(double));
+
+	cluster->nodes = malloc(size * sizeof(cluster_node_t));
+	cluster->node_count = 0;
+	cluster->core_count = 0;
+	if (copy == NULL || cluster->nodes == NULL || speeds == NULL)
+		return 2;
+
+	while ((group = strsep(&cursor, ",")) != NULL)
+	{
+		int count, cores, quantum, scheme, length = 0;
+		char scheme_name[16];
+
+		if (sscanf(group, "%dx%d:%15[^@]%n", &count, &cores, scheme_name, &length) != 3 || (group[length] != '\0' && group[length] != '@')
+				|| count <= 0 || cores <= 0 || (scheme = parse_scheme(scheme_name, &quantum)) == -1)
+		{
+			free(copy);
+			free(speeds);
+			return 1;
+		}
+
+		// The speeds of the group's cores are parsed after the cores of the nodes so far
+		if ((speeds = reserve_speeds(speeds, &speed_size, cluster->core_count + cores)) == NULL)
+			return 2;
+		for (i = 0; i < cores; i++)
+			speeds[cluster->core_count + i] = 1;
+		if (group[length] == '@' && parse_speeds(group + length + 1, &speeds[cluster->core_count], cores) != 0)
+		{
+			free(copy);
+			free(speeds);
+			return 1;
+		}
+
+		for (i = 0; i < count; i++)
+		{
+			if (cluster->node_count == size)
+			{
+				size *= 2;
+				cluster_node_t *nodes = realloc(cluster->nodes, size * sizeof(cluster_node_t));
+				if (nodes == NULL)
+					return 2;
+				cluster->nodes = nodes;
+			}
+
+			cluster_node_t *node = &cluster->nodes[cluster->node_count++];
+			memset(node, 0, sizeof(cluster_node_t));
+			node->scheme = scheme;
+			node->quantum = quantum;
+			node->first_core = cluster->core_count;
+			node->cores = cores;
+			cluster->core_count += cores;
+
+			// Every node of the group has the speeds of its first
+			if (i < count - 1)
+			{
+				if ((speeds = reserve_speeds(speeds, &speed_size, cluster->core_count + cores)) == NULL)
+					return 2;
+				memcpy(&speeds[cluster->core_count], &speeds[node->first_core], cores * sizeof(double));
+			}
+		}
+	}
+	free(copy);
+
+	cluster->cores = malloc(cluster->core_count * sizeof(cluster_core_t));
+	if (cluster->cores == NULL)
+		return 2;
+
+	for (i = 0; i < cluster->node_count; i++)
+	{
+		cluster_node_t *node = &cluster->nodes[i];
+		for (j = node->first_core; j < node->first_core + node->cores; j++)
+		{
+			scheduler_start_up_r(&cluster->cores[j].scheduler, 1, node->scheme);
+			cluster->cores[j].job = -1;
+			cluster->cores[j].since = 0;
+			cluster->cores[j].generation = 0;
+			cluster->cores[j].jobs = 0;
+			cluster->cores[j].speed = speeds[j];
+			cluster->cores[j].work = 0;
+			cluster->cores[j].busy = 0;
+			node->speed += speeds[j];
+		}
+	}
+	free(speeds);
+
+	for (cluster->leaves = 1; cluster->leaves < cluster->node_count; cluster->leaves *= 2)
+		;
+	cluster->winner = malloc(2 * cluster->leaves * sizeof(int));
+	cluster->until = malloc(2 * cluster->leaves * sizeof(double));
+	if (cluster->winner == NULL || cluster->until == NULL)
+		return 2;
+	for (i = 0; i < cluster->leaves; i++)
+	{
+		cluster->winner[cluster->leaves + i] = (i < cluster->node_count) ? i : -1;
+		cluster->until[cluster->leaves + i] = -INFINITY;
+		cluster->until[i] = -INFINITY;
+	}
+
+	if (eventq_init(&cluster->events, 2 * cluster->core_count) != 0)
+		return 2;
+	cluster->next_node = 0;
+	cluster->dispatches = 0;
+	cluster->alive = 0;
+	cluster->time = 0;
+	return 0;
+}
+
+void cluster_destroy(cluster_t *cluster)
+{
+	int i;
+
+	for (i = 0; i < cluster->core_count; i++)
+		scheduler_clean_up_r(&cluster->cores[i].scheduler);
+	eventq_destroy(&cluster->events);
+	free(cluster->cores);
+	free(cluster->nodes);
+	free(cluster->winner);
+	free(cluster->until);
+}
+
+/**
+  Returns the node a core belongs to, by binary search of the nodes' first cores.
+ */
+cluster_node_t *cluster_node_of(cluster_t *cluster, int core_id)
+{
+	int low = 0, high = cluster->node_count - 1;
+
+	while (low < high)
+	{
+		int middle = (low + high + 1) / 2;
+		if (cluster->nodes[middle].first_core <= core_id)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+
+	return &cluster->nodes[low];
+}
+
+uint64_t cluster_random(cluster_t *cluster)
+{
+	// xorshift64*
+	cluster->seed ^= cluster->seed >> 12;
+	cluster->seed ^= cluster->seed << 25;
+	cluster->seed ^= cluster->seed >> 27;
+	return cluster->seed * 2685821657736338717ULL;
+}
+
+/**
+  Returns the run time a node has left at time: the work of its jobs less
+  what its running cores have done since they were given their jobs.
+ */
+double cluster_work_left(cluster_node_t *node, int time)
+{
+	return node->work - (node->running_speed * time - node->since_sum);
+}
+
+/**
+  Compares two nodes for the dispatcher, per unit of speed of each node.
+
+  @return nonzero if node a is to be preferred over node b
+ */
+int cluster_prefer(cluster_t *cluster, cluster_node_t *a, cluster_node_t *b)
+{
+	if (cluster->dispatch == DISPATCH_LWL)
+		return cluster_work_left(a, cluster->time) * b->speed < cluster_work_left(b, cluster->time) * a->speed;
+	return a->jobs * b->speed < b->jobs * a->speed;
+}
+
+/**
+  Returns which of two nodes (by index, -1 for none) the dispatcher prefers
+  now.  Of nodes it likes equally, the one picked longest ago is preferred,
+  so that ties do not all fall on the first nodes.
+ */
+int cluster_pick(cluster_t *cluster, int a, int b)
+{
+	if (a == -1 || b == -1)
+		return (a == -1) ? b : a;
+	if (cluster_prefer(cluster, &cluster->nodes[a], &cluster->nodes[b]))
+		return a;
+	if (cluster_prefer(cluster, &cluster->nodes[b], &cluster->nodes[a]))
+		return b;
+	return (cluster->nodes[a].stamp <= cluster->nodes[b].stamp) ? a : b;
+}
+
+/**
+  Returns the time from which the node that loses to another now may win.
+  Under lwl, the work left per unit of speed of a node falls at the rate its
+  running cores make of its speed, and a node falling faster catches up.
+
+  @param winner the node preferred now
+  @param loser the other node
+ */
+double cluster_overtake(cluster_t *cluster, int winner, int loser)
+{
+	if (cluster->dispatch != DISPATCH_LWL || winner == -1 || loser == -1)
+		return INFINITY;
+
+	cluster_node_t *w = &cluster->nodes[winner], *l = &cluster->nodes[loser];
+	double w_rate = w->running_speed / w->speed, l_rate = l->running_speed / l->speed;
+	if (l_rate <= w_rate)
+		return INFINITY;
+
+	double at = ((l->work + l->since_sum) / l->speed - (w->work + w->since_sum) / w->speed) / (l_rate - w_rate);
+
+	// Rounding may place the crossing late; looking early only costs a
+	// match, and the outcome stands for the rest of the time unit
+	return fmax(at - 1 - 1e-6 * fabs(at), cluster->time + 1);
+}
+
+/**
+  Brings a subtree of the tournament up to date, replaying the matches
+  whose outcome may have changed since they were last played.
+ */
+void cluster_replay(cluster_t *cluster, int entry)
+{
+	if (cluster->until[entry] > cluster->time)
+		return;
+	if (entry >= cluster->leaves)
+	{
+		cluster->until[entry] = INFINITY;
+		return;
+	}
+
+	int left = 2 * entry, right = 2 * entry + 1;
+	cluster_replay(cluster, left);
+	cluster_replay(cluster, right);
+
+	int a = cluster->winner[left], b = cluster->winner[right];
+	int winner = cluster_pick(cluster, a, b);
+	double until = cluster_overtake(cluster, winner, (winner == a) ? b : a);
+
+	cluster->winner[entry] = winner;
+	cluster->until[entry] = fmin(until, fmin(cluster->until[left], cluster->until[right]));
+}
+
+/**
+  Notes that a node's load has changed, for the matches it played to be
+  replayed when the dispatcher next picks a node.
+ */
+void cluster_touch(cluster_t *cluster, cluster_node_t *node)
+{
+	int entry = cluster->leaves + (int)(node - cluster->nodes);
+
+	while (entry >= 1 && cluster->until[entry] != -INFINITY)
+	{
+		cluster->until[entry] = -INFINITY;
+		entry /= 2;
+	}
+}
+
+/**
+  Picks the node an arriving job is sent to.  Under jsq and lwl, the winner
+  of the tournament over the nodes is taken, in O(log nodes).
+ */
+cluster_node_t *cluster_dispatch(cluster_t *cluster)
+{
+	int count = cluster->node_count;
+	cluster_node_t *best;
+
+	switch (cluster->dispatch)
+	{
+		case DISPATCH_RANDOM:
+			return &cluster->nodes[cluster_random(cluster) % count];
+
+		case DISPATCH_ROUND_ROBIN:
+			cluster->next_node = (cluster->next_node + 1) % count;
+			return &cluster->nodes[cluster->next_node];
+
+		case DISPATCH_POWER_OF_TWO:
+		{
+			cluster_node_t *a = &cluster->nodes[cluster_random(cluster) % count];
+			cluster_node_t *b = &cluster->nodes[cluster_random(cluster) % count];
+			return cluster_prefer(cluster, b, a) ? b : a;
+		}
+
+		default:
+			cluster_replay(cluster, 1);
+			best = &cluster->nodes[cluster->winner[1]];
+			best->stamp = ++cluster->dispatches;
+			return best;
+	}
+}
+
+/**
+  Takes the job off a core, charging it and its node for the time it ran.
+ */
+void cluster_vacate(cluster_t *cluster, int core_id)
+{
+	cluster_core_t *core = &cluster->cores[core_id];
+	if (core->job == -1)
+		return;
+
+	cluster_node_t *node = cluster_node_of(cluster, core_id);
+	int ran = cluster->time - core->since;
+	double done = ran * core->speed;
+
+	cluster->remaining[core->job] -= done;
+	cluster->service[core->job] += ran;
+	core->work -= done;
+	core->busy += ran;
+	node->work -= done;
+	node->busy += ran;
+	node->running--;
+	node->running_speed -= core->speed;
+	node->since_sum -= core->speed * core->since;
+	core->job = -1;
+	core->generation++;
+	cluster_touch(cluster, node);
+}
+
+/**
+  Returns the time units a core takes to do an amount of run time.
+ */
+int cluster_time_for(cluster_core_t *core, double work)
+{
+	// Run time is done in fractions on cores that are not of speed 1; what
+	// rounding leaves over is no reason for another time unit
+	return (int)ceil(work / core->speed - 1e-9);
+}
+
+/**
+  Places a job on a core and arms its completion and, under RR, its quantum expiry.
+
+  @return 0 on success, 2 if out of memory
+ */
+int cluster_place(cluster_t *cluster, int core_id, int job)
+{
+	cluster_core_t *core = &cluster->cores[core_id];
+	cluster_node_t *node = cluster_node_of(cluster, core_id);
+
+	cluster_vacate(cluster, core_id);
+
+	// A cold cache makes up for what the job ran elsewhere
+	if (cluster->last_core[job] != -1 && cluster->last_core[job] != core_id)
+	{
+		double cost = cluster->migration_cost * core->speed;
+		cluster->remaining[job] += cost;
+		core->work += cost;
+		node->work += cost;
+		cluster->lost += cluster->migration_cost;
+		cluster->migrations++;
+	}
+	cluster->last_core[job] = core_id;
+
+	core->job = job;
+	core->since = cluster->time;
+	core->generation++;
+	node->running++;
+	node->running_speed += core->speed;
+	node->since_sum += core->speed * cluster->time;
+	cluster_touch(cluster, node);
+	if (cluster->first_start[job] == -1)
+		cluster->first_start[job] = cluster->time;
+
+	if (eventq_push(&cluster->events, cluster->time + cluster_time_for(core, cluster->remaining[job]), EVENT_COMPLETION, core_id, core->generation) != 0)
+		return 2;
+	if (node->scheme == RR && eventq_push(&cluster->events, cluster->time + node->quantum, EVENT_QUANTUM_EXPIRY, core_id, core->generation) != 0)
+		return 2;
+	return 0;
+}
+
+/**
+  Checks that a job a core's scheduler picked is waiting on that core.
+
+  @return 0 if it is, 3 if not
+ */
+int cluster_check(cluster_t *cluster, int core_id, int job, const char *function)
+{
+	if (job == -1 || (job >= 0 && job < cluster->job_count && cluster->core[job] == core_id && cluster->finish[job] == -1))
+		return 0;
+
+	printf("The %s() of core %d selected an invalid job (job_id == %d).\n", function, core_id, job);
+	return 3;
+}
+
+/**
+  Returns the run time a core has left at time.
+ */
+double cluster_core_work_left(cluster_t *cluster, cluster_core_t *core)
+{
+	return core->work - ((core->job != -1) ? (cluster->time - core->since) * core->speed : 0);
+}
+
+/**
+  Picks the core of a node an arriving job is placed on by speed: the
+  fastest idle core, or if none is idle, the core that would finish the job
+  first, were it to run after the work the core has left.
+ */
+int cluster_fastest_core(cluster_t *cluster, cluster_node_t *node, int job)
+{
+	int best = -1, i;
+	double best_finish = 0;
+
+	for (i = node->first_core; i < node->first_core + node->cores; i++)
+		if (cluster->cores[i].jobs == 0 && (best == -1 || cluster->cores[i].speed > cluster->cores[best].speed))
+			best = i;
+	if (best != -1)
+		return best;
+
+	for (i = node->first_core; i < node->first_core + node->cores; i++)
+	{
+		cluster_core_t *core = &cluster->cores[i];
+		double finish = (cluster_core_work_left(cluster, core) + cluster->run_time[job]) / core->speed;
+		if (best == -1 || finish < best_finish)
+		{
+			best = i;
+			best_finish = finish;
+		}
+	}
+
+	return best;
+}
+
+/**
+  Hands an arriving job to a node and to the core of that node with the
+  fewest jobs, or under least work left, with the least work.  Placed by
+  speed, the core is picked by cluster_fastest_core() instead.
+
+  @return 0 on success, 2 if out of memory, 3 if the scheduler made an invalid decision
+ */
+int cluster_arrive(cluster_t *cluster, int job)
+{
+	cluster_node_t *node = cluster_dispatch(cluster);
+	int best = node->first_core, i;
+
+	if (cluster->placement == PLACEMENT_SPEED)
+		best = cluster_fastest_core(cluster, node, job);
+	else
+	{
+		for (i = node->first_core + 1; i < node->first_core + node->cores; i++)
+		{
+			if (cluster->dispatch == DISPATCH_LWL)
+			{
+				if (cluster_core_work_left(cluster, &cluster->cores[i]) < cluster_core_work_left(cluster, &cluster->cores[best]))
+					best = i;
+			}
+			else if (cluster->cores[i].jobs < cluster->cores[best].jobs)
+				best = i;
+		}
+	}
+
+	cluster->core[job] = best;
+	cluster->cores[best].jobs++;
+	cluster->cores[best].work += cluster->run_time[job];
+	node->jobs++;
+	node->work += cluster->run_time[job];
+	node->dispatched++;
+	cluster->alive++;
+	cluster_touch(cluster, node);
+
+	// The scheduler counts run time down a time unit at a time, so it is
+	// given the time the job takes on the core rather than its work
+	int core_id = scheduler_new_job_r(&cluster->cores[best].scheduler, job, cluster->time,
+			cluster_time_for(&cluster->cores[best], cluster->run_time[job]), cluster->priority[job]);
+	if (core_id == 0)
+		return cluster_place(cluster, best, job);
+	else if (core_id != -1)
+	{
+		printf("The scheduler_new_job() of core %d selected an invalid core (core_id == %d).\n", best, core_id);
+		return 3;
+	}
+
+	return 0;
+}
+
+int cluster_cold(int job, void *arg)
+{
+	cluster_t *cluster = arg;
+	return cluster->first_start[job] == -1;
+}
+
+/**
+  Moves a job taken off the scheduler of one core to an idle core, which
+  runs it if its scheduler says so.
+
+  @return 0 on success, 2 if out of memory
+ */
+int cluster_move(cluster_t *cluster, cluster_core_t *from, int core_id, int job)
+{
+	cluster_core_t *to = &cluster->cores[core_id];
+
+	from->jobs--;
+	from->work -= cluster->remaining[job];
+	to->jobs++;
+	to->work += cluster->remaining[job];
+	cluster->core[job] = core_id;
+
+	if (scheduler_new_job_r(&to->scheduler, job, cluster->time, cluster_time_for(to, cluster->remaining[job]), cluster->priority[job]) == 0)
+		return cluster_place(cluster, core_id, job);
+	return 0;
+}
+
+/**
+  Gives an idle core the job that would run next on the slowest core of its
+  node with jobs waiting, if any.
+
+  @return 1 if a job was given, 0 if not, -1 if out of memory
+ */
+int cluster_take(cluster_t *cluster, int core_id)
+{
+	cluster_node_t *node = cluster_node_of(cluster, core_id);
+	cluster_core_t *slowest = NULL;
+	int i, job;
+
+	for (i = node->first_core; i < node->first_core + node->cores; i++)
+	{
+		cluster_core_t *core = &cluster->cores[i];
+		if (core->jobs > 1 && (slowest == NULL || core->speed < slowest->speed || (core->speed == slowest->speed && core->jobs > slowest->jobs)))
+			slowest = core;
+	}
+	if (slowest == NULL || (job = scheduler_take_next_job_r(&slowest->scheduler)) == -1)
+		return 0;
+
+	cluster->takes++;
+	if (cluster_move(cluster, slowest, core_id, job) != 0)
+		return -1;
+	return 1;
+}
+
+/**
+  Gives an idle core a waiting job of the core of its node with the most
+  jobs, if any core of the node has a job waiting.
+
+  @return 0 on success, 2 if out of memory
+ */
+int cluster_steal(cluster_t *cluster, int core_id)
+{
+	cluster_node_t *node = cluster_node_of(cluster, core_id);
+	cluster_core_t *victim = NULL;
+	int i, job = -1;
+
+	for (i = node->first_core; i < node->first_core + node->cores; i++)
+		if (cluster->cores[i].jobs > 1 && (victim == NULL || cluster->cores[i].jobs > victim->jobs))
+			victim = &cluster->cores[i];
+	if (victim == NULL)
+		return 0;
+
+	if (cluster->balance == BALANCE_AFFINITY)
+		job = scheduler_steal_job_r(&victim->scheduler, cluster_cold, cluster);
+	if (job == -1)
+		job = scheduler_steal_job_r(&victim->scheduler, NULL, NULL);
+	if (job == -1)
+		return 0;
+
+	cluster->steals++;
+	return cluster_move(cluster, victim, core_id, job);
+}
+
+/**
+  Delivers a completion or quantum expiry.
+
+  @return 0 on success, 2 if out of memory, 3 if the scheduler made an invalid decision
+ */
+int cluster_deliver(cluster_t *cluster, event_t *event)
+{
+	cluster_core_t *core = &cluster->cores[event->m_key];
+	int job = core->job, next, taken;
+
+	if (event->m_type == EVENT_COMPLETION)
+	{
+		cluster_node_t *node = cluster_node_of(cluster, event->m_key);
+
+		next = scheduler_job_finished_r(&core->scheduler, 0, job, cluster->time);
+		cluster_vacate(cluster, event->m_key);
+		cluster->finish[job] = cluster->time;
+		core->jobs--;
+		node->jobs--;
+		cluster->alive--;
+		cluster_touch(cluster, node);
+
+		if (cluster_check(cluster, event->m_key, next, "scheduler_job_finished") != 0)
+			return 3;
+	}
+	else
+	{
+		next = scheduler_quantum_expired_r(&core->scheduler, 0, cluster->time);
+		cluster_vacate(cluster, event->m_key);
+
+		if (cluster_check(cluster, event->m_key, next, "scheduler_quantum_expired") != 0)
+			return 3;
+	}
+
+	if (next != -1)
+		return cluster_place(cluster, event->m_key, next);
+	if (cluster->placement == PLACEMENT_SPEED && (taken = cluster_take(cluster, event->m_key)) != 0)
+		return (taken == -1) ? 2 : 0;
+	if (cluster->balance != BALANCE_NONE)
+		return cluster_steal(cluster, event->m_key);
+	return 0;
+}
+
+/**
+  Runs the simulation, visiting each event and arrival in time order.
+
+  @return 0 on success, 2 if out of memory, 3 if a scheduler made an invalid decision
+ */
+int cluster_run(cluster_t *cluster)
+{
+	int next_arrival = 0, result;
+	event_t *next;
+
+	while (next_arrival < cluster->job_count || cluster->alive > 0)
+	{
+		// Drop deadlines of cores that have since changed jobs
+		while ((next = eventq_peek(&cluster->events)) != NULL && next->m_generation != cluster->cores[next->m_key].generation)
+			eventq_pop(&cluster->events, NULL);
+
+		if (next != NULL && (next_arrival == cluster->job_count || next->m_time <= cluster->arrival_time[cluster->order[next_arrival]]))
+		{
+			event_t event;
+			eventq_pop(&cluster->events, &event);
+			cluster->time = event.m_time;
+			if ((result = cluster_deliver(cluster, &event)) != 0)
+				return result;
+		}
+		else if (next_arrival < cluster->job_count)
+		{
+			int job = cluster->order[next_arrival++];
+			if (cluster->arrival_time[job] > cluster->time)
+				cluster->time = cluster->arrival_time[job];
+			if ((result = cluster_arrive(cluster, job)) != 0)
+				return result;
+		}
+		else
+		{
+			printf("All cores are idle and at least one job remains unscheduled.\n");
+			return 3;
+		}
+	}
+
+	return 0;
+}
+
+static int *sort_keys;
+
+int compare_keys(const void *a, const void *b)
+{
+	int x = sort_keys[*(const int *)a], y = sort_keys[*(const int *)b];
+
+	if (x != y)
+		return (x < y) ? -1 : 1;
+	return *(const int *)a - *(const int *)b;
+}
+
+int compare_ints(const void *a, const void *b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+  Readies the jobs for a simulation run, and the counters and random numbers
+  of the cluster.
+ */
+void cluster_reset(cluster_t *cluster, unsigned long long seed)
+{
+	int i;
+
+	for (i = 0; i < cluster->job_count; i++)
+	{
+		cluster->remaining[i] = cluster->run_time[i];
+		cluster->core[i] = -1;
+		cluster->service[i] = 0;
+		cluster->last_core[i] = -1;
+		cluster->first_start[i] = -1;
+		cluster->finish[i] = -1;
+	}
+
+	cluster->seed = seed * 0x9E3779B97F4A7C15ULL + 1;
+	cluster->steals = 0;
+	cluster->takes = 0;
+	cluster->migrations = 0;
+	cluster->lost = 0;
+}
+
+/**
+  Prints the utilization of the cores of each speed, if they are not all of
+  one speed.
+ */
+void cluster_report_speeds(cluster_t *cluster)
+{
+	double *speeds = malloc(cluster->core_count * sizeof(double));
+	long long *busy = malloc(cluster->core_count * sizeof(long long));
+	int *cores = malloc(cluster->core_count * sizeof(int));
+	int count = 0, i, j;
+
+	if (speeds == NULL || busy == NULL || cores == NULL)
+	{
+		free(speeds);
+		free(busy);
+		free(cores);
+		return;
+	}
+
+	// Fleets have few speeds, so each core is looked up among those seen
+	for (i = 0; i < cluster->core_count; i++)
+	{
+		cluster_core_t *core = &cluster->cores[i];
+		for (j = 0; j < count && speeds[j] != core->speed; j++)
+			;
+		if (j == count)
+		{
+			speeds[count] = core->speed;
+			busy[count] = 0;
+			cores[count++] = 0;
+		}
+		busy[j] += core->busy;
+		cores[j]++;
+	}
+
+	if (count > 1)
+	{
+		printf("Utilization by Core Speed:");
+		for (j = 0; j < count; j++)
+			printf("%s %gx %.1f%% (%d core(s))", (j > 0) ? "," : "", speeds[j],
+					(cluster->time > 0) ? 100.0 * busy[j] / ((double)cores[j] * cluster->time) : 0.0, cores[j]);
+		printf("\n");
+	}
+
+	free(speeds);
+	free(busy);
+	free(cores);
+}
+
+/**
+  Prints the metrics of a finished simulation.
+
+  @param baseline the makespan of the same simulation with free migrations, or -1
+ */
+void cluster_report(cluster_t *cluster, int per_node, int baseline)
+{
+	int n = cluster->job_count, i;
+	long long waiting = 0, turnaround = 0, response = 0;
+	int *turnarounds = malloc((n > 0 ? n : 1) * sizeof(int));
+	double utilization_sum = 0, utilization_min = 1, utilization_max = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		int t = cluster->finish[i] - cluster->arrival_time[i];
+		turnarounds[i] = t;
+		turnaround += t;
+		waiting += t - cluster->service[i];
+		response += cluster->first_start[i] - cluster->arrival_time[i];
+	}
+	qsort(turnarounds, n, sizeof(int), compare_ints);
+
+	printf("Dispatched %d job(s) to %d node(s) with %d core(s) in total using %s.\n\n", n, cluster->node_count, cluster->core_count,
+			dispatch_names[cluster->dispatch]);
+	printf("Makespan: %d\n", cluster->time);
+	if (baseline >= 0)
+		printf("Makespan with Free Migrations: %d (%+d)\n", baseline, cluster->time - baseline);
+	if (n > 0)
+	{
+		printf("Average Waiting Time: %.2f\n", (double)waiting / n);
+		printf("Average Turnaround Time: %.2f\n", (double)turnaround / n);
+		printf("Average Response Time: %.2f\n", (double)response / n);
+		printf("Turnaround Time Percentiles: p50 %d, p90 %d, p99 %d, p99.9 %d, max %d\n", turnarounds[(int)(n * 0.5)],
+				turnarounds[(int)(n * 0.9)], turnarounds[(int)(n * 0.99)], turnarounds[(int)(n * 0.999)], turnarounds[n - 1]);
+	}
+
+	for (i = 0; i < cluster->node_count; i++)
+	{
+		cluster_node_t *node = &cluster->nodes[i];
+		double utilization = (cluster->time > 0) ? (double)node->busy / ((double)node->cores * cluster->time) : 0;
+		utilization_sum += utilization * node->cores;
+		if (utilization < utilization_min)
+			utilization_min = utilization;
+		if (utilization > utilization_max)
+			utilization_max = utilization;
+	}
+	printf("Utilization: %.1f%% overall, %.1f%% to %.1f%% by node\n", 100 * utilization_sum / cluster->core_count,
+			100 * utilization_min, 100 * utilization_max);
+	cluster_report_speeds(cluster);
+	if (cluster->placement == PLACEMENT_SPEED)
+		printf("Placement by Speed: %d waiting job(s) taken by idle cores\n", cluster->takes);
+	if (cluster->balance != BALANCE_NONE)
+		printf("Balancing: %d job(s) taken by idle cores, %d migration(s) losing %lld time unit(s)\n", cluster->steals,
+				cluster->migrations, cluster->lost);
+
+	if (per_node)
+	{
+		printf("\n\"Node\",\"Cores\",\"Scheme\",\"Jobs\",\"Busy Time\",\"Utilization\"\n");
+		for (i = 0; i < cluster->node_count; i++)
+		{
+			cluster_node_t *node = &cluster->nodes[i];
+			static const char *scheme_names[] = {"FCFS", "SJF", "PSJF", "PRI", "PPRI", "RR"};
+			printf("%d,%d,%s%.0d,%d,%lld,%.4f\n", i, node->cores, scheme_names[node->scheme], node->quantum, node->dispatched, node->busy,
+					(cluster->time > 0) ? (double)node->busy / ((double)node->cores * cluster->time) : 0.0);
+		}
+
+		printf("\n\"Core\",\"Node\",\"Speed\",\"Busy Time\",\"Utilization\"\n");
+		for (i = 0; i < cluster->core_count; i++)
+		{
+			cluster_core_t *core = &cluster->cores[i];
+			printf("%d,%d,%g,%lld,%.4f\n", i, (int)(cluster_node_of(cluster, i) - cluster->nodes), core->speed, core->busy,
+					(cluster->time > 0) ? (double)core->busy / cluster->time : 0.0);
+		}
+	}
+
+	free(turnarounds);
+}
+
+int main(int argc, char **argv)
+{
+	cluster_t cluster;
+	char *nodes = NULL, *spec = NULL, *file_name = NULL;
+	int c, i, per_node = 0;
+	unsigned long long seed = 1;
+
+	cluster.dispatch = DISPATCH_RANDOM;
+	cluster.balance = BALANCE_NONE;
+	cluster.placement = PLACEMENT_LOAD;
+	cluster.migration_cost = 0;
+
+	while ((c = getopt(argc, argv, "n:d:p:b:M:r:ug:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+				nodes = optarg;
+				break;
+
+			case 'd':
+				for (i = 0; i < COUNT(dispatch_names); i++)
+					if (strcasecmp(optarg, dispatch_names[i]) == 0)
+						break;
+				if (i == COUNT(dispatch_names))
+				{
+					fprintf(stderr, "Illegal dispatch policy \"%s\".\n", optarg);
+					print_usage(argv[0]);
+					return 1;
+				}
+				cluster.dispatch = i;
+				break;
+
+			case 'p':
+				for (i = 0; i < COUNT(placement_names); i++)
+					if (strcasecmp(optarg, placement_names[i]) == 0)
+						break;
+				if (i == COUNT(placement_names))
+				{
+					fprintf(stderr, "Illegal placement \"%s\".\n", optarg);
+					print_usage(argv[0]);
+					return 1;
+				}
+				cluster.placement = i;
+				break;
+
+			case 'b':
+				for (i = 0; i < COUNT(balance_names); i++)
+					if (strcasecmp(optarg, balance_names[i]) == 0)
+						break;
+				if (i == COUNT(balance_names))
+				{
+					fprintf(stderr, "Illegal balance policy \"%s\".\n", optarg);
+					print_usage(argv[0]);
+					return 1;
+				}
+				cluster.balance = i;
+				break;
+
+			case 'M':
+				cluster.migration_cost = atoi(optarg);
+				if (cluster.migration_cost < 0)
+				{
+					fprintf(stderr, "Option -M <cost> requires a number that is not negative.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'r':
+				seed = strtoull(optarg, NULL, 10);
+				break;
+
+			case 'u':
+				per_node = 1;
+				break;
+
+			case 'g':
+				spec = optarg;
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (nodes == NULL)
+	{
+		fprintf(stderr, "Required option -n <nodes> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (spec == NULL && optind == argc - 1)
+		file_name = argv[optind];
+	else if (spec == NULL || optind != argc)
+	{
+		fprintf(stderr, "A single input file, or -g and no input file, is required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	int result = cluster_init(&cluster, nodes);
+	if (result == 1)
+	{
+		fprintf(stderr, "Illegal node list \"%s\".\n", nodes);
+		print_usage(argv[0]);
+		return 1;
+	}
+	else if (result != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	workload_t workload;
+	workload_init(&workload);
+	workload_status_t status = (spec != NULL) ? workload_generate(&workload, spec) : workload_load(&workload, file_name);
+	if (status != WORKLOAD_OK)
+	{
+		if (spec != NULL && status == WORKLOAD_ERROR_FORMAT)
+			fprintf(stderr, "Illegal workload specification \"%s\".\n", spec);
+		else if (status == WORKLOAD_ERROR_OPEN)
+			fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+		else if (status == WORKLOAD_ERROR_FORMAT)
+			fprintf(stderr, "Illegal file format on line %d.\n", workload.m_error_line);
+		else
+			fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	if (workload.m_cores != NULL)
+	{
+		fprintf(stderr, "The workload has a \"Cores\" column; jobs that need several cores are only simulated by ./backfill.\n");
+		return 2;
+	}
+	if (workload.m_burst_start != NULL)
+	{
+		fprintf(stderr, "The workload has CPU bursts, which are only simulated by ./simulator.\n");
+		return 2;
+	}
+	if (workload.m_dependency_start != NULL)
+	{
+		fprintf(stderr, "The workload has a \"Dependencies\" column; jobs that depend on others are only simulated by ./dag.\n");
+		return 2;
+	}
+
+	int n = workload.m_count, size = (n > 0) ? n : 1;
+	cluster.job_count = n;
+	cluster.arrival_time = workload.m_arrival_time;
+	cluster.run_time = workload.m_run_time;
+	cluster.priority = workload.m_priority;
+	cluster.order = malloc(size * sizeof(int));
+	cluster.remaining = malloc(size * sizeof(double));
+	cluster.service = malloc(size * sizeof(int));
+	cluster.core = malloc(size * sizeof(int));
+	cluster.last_core = malloc(size * sizeof(int));
+	cluster.first_start = malloc(size * sizeof(int));
+	cluster.finish = malloc(size * sizeof(int));
+	if (cluster.order == NULL || cluster.remaining == NULL || cluster.service == NULL || cluster.core == NULL || cluster.last_core == NULL || cluster.first_start == NULL
+			|| cluster.finish == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	for (i = 0; i < n; i++)
+		cluster.order[i] = i;
+	sort_keys = cluster.arrival_time;
+	qsort(cluster.order, n, sizeof(int), compare_keys);
+
+	// With a migration cost, the same cluster is first run with free
+	// migrations, for its makespan to be compared with
+	int baseline = -1;
+	if (cluster.migration_cost > 0)
+	{
+		int cost = cluster.migration_cost;
+
+		cluster.migration_cost = 0;
+		cluster_reset(&cluster, seed);
+		result = cluster_run(&cluster);
+		baseline = cluster.time;
+		cluster_destroy(&cluster);
+
+		if (result == 0 && cluster_init(&cluster, nodes) != 0)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+		cluster.migration_cost = cost;
+	}
+
+	if (result == 0)
+	{
+		cluster_reset(&cluster, seed);
+		result = cluster_run(&cluster);
+	}
+	if (result == 0)
+		cluster_report(&cluster, per_node, baseline);
+	else if (result == 2)
+		fprintf(stderr, "Out of memory.\n");
+
+	cluster_destroy(&cluster);
+	workload_destroy(&workload);
+	free(cluster.order);
+	free(cluster.remaining);
+	free(cluster.service);
+	free(cluster.core);
+	free(cluster.last_core);
+	free(cluster.first_start);
+	free(cluster.finish);
+	return result;
+}
@@ -0,0 +1,469 @@
+/** @file dag.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "libeventq/libeventq.h"
+#include "libworkload/libworkload.h"
+
+
+/**
+  Orders in which ready jobs are started.  CP starts the job with the
+  longest chain of jobs still to run after it, itself included, first.
+*/
+typedef enum {DAG_FCFS = 0, DAG_SJF, DAG_PRI, DAG_CP} dag_scheme_t;
+
+static const char *scheme_names[] = {"First Come First Served (FCFS)", "Shortest Job First (SJF)", "Priority (PRI)",
+		"Critical Path First (CP)"};
+
+/**
+  State of a simulation of dependent jobs on identical cores.
+
+  The jobs that depend on job i, its successors, are successors[successor_start[i]]
+  up to successors[successor_start[i + 1]], and each job counts what it still
+  waits for: its arrival and every job it depends on.  When a job finishes,
+  only its successors are visited, so dependencies are resolved in
+  O(out-degree) per completion.  A job whose count reaches zero is ready;
+  ready jobs wait in a heap ordered by the scheme, and running jobs in a
+  heap of their completions.
+*/
+typedef struct _dag_t
+{
+	int cores, free;
+	dag_scheme_t scheme;
+
+	int job_count, dependency_count;
+	int *arrival_time, *run_time, *priority;
+	int *successor_start, *successors;
+	int *waiting_for;      // arrival and unfinished dependencies of each job
+	int *order;            // job ids by arrival time
+	long long *path;       // run time of the longest chain of jobs from each job on
+	long long path_bound;  // latest any job can finish, with unlimited cores
+	int *ready_time, *start;
+
+	eventq_t ready, running;
+	long long busy;        // core time units spent running jobs
+	int time;
+} dag_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -c <cores> [-s <scheme>] [-v] <input file>\n", program_name);
+	fprintf(stderr, "       %s -c 16 -s cp workflow.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Simulates jobs that depend on others on the given cores.  The \"Dependencies\" column of the input (the\n");
+	fprintf(stderr, "fourth, after the priority) lists the jobs, counted from 0 in input order, that must\n");
+	fprintf(stderr, "finish before a job is ready, separated by '/'; a job also has to have arrived.  Jobs run to completion.\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs (in the order jobs became ready), sjf, pri and cp (default; critical path\n");
+	fprintf(stderr, "first: the job with the longest chain of dependent jobs still to run after it)\n");
+	fprintf(stderr, "Prints the makespan against its lower bounds, the longest chain of dependent jobs and the total run time\n");
+	fprintf(stderr, "over the cores, and the average waiting (from ready to start) and turnaround times and the utilization;\n");
+	fprintf(stderr, "with -v, also every job's schedule.\n");
+}
+
+/**
+  Builds the successor lists and dependency counts from the dependencies of a
+  workload, and checks that every dependency is a job of it.
+
+  @return 0 on success, -1 if a dependency is not a job of the workload
+ */
+int dag_link(dag_t *dag, workload_t *workload)
+{
+	int n = dag->job_count, i, j;
+
+	for (i = 0; i <= n; i++)
+		dag->successor_start[i] = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		dag->waiting_for[i] = 1;
+		for (j = workload->m_dependency_start[i]; j < workload->m_dependency_start[i + 1]; j++)
+		{
+			int parent = workload->m_dependencies[j];
+			if (parent >= n || parent == i)
+			{
+				fprintf(stderr, "Job %d depends on job %d, which is not another job of the workload.\n", i, parent);
+				return -1;
+			}
+			dag->successor_start[parent + 1]++;
+			dag->waiting_for[i]++;
+		}
+	}
+
+	for (i = 0; i < n; i++)
+		dag->successor_start[i + 1] += dag->successor_start[i];
+
+	// Fill the lists using their starts as cursors, which leaves each at the
+	// start of the next list, then shift the starts back
+	for (i = 0; i < n; i++)
+		for (j = workload->m_dependency_start[i]; j < workload->m_dependency_start[i + 1]; j++)
+			dag->successors[dag->successor_start[workload->m_dependencies[j]]++] = i;
+	for (i = n; i > 0; i--)
+		dag->successor_start[i] = dag->successor_start[i - 1];
+	dag->successor_start[0] = 0;
+
+	dag->dependency_count = workload->m_dependency_start[n];
+	return 0;
+}
+
+/**
+  Works out each job's longest chain of jobs from it on and the latest any
+  job could finish if cores were unlimited, from a topological order of the
+  jobs.
+
+  @param topological room for every job
+  @param earliest room for every job
+  @return 0 on success, -1 if the dependencies form a cycle
+ */
+int dag_paths(dag_t *dag, int *topological, long long *earliest)
+{
+	int n = dag->job_count, head = 0, tail = 0, i, j;
+	int *missing = dag->ready_time;  // not in use until the simulation runs
+
+	for (i = 0; i < n; i++)
+	{
+		missing[i] = dag->waiting_for[i] - 1;
+		earliest[i] = dag->arrival_time[i];
+		if (missing[i] == 0)
+			topological[tail++] = i;
+	}
+
+	dag->path_bound = 0;
+	while (head < tail)
+	{
+		int job = topological[head++];
+		long long finish = earliest[job] + dag->run_time[job];
+
+		if (finish > dag->path_bound)
+			dag->path_bound = finish;
+		for (j = dag->successor_start[job]; j < dag->successor_start[job + 1]; j++)
+		{
+			int next = dag->successors[j];
+			if (finish > earliest[next])
+				earliest[next] = finish;
+			if (--missing[next] == 0)
+				topological[tail++] = next;
+		}
+	}
+
+	if (tail < n)
+		return -1;
+
+	for (i = n - 1; i >= 0; i--)
+	{
+		int job = topological[i];
+		long long longest = 0;
+
+		for (j = dag->successor_start[job]; j < dag->successor_start[job + 1]; j++)
+			if (dag->path[dag->successors[j]] > longest)
+				longest = dag->path[dag->successors[j]];
+		dag->path[job] = dag->run_time[job] + longest;
+	}
+
+	return 0;
+}
+
+/**
+  Counts off one of the things a job waits for, and queues it once it is
+  ready.  The heap is ordered by the scheme's key, then by the time the job
+  became ready and then by job id.
+
+  @return 0 on success, -1 if out of memory
+ */
+int dag_release(dag_t *dag, int job)
+{
+	int key;
+
+	if (--dag->waiting_for[job] > 0)
+		return 0;
+
+	dag->ready_time[job] = dag->time;
+	switch (dag->scheme)
+	{
+		case DAG_SJF: key = dag->run_time[job]; break;
+		case DAG_PRI: key = dag->priority[job]; break;
+		case DAG_CP: key = (dag->path[job] < INT_MAX) ? -(int)dag->path[job] : -INT_MAX; break;
+		default: key = dag->time; break;
+	}
+	return eventq_push(&dag->ready, key, dag->time, job, 0);
+}
+
+/**
+  Runs the simulation, jumping from one arrival or completion to the next.
+  Completions are taken before arrivals at the same time, and ready jobs are
+  then started while cores are free.
+
+  @return 0 on success, -1 if out of memory
+ */
+int dag_run(dag_t *dag)
+{
+	int next_arrival = 0, j;
+	event_t event, *next;
+
+	dag->time = 0;
+	while (next_arrival < dag->job_count || eventq_size(&dag->running) > 0)
+	{
+		int time = -1;
+		if ((next = eventq_peek(&dag->running)) != NULL)
+			time = next->m_time;
+		if (next_arrival < dag->job_count && (time == -1 || dag->arrival_time[dag->order[next_arrival]] < time))
+			time = dag->arrival_time[dag->order[next_arrival]];
+		if (time > dag->time)
+			dag->time = time;
+
+		while ((next = eventq_peek(&dag->running)) != NULL && next->m_time <= dag->time)
+		{
+			eventq_pop(&dag->running, &event);
+			dag->free++;
+			for (j = dag->successor_start[event.m_key]; j < dag->successor_start[event.m_key + 1]; j++)
+				if (dag_release(dag, dag->successors[j]) != 0)
+					return -1;
+		}
+
+		while (next_arrival < dag->job_count && dag->arrival_time[dag->order[next_arrival]] <= dag->time)
+			if (dag_release(dag, dag->order[next_arrival++]) != 0)
+				return -1;
+
+		while (dag->free > 0 && eventq_pop(&dag->ready, &event))
+		{
+			int job = event.m_key;
+			dag->start[job] = dag->time;
+			dag->free--;
+			dag->busy += dag->run_time[job];
+			if (eventq_push(&dag->running, dag->time + dag->run_time[job], 0, job, 0) != 0)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int *sort_keys;
+
+int compare_keys(const void *a, const void *b)
+{
+	int x = sort_keys[*(const int *)a], y = sort_keys[*(const int *)b];
+
+	if (x != y)
+		return (x < y) ? -1 : 1;
+	return *(const int *)a - *(const int *)b;
+}
+
+/**
+  Prints the metrics of a finished simulation and, if asked, every job's schedule.
+ */
+void dag_report(dag_t *dag, int verbose)
+{
+	int n = dag->job_count, makespan = 0, first_arrival = INT_MAX, i;
+	long long waiting = 0, turnaround = 0, work = 0;
+
+	for (i = 0; i < n; i++)
+	{
+		int finish = dag->start[i] + dag->run_time[i];
+
+		if (finish > makespan)
+			makespan = finish;
+		if (dag->arrival_time[i] < first_arrival)
+			first_arrival = dag->arrival_time[i];
+		waiting += dag->start[i] - dag->ready_time[i];
+		turnaround += finish - dag->arrival_time[i];
+		work += dag->run_time[i];
+	}
+
+	// However the jobs are ordered, no schedule beats either bound
+	long long work_bound = (n > 0) ? first_arrival + (work + dag->cores - 1) / dag->cores : 0;
+	long long bound = (dag->path_bound > work_bound) ? dag->path_bound : work_bound;
+
+	printf("Scheduled %d job(s) with %d dependenc%s on %d core(s) using %s.\n\n", n, dag->dependency_count,
+			(dag->dependency_count == 1) ? "y" : "ies", dag->cores, scheme_names[dag->scheme]);
+	printf("Makespan: %d\n", makespan);
+	printf("Critical Path Lower Bound: %lld\n", dag->path_bound);
+	printf("Work Lower Bound: %lld\n", work_bound);
+	printf("Makespan over Lower Bound: %.3f\n", (bound > 0) ? (double)makespan / bound : 1.0);
+	if (n > 0)
+	{
+		printf("Average Waiting Time: %.2f\n", (double)waiting / n);
+		printf("Average Turnaround Time: %.2f\n", (double)turnaround / n);
+	}
+	printf("Utilization: %.1f%%\n", (makespan > 0) ? 100.0 * dag->busy / ((double)dag->cores * makespan) : 0.0);
+
+	if (verbose)
+	{
+		printf("\n\"Job\",\"Arrival Time\",\"Run Time\",\"Critical Path\",\"Ready Time\",\"Start Time\",\"Finish Time\"\n");
+		for (i = 0; i < n; i++)
+			printf("%d,%d,%d,%lld,%d,%d,%d\n", i, dag->arrival_time[i], dag->run_time[i], dag->path[i], dag->ready_time[i],
+					dag->start[i], dag->start[i] + dag->run_time[i]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	dag_t dag;
+	int c, i, cores = 0, verbose = 0;
+	dag_scheme_t scheme = DAG_CP;
+
+	while ((c = getopt(argc, argv, "c:s:v")) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				cores = atoi(optarg);
+				if (cores <= 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 's':
+				if (strcasecmp(optarg, "fcfs") == 0) { scheme = DAG_FCFS; }
+				else if (strcasecmp(optarg, "sjf") == 0) { scheme = DAG_SJF; }
+				else if (strcasecmp(optarg, "pri") == 0) { scheme = DAG_PRI; }
+				else if (strcasecmp(optarg, "cp") == 0) { scheme = DAG_CP; }
+				else
+				{
+					fprintf(stderr, "Option -s <scheme> requires one of fcfs, sjf, pri or cp.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'v':
+				verbose = 1;
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (cores == 0)
+	{
+		fprintf(stderr, "Required option -c <cores> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "A single input file is required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	workload_t workload;
+	workload_init(&workload);
+	workload_status_t status = workload_load(&workload, argv[optind]);
+	if (status != WORKLOAD_OK)
+	{
+		if (status == WORKLOAD_ERROR_OPEN)
+			fprintf(stderr, "Unable to open file \"%s\".\n", argv[optind]);
+		else if (status == WORKLOAD_ERROR_FORMAT && workload.m_error_line > 0)
+			fprintf(stderr, "Illegal file format on line %d.\n", workload.m_error_line);
+		else if (status == WORKLOAD_ERROR_FORMAT)
+			fprintf(stderr, "Illegal file format.\n");
+		else
+			fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	if (workload.m_cores != NULL)
+	{
+		fprintf(stderr, "The workload has a \"Cores\" column; jobs that need several cores are only simulated by ./backfill.\n");
+		return 2;
+	}
+	if (workload.m_burst_start != NULL)
+	{
+		fprintf(stderr, "The workload has CPU bursts, which are only simulated by ./simulator.\n");
+		return 2;
+	}
+
+	int n = workload.m_count, size = (n > 0) ? n : 1;
+	int edges = (workload.m_dependency_start != NULL) ? workload.m_dependency_start[n] : 0;
+	dag.cores = dag.free = cores;
+	dag.scheme = scheme;
+	dag.job_count = n;
+	dag.dependency_count = 0;
+	dag.arrival_time = workload.m_arrival_time;
+	dag.run_time = workload.m_run_time;
+	dag.priority = workload.m_priority;
+	dag.successor_start = malloc((n + 1) * sizeof(int));
+	dag.successors = malloc((edges > 0 ? edges : 1) * sizeof(int));
+	dag.waiting_for = malloc(size * sizeof(int));
+	dag.order = malloc(size * sizeof(int));
+	dag.path = malloc(size * sizeof(long long));
+	dag.ready_time = malloc(size * sizeof(int));
+	dag.start = malloc(size * sizeof(int));
+	int *topological = malloc(size * sizeof(int));
+	long long *earliest = malloc(size * sizeof(long long));
+	if (dag.successor_start == NULL || dag.successors == NULL || dag.waiting_for == NULL || dag.order == NULL || dag.path == NULL
+			|| dag.ready_time == NULL || dag.start == NULL || topological == NULL || earliest == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		if (dag.run_time[i] < 0)
+		{
+			fprintf(stderr, "Job %d runs for %d time unit(s), which no core can run.\n", i, dag.run_time[i]);
+			return 2;
+		}
+		dag.order[i] = i;
+		dag.start[i] = -1;
+	}
+
+	if (workload.m_dependency_start == NULL)
+	{
+		for (i = 0; i <= n; i++)
+			dag.successor_start[i] = 0;
+		for (i = 0; i < n; i++)
+			dag.waiting_for[i] = 1;
+	}
+	else if (dag_link(&dag, &workload) != 0)
+		return 2;
+
+	if (dag_paths(&dag, topological, earliest) != 0)
+	{
+		fprintf(stderr, "The dependencies of the jobs form a cycle.\n");
+		return 2;
+	}
+	free(topological);
+	free(earliest);
+
+	sort_keys = dag.arrival_time;
+	qsort(dag.order, n, sizeof(int), compare_keys);
+
+	if (eventq_init(&dag.ready, 64) != 0 || eventq_init(&dag.running, cores) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	dag.busy = 0;
+
+	if (dag_run(&dag) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	dag_report(&dag, verbose);
+
+	eventq_destroy(&dag.ready);
+	eventq_destroy(&dag.running);
+	workload_destroy(&workload);
+	free(dag.successor_start);
+	free(dag.successors);
+	free(dag.waiting_for);
+	free(dag.order);
+	free(dag.path);
+	free(dag.ready_time);
+	free(dag.start);
+	return 0;
+}
@@ -0,0 +1,72 @@
+/** @file eventqtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libeventq/libeventq.h"
+
+int failures = 0;
+
+void expect(const char *what, int value, int expected)
+{
+	printf("%s: %d (expected %d).\n", what, value, expected);
+	if (value != expected)
+		failures++;
+}
+
+int main()
+{
+	eventq_t q;
+	event_t event;
+	int i;
+
+	/* Start with room for one event, so pushes grow the heap. */
+	expect("Initialized", eventq_init(&q, 1), 0);
+	expect("Popped from an empty queue", eventq_pop(&q, &event), 0);
+	expect("Peeked at an empty queue", eventq_peek(&q) == NULL, 1);
+
+	/* Ties in time go to the lower type, then to the lower key. */
+	eventq_push(&q, 20, 0, 1, 0);
+	eventq_push(&q, 10, 1, 3, 0);
+	eventq_push(&q, 10, 0, 7, 0);
+	eventq_push(&q, 10, 1, 2, 0);
+	eventq_push(&q, 5, 1, 9, 0);
+	eventq_push(&q, 10, 0, 4, 4);
+	expect("Total events", eventq_size(&q), 6);
+	expect("Earliest time", eventq_peek(&q)->m_time, 5);
+
+	printf("Events in order (expected 5/1/9 10/0/4 10/0/7 10/1/2 10/1/3 20/0/1): ");
+	int times[6] = { 5, 10, 10, 10, 10, 20 }, keys[6] = { 9, 4, 7, 2, 3, 1 }, ordered = 1, generation = -1;
+	for (i = 0; eventq_pop(&q, &event); i++)
+	{
+		printf("%d/%d/%d ", event.m_time, event.m_type, event.m_key);
+		if (i >= 6 || event.m_time != times[i] || event.m_key != keys[i])
+			ordered = 0;
+		if (event.m_key == 4)
+			generation = event.m_generation;
+	}
+	printf("\n");
+	expect("Popped in order", ordered, 1);
+	expect("Generation of event 10/0/4", generation, 4);
+
+	/* Many events pushed in scrambled order come out sorted. */
+	for (i = 0; i < 1000; i++)
+		eventq_push(&q, (i * 7919) % 1000, 0, i, i);
+	int previous = -1, sorted = 1, count = 0;
+	while (eventq_pop(&q, &event))
+	{
+		if (event.m_time < previous || event.m_generation != event.m_key)
+			sorted = 0;
+		previous = event.m_time;
+		count++;
+	}
+	expect("Events popped", count, 1000);
+	expect("Popped in time order", sorted, 1);
+
+	eventq_destroy(&q);
+
+	if (failures > 0)
+		printf("%d check(s) failed.\n", failures);
+	return (failures > 0) ? 1 : 0;
+}
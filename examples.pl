@@ -3,14 +3,20 @@
 # EECS678
 # Adopted from CS 241 @ The University of Illinois
 
+# Every example is checked with both engines and both streaming modes,
+# which must all give the same results
+@modes = ("-m tick", "-m event", "-S", "-L");
+
 for $file (<examples/*>){
 	if( $file =~ /proc(\d+)-c(\d+)-(\w+)\.out/){
 	#	print "Proc $1 CORE $2 Proc $3\n";
-		`./simulator -c $2 -s $3 examples/proc$1.csv | tail -7 > output1`;
 		`tail -7 $file > output2`;
-		$diff = `diff output1 output2`;
-		if($diff){
-			print "Test file $file differs\n$diff";
+		for $mode (@modes){
+			`./simulator $mode -c $2 -s $3 examples/proc$1.csv | tail -7 > output1`;
+			$diff = `diff output1 output2`;
+			if($diff){
+				print "Test file $file differs with $mode\n$diff";
+			}
 		}
 	}
 }
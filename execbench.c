@@ -0,0 +1,328 @@
+/** @file execbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libexecutor/libexecutor.h"
+
+
+/**
+  Spins of the busy loop that make up one unit of a task's work.
+*/
+#define WORK_UNIT_SPINS 100
+
+/**
+  A task of the benchmark: a busy loop of work units, timed from submission
+  to completion.
+*/
+typedef struct _bench_task_t
+{
+	int work, priority;
+	double submit_ns, finish_ns;
+} bench_task_t;
+
+/**
+  The baseline: a plain pool of worker threads taking closures from a FIFO
+  queue, with no ordering or accounting.
+*/
+typedef struct _fifo_pool_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t ready, drained;
+	bench_task_t **queue;       // circular, head + count elements from head
+	int head, count, capacity;
+	pthread_t *workers;
+	int cores, outstanding, stopping;
+} fifo_pool_t;
+
+/**
+  The pools measured: the FIFO baseline, then the executor under each scheme.
+*/
+typedef struct _pool_kind_t
+{
+	const char *name;
+	int scheme;        // -1 for the FIFO baseline
+} pool_kind_t;
+
+static const pool_kind_t pools[] = {
+	{"fifo", -1}, {"fcfs", FCFS}, {"sjf", SJF}, {"pri", PRI}, {"rr", RR},
+};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof(array[0])))
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-n <tasks>] [-c <workers>] [-w <mean work units>] [-r <repetitions>]\n", program_name);
+	fprintf(stderr, "Submits a burst of tasks to a plain FIFO thread pool and to the executor under each scheme, and\n");
+	fprintf(stderr, "prints the throughput and the submission-to-completion latency of each.  Tasks are run twice:\n");
+	fprintf(stderr, "empty, which measures the cost of the pool itself, and as busy loops of exponentially distributed\n");
+	fprintf(stderr, "work (default mean 20 units of %d spins), given to the executor as their estimates.\n", WORK_UNIT_SPINS);
+	fprintf(stderr, "Each result is the repetition (default 3) with the highest throughput.\n");
+}
+
+double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+void run_task(void *arg)
+{
+	bench_task_t *task = arg;
+	volatile int spin;
+
+	for (spin = 0; spin < task->work * WORK_UNIT_SPINS; spin++)
+		;
+	task->finish_ns = now_ns();
+}
+
+void *fifo_worker(void *arg)
+{
+	fifo_pool_t *pool = arg;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;)
+	{
+		while (pool->count == 0 && !pool->stopping)
+			pthread_cond_wait(&pool->ready, &pool->lock);
+		if (pool->count == 0)
+			break;
+
+		bench_task_t *task = pool->queue[pool->head];
+		pool->head = (pool->head + 1) % pool->capacity;
+		pool->count--;
+		pthread_mutex_unlock(&pool->lock);
+
+		run_task(task);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->outstanding == 0)
+			pthread_cond_broadcast(&pool->drained);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+int fifo_pool_init(fifo_pool_t *pool, int cores, int capacity)
+{
+	int i;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->ready, NULL);
+	pthread_cond_init(&pool->drained, NULL);
+	pool->queue = malloc(capacity * sizeof(bench_task_t *));
+	pool->head = pool->count = 0;
+	pool->capacity = capacity;
+	pool->workers = malloc(cores * sizeof(pthread_t));
+	pool->cores = cores;
+	pool->outstanding = pool->stopping = 0;
+
+	if (pool->queue == NULL || pool->workers == NULL)
+		return -1;
+	for (i = 0; i < cores; i++)
+		if (pthread_create(&pool->workers[i], NULL, fifo_worker, pool) != 0)
+			return -1;
+	return 0;
+}
+
+/**
+  Queues a task.  The queue is sized for the whole burst up front, so it
+  never fills.
+ */
+void fifo_pool_submit(fifo_pool_t *pool, bench_task_t *task)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->queue[(pool->head + pool->count++) % pool->capacity] = task;
+	pool->outstanding++;
+	pthread_cond_signal(&pool->ready);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void fifo_pool_wait(fifo_pool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->outstanding > 0)
+		pthread_cond_wait(&pool->drained, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void fifo_pool_destroy(fifo_pool_t *pool)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->cores; i++)
+		pthread_join(pool->workers[i], NULL);
+	free(pool->queue);
+	free(pool->workers);
+}
+
+/**
+  Submits every task to a fresh pool of the given kind and waits for them.
+
+  @return the nanoseconds from the first submission until the last task finished,
+  @return or -1 if the pool could not be started
+ */
+double run_burst(const pool_kind_t *kind, int cores, bench_task_t *tasks, int task_count)
+{
+	double start;
+	int i;
+
+	if (kind->scheme == -1)
+	{
+		fifo_pool_t pool;
+		if (fifo_pool_init(&pool, cores, task_count) != 0)
+			return -1;
+
+		start = now_ns();
+		for (i = 0; i < task_count; i++)
+		{
+			tasks[i].submit_ns = now_ns();
+			fifo_pool_submit(&pool, &tasks[i]);
+		}
+		fifo_pool_wait(&pool);
+		fifo_pool_destroy(&pool);
+	}
+	else
+	{
+		executor_t executor;
+		if (executor_init(&executor, cores, kind->scheme) != 0)
+			return -1;
+
+		start = now_ns();
+		for (i = 0; i < task_count; i++)
+		{
+			tasks[i].submit_ns = now_ns();
+			if (executor_submit(&executor, run_task, &tasks[i], tasks[i].priority, tasks[i].work) != 0)
+				return -1;
+		}
+		executor_wait(&executor);
+		executor_destroy(&executor);
+	}
+
+	double end = 0;
+	for (i = 0; i < task_count; i++)
+		if (tasks[i].finish_ns > end)
+			end = tasks[i].finish_ns;
+	return end - start;
+}
+
+/**
+  Measures one pool on one workload and prints its best repetition.
+
+  @return 0 on success, -1 if the pool could not be run
+ */
+int measure(const pool_kind_t *kind, const char *workload, int cores, bench_task_t *tasks, int task_count, int repetitions)
+{
+	double *latency = malloc(task_count * sizeof(double));
+	double best_elapsed = -1, best_mean = 0, best_p50 = 0, best_p99 = 0;
+	int rep, i;
+
+	if (latency == NULL)
+		return -1;
+
+	for (rep = 0; rep < repetitions; rep++)
+	{
+		double elapsed = run_burst(kind, cores, tasks, task_count), total = 0;
+		if (elapsed < 0)
+		{
+			free(latency);
+			return -1;
+		}
+
+		for (i = 0; i < task_count; i++)
+		{
+			latency[i] = (tasks[i].finish_ns - tasks[i].submit_ns) / 1000;
+			total += latency[i];
+		}
+		qsort(latency, task_count, sizeof(double), compare_doubles);
+
+		if (best_elapsed < 0 || elapsed < best_elapsed)
+		{
+			best_elapsed = elapsed;
+			best_mean = total / task_count;
+			best_p50 = latency[task_count / 2];
+			best_p99 = latency[(int)(task_count * 0.99)];
+		}
+	}
+
+	printf("%-6s %-6s %8d %7d %14.0f %14.1f %14.1f %14.1f\n", kind->name, workload, task_count, cores,
+			task_count / (best_elapsed / 1e9), best_mean, best_p50, best_p99);
+	free(latency);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int task_count = 100000, cores = 4, repetitions = 3, c, i;
+	double mean_work = 20;
+
+	while ((c = getopt(argc, argv, "n:c:w:r:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n': task_count = atoi(optarg); break;
+			case 'c': cores = atoi(optarg); break;
+			case 'w': mean_work = atof(optarg); break;
+			case 'r': repetitions = atoi(optarg); break;
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (optind != argc || task_count <= 0 || cores <= 0 || mean_work < 0 || repetitions <= 0)
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	bench_task_t *empty = calloc(task_count, sizeof(bench_task_t));
+	bench_task_t *mixed = calloc(task_count, sizeof(bench_task_t));
+	if (empty == NULL || mixed == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	// The same sizes and priorities for every pool
+	srand(1);
+	for (i = 0; i < task_count; i++)
+	{
+		mixed[i].work = (int)(-mean_work * log(1 - rand() / (RAND_MAX + 1.0)));
+		mixed[i].priority = rand() % 8;
+	}
+
+	printf("%-6s %-6s %8s %7s %14s %14s %14s %14s\n", "pool", "tasks", "count", "workers", "tasks/s", "mean lat us", "p50 lat us", "p99 lat us");
+	for (i = 0; i < COUNT(pools); i++)
+	{
+		if (measure(&pools[i], "empty", cores, empty, task_count, repetitions) != 0
+				|| measure(&pools[i], "mixed", cores, mixed, task_count, repetitions) != 0)
+		{
+			fprintf(stderr, "Unable to run the %s pool.\n", pools[i].name);
+			return 2;
+		}
+	}
+
+	free(empty);
+	free(mixed);
+	return 0;
+}
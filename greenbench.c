@@ -0,0 +1,195 @@
+/** @file greenbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libgreen/libgreen.h"
+
+
+/**
+  Time slices measured, in microseconds; 0 turns preemption off and is the
+  reference the others are compared with.
+*/
+static const int quanta[] = {0, 10000, 1000, 200, 50};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof(array[0])))
+
+/**
+  Work of one CPU-bound green thread.
+*/
+typedef struct _spinner_t
+{
+	long spins;
+	double finish_ns;
+} spinner_t;
+
+/**
+  State shared by the two green threads of the yield test.
+*/
+typedef struct _ping_pong_t
+{
+	int yields;
+} ping_pong_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-w <workers>] [-t <green threads>] [-n <million spins per thread>] [-y <yields>]\n", program_name);
+	fprintf(stderr, "Measures the cost of switching green threads: first by two threads yielding to each other on one\n");
+	fprintf(stderr, "worker, then by CPU-bound threads (default 8 of 20 million spins, on 2 workers) preempted by the\n");
+	fprintf(stderr, "timer at time slices from 10 ms down to 50 us.  For each slice it prints the preemptions, the\n");
+	fprintf(stderr, "mean cost of a switch, the share of the workers' time spent switching and the slowdown of the run\n");
+	fprintf(stderr, "compared with no preemption, which is what the quantum of RR should be sized against.\n");
+}
+
+double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void spin(void *arg)
+{
+	spinner_t *spinner = arg;
+	volatile long i;
+
+	for (i = 0; i < spinner->spins; i++)
+		;
+	spinner->finish_ns = now_ns();
+}
+
+void ping_pong(void *arg)
+{
+	ping_pong_t *state = arg;
+	int i;
+
+	for (i = 0; i < state->yields; i++)
+		green_yield();
+}
+
+/**
+  Measures a voluntary switch: two green threads on one worker yielding to
+  each other.
+
+  @return 0 on success, -1 if the runtime could not be run
+ */
+int measure_yield(int yields)
+{
+	green_runtime_t rt;
+	green_stats_t stats;
+	ping_pong_t state = {yields};
+
+	if (green_init(&rt, 1, 0) != 0)
+		return -1;
+
+	double start = now_ns();
+	if (green_spawn(&rt, ping_pong, &state) != 0 || green_spawn(&rt, ping_pong, &state) != 0)
+		return -1;
+	green_wait(&rt);
+	double elapsed = now_ns() - start;
+
+	green_get_stats(&rt, &stats);
+	green_destroy(&rt);
+
+	printf("Yield: %lu switches, %.0f ns per switch overall, %.0f ns measured from leaving one thread to entering the next\n",
+			stats.m_switches, elapsed / stats.m_switches,
+			stats.m_timed_switches > 0 ? stats.m_switch_ns / stats.m_timed_switches : 0.0);
+	return 0;
+}
+
+/**
+  Runs the CPU-bound threads with one time slice.
+
+  @return the nanoseconds until the last thread finished, or -1 if the runtime could not be run
+ */
+double run_spinners(int workers, int quantum_us, spinner_t *spinners, int count, green_stats_t *stats)
+{
+	green_runtime_t rt;
+	int i;
+
+	if (green_init(&rt, workers, quantum_us) != 0)
+		return -1;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		if (green_spawn(&rt, spin, &spinners[i]) != 0)
+			return -1;
+	green_wait(&rt);
+
+	double end = 0;
+	for (i = 0; i < count; i++)
+		if (spinners[i].finish_ns > end)
+			end = spinners[i].finish_ns;
+
+	green_get_stats(&rt, stats);
+	green_destroy(&rt);
+	return end - start;
+}
+
+int main(int argc, char **argv)
+{
+	int workers = 2, threads = 8, yields = 100000, c, i;
+	double million_spins = 20;
+
+	while ((c = getopt(argc, argv, "w:t:n:y:")) != -1)
+	{
+		switch (c)
+		{
+			case 'w': workers = atoi(optarg); break;
+			case 't': threads = atoi(optarg); break;
+			case 'n': million_spins = atof(optarg); break;
+			case 'y': yields = atoi(optarg); break;
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (optind != argc || workers <= 0 || threads <= 0 || million_spins <= 0 || yields <= 0)
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (measure_yield(yields) != 0)
+	{
+		fprintf(stderr, "Unable to start the green thread runtime.\n");
+		return 2;
+	}
+
+	spinner_t *spinners = calloc(threads, sizeof(spinner_t));
+	double reference = 0;
+
+	printf("\n%10s %10s %12s %12s %16s %14s %10s\n", "quantum us", "wall ms", "preemptions", "switches", "switch ns (mean)", "switching", "slowdown");
+	for (i = 0; i < COUNT(quanta); i++)
+	{
+		green_stats_t stats;
+		int j;
+
+		for (j = 0; j < threads; j++)
+			spinners[j].spins = (long)(million_spins * 1e6);
+
+		double elapsed = run_spinners(workers, quanta[i], spinners, threads, &stats);
+		if (elapsed < 0)
+		{
+			fprintf(stderr, "Unable to start the green thread runtime.\n");
+			return 2;
+		}
+		if (quanta[i] == 0)
+			reference = elapsed;
+
+		// Switching is the share of the workers' time spent between green
+		// threads; slowdown compares the whole run with no preemption, which
+		// also takes in the cache misses of the threads that are switched in
+		printf("%10d %10.1f %12lu %12lu %16.0f %13.2f%% %9.1f%%\n", quanta[i], elapsed / 1e6, stats.m_preemptions, stats.m_switches,
+				stats.m_timed_switches > 0 ? stats.m_switch_ns / stats.m_timed_switches : 0.0,
+				stats.m_switch_ns / (elapsed * workers) * 100, (elapsed / reference - 1) * 100);
+	}
+
+	free(spinners);
+	return 0;
+}
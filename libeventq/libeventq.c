@@ -0,0 +1,160 @@
+/** @file libeventq.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "libeventq.h"
+
+
+/**
+  Returns nonzero if event a must be processed before event b.
+
+  Events are ordered by time, then by type, then by key, so events sharing
+  a time are always delivered in the same order.
+ */
+static int eventq_before(const event_t *a, const event_t *b)
+{
+    if (a->m_time != b->m_time)
+        return a->m_time < b->m_time;
+    if (a->m_type != b->m_type)
+        return a->m_type < b->m_type;
+    return a->m_key < b->m_key;
+}
+
+
+/**
+  Initializes the eventq_t data structure.
+
+  @param q a pointer to an instance of the eventq_t data structure
+  @param capacity the number of events to reserve space for up front
+  @return 0 on success
+  @return -1 if the queue could not be allocated
+ */
+int eventq_init(eventq_t *q, int capacity)
+{
+    if (capacity < 1)
+        capacity = 1;
+
+    q->m_heap = malloc(capacity * sizeof(event_t));
+    q->m_size = 0;
+    q->m_capacity = capacity;
+
+    return (q->m_heap != NULL) ? 0 : -1;
+}
+
+
+/**
+  Inserts an event into the queue in O(log n).
+
+  @param q a pointer to an instance of the eventq_t data structure
+  @param time the time at which the event fires
+  @param type the kind of event; lower types fire first among events with the same time
+  @param key caller-defined identifier (eg: a core or job id); lower keys fire first among equal types
+  @param generation caller-defined stamp used to recognize events that have become stale
+  @return 0 on success
+  @return -1 if the queue could not be grown
+ */
+int eventq_push(eventq_t *q, int time, int type, int key, int generation)
+{
+    if (q->m_size == q->m_capacity) {
+        event_t* heap = realloc(q->m_heap, 2 * q->m_capacity * sizeof(event_t));
+        if (heap == NULL)
+            return -1;
+        q->m_heap = heap;
+        q->m_capacity *= 2;
+    }
+
+    event_t event = { time, type, key, generation };
+    int index = q->m_size++;
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!eventq_before(&event, &q->m_heap[parent]))
+            break;
+        q->m_heap[index] = q->m_heap[parent];
+        index = parent;
+    }
+    q->m_heap[index] = event;
+
+    return 0;
+}
+
+
+/**
+  Retrieves, but does not remove, the earliest event, returning NULL if
+  the queue is empty.
+
+  @param q a pointer to an instance of the eventq_t data structure
+  @return pointer to the earliest event
+  @return NULL if the queue is empty
+ */
+event_t *eventq_peek(eventq_t *q)
+{
+    if (q->m_size == 0)
+        return NULL;
+    return &q->m_heap[0];
+}
+
+
+/**
+  Removes the earliest event from the queue in O(log n).
+
+  @param q a pointer to an instance of the eventq_t data structure
+  @param event receives a copy of the removed event (may be NULL)
+  @return 1 if an event was removed
+  @return 0 if the queue is empty
+ */
+int eventq_pop(eventq_t *q, event_t *event)
+{
+    if (q->m_size == 0)
+        return 0;
+
+    if (event != NULL)
+        *event = q->m_heap[0];
+
+    event_t last = q->m_heap[--q->m_size];
+    int index = 0;
+
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= q->m_size)
+            break;
+        if (child + 1 < q->m_size && eventq_before(&q->m_heap[child + 1], &q->m_heap[child]))
+            child++;
+        if (!eventq_before(&q->m_heap[child], &last))
+            break;
+        q->m_heap[index] = q->m_heap[child];
+        index = child;
+    }
+    if (q->m_size > 0)
+        q->m_heap[index] = last;
+
+    return 1;
+}
+
+
+/**
+  Returns the number of events in the queue.
+
+  @param q a pointer to an instance of the eventq_t data structure
+  @return the number of events in the queue
+ */
+int eventq_size(eventq_t *q)
+{
+    return q->m_size;
+}
+
+
+/**
+  Destroys and frees all the memory associated with q.
+
+  @param q a pointer to an instance of the eventq_t data structure
+ */
+void eventq_destroy(eventq_t *q)
+{
+    free(q->m_heap);
+    q->m_heap = NULL;
+    q->m_size = 0;
+    q->m_capacity = 0;
+}
@@ -0,0 +1,38 @@
+/** @file libeventq.h
+ */
+
+#ifndef LIBEVENTQ_H_
+#define LIBEVENTQ_H_
+
+/**
+  Event Data Structure
+*/
+typedef struct _event_t
+{
+    int m_time;
+    int m_type;
+    int m_key;
+    int m_generation;
+} event_t;
+
+/**
+  Eventq Data Structure
+*/
+typedef struct _eventq_t
+{
+    event_t* m_heap;
+    int m_size;
+    int m_capacity;
+} eventq_t;
+
+
+int       eventq_init   (eventq_t *q, int capacity);
+
+int       eventq_push   (eventq_t *q, int time, int type, int key, int generation);
+event_t * eventq_peek   (eventq_t *q);
+int       eventq_pop    (eventq_t *q, event_t *event);
+int       eventq_size   (eventq_t *q);
+
+void      eventq_destroy(eventq_t *q);
+
+#endif /* LIBEVENTQ_H_ */
@@ -0,0 +1,293 @@
+/** @file libexecutor.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include "libexecutor.h"
+
+/**
+  Slots the task pool starts with.
+*/
+#define EXECUTOR_INITIAL_TASKS 64
+
+
+/**
+  Returns the microseconds elapsed since the executor was started.
+ */
+static double executor_now(executor_t *e)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - e->m_start.tv_sec) * 1e6 + (now.tv_nsec - e->m_start.tv_nsec) / 1e3;
+}
+
+
+/**
+  Returns the key a task is ordered by under the executor's scheme.  Tasks
+  without an estimate run after those with one under SJF and PSJF.
+ */
+static int executor_key(executor_t *e, int priority, int estimate)
+{
+    switch (e->m_scheme) {
+    case SJF:
+    case PSJF:
+        return (estimate == EXECUTOR_NO_ESTIMATE) ? INT_MAX : estimate;
+    case PRI:
+    case PPRI:
+        return priority;
+    default:
+        return 0;
+    }
+}
+
+
+/**
+  Adds slots to the task pool, chaining them onto the free list.
+
+  @return 0 on success
+  @return -1 if the pool could not be grown
+ */
+static int executor_grow(executor_t *e)
+{
+    int i, capacity = (e->m_task_capacity > 0) ? 2 * e->m_task_capacity : EXECUTOR_INITIAL_TASKS;
+
+    executor_task_t* tasks = realloc(e->m_tasks, capacity * sizeof(executor_task_t));
+    if (tasks == NULL)
+        return -1;
+
+    for (i = e->m_task_capacity; i < capacity; i++)
+        tasks[i].m_next_free = (i + 1 < capacity) ? i + 1 : e->m_free_task;
+    e->m_free_task = e->m_task_capacity;
+    e->m_tasks = tasks;
+    e->m_task_capacity = capacity;
+    return 0;
+}
+
+
+/**
+  Body of the worker threads: runs the task at the head of the queue until
+  the executor stops and the queue is empty.
+ */
+static void *executor_worker(void *arg)
+{
+    executor_t* e = arg;
+
+    pthread_mutex_lock(&e->m_lock);
+    for (;;) {
+        while (eventq_size(&e->m_queue) == 0 && !e->m_stopping)
+            pthread_cond_wait(&e->m_ready, &e->m_lock);
+        if (eventq_size(&e->m_queue) == 0)
+            break;
+
+        event_t event;
+        eventq_pop(&e->m_queue, &event);
+        executor_task_t task = e->m_tasks[event.m_generation];
+        e->m_tasks[event.m_generation].m_next_free = e->m_free_task;
+        e->m_free_task = event.m_generation;
+        if (eventq_size(&e->m_queue) == 0)
+            e->m_sequence = 0;
+        pthread_mutex_unlock(&e->m_lock);
+
+        double start_time = executor_now(e);
+        task.m_function(task.m_arg);
+        double finish_time = executor_now(e);
+
+        pthread_mutex_lock(&e->m_lock);
+        e->m_total_waiting_time += start_time - task.m_submit_time;
+        e->m_total_response_time += start_time - task.m_submit_time;
+        e->m_total_turnaround_time += finish_time - task.m_submit_time;
+        e->m_completed++;
+        if (--e->m_outstanding == 0)
+            pthread_cond_broadcast(&e->m_drained);
+    }
+    pthread_mutex_unlock(&e->m_lock);
+
+    return NULL;
+}
+
+
+/**
+  Initializes the executor_t data structure and starts its worker threads.
+
+  @param e a pointer to an instance of the executor_t data structure
+  @param cores the number of worker threads
+  @param scheme the scheme that orders the ready tasks
+  @return 0 on success
+  @return -1 if the executor could not be started
+ */
+int executor_init(executor_t *e, int cores, scheme_t scheme)
+{
+    int i, queued;
+
+    pthread_mutex_init(&e->m_lock, NULL);
+    pthread_cond_init(&e->m_ready, NULL);
+    pthread_cond_init(&e->m_drained, NULL);
+
+    e->m_scheme = scheme;
+    queued = eventq_init(&e->m_queue, EXECUTOR_INITIAL_TASKS);
+    e->m_tasks = NULL;
+    e->m_task_capacity = 0;
+    e->m_free_task = -1;
+    e->m_sequence = 0;
+    e->m_cores = 0;
+    e->m_outstanding = 0;
+    e->m_stopping = 0;
+    clock_gettime(CLOCK_MONOTONIC, &e->m_start);
+
+    e->m_total_waiting_time = 0;
+    e->m_total_turnaround_time = 0;
+    e->m_total_response_time = 0;
+    e->m_completed = 0;
+
+    e->m_workers = malloc(cores * sizeof(pthread_t));
+    if (queued != 0 || e->m_workers == NULL || executor_grow(e) != 0) {
+        executor_destroy(e);
+        return -1;
+    }
+
+    for (i = 0; i < cores; i++) {
+        if (pthread_create(&e->m_workers[i], NULL, executor_worker, e) != 0) {
+            executor_destroy(e);
+            return -1;
+        }
+        e->m_cores++;
+    }
+
+    return 0;
+}
+
+
+/**
+  Queues a task to run on the first worker that becomes free, in the order of
+  the executor's scheme.
+
+  @param e a pointer to an instance of the executor_t data structure
+  @param function the function to run
+  @param arg the argument to pass to function
+  @param priority the priority of the task (the lower the value, the higher the priority)
+  @param estimate the expected run time of the task, in microseconds, or EXECUTOR_NO_ESTIMATE
+  @return 0 on success
+  @return -1 if the executor is stopping or the task could not be queued
+ */
+int executor_submit(executor_t *e, executor_function_t function, void *arg, int priority, int estimate)
+{
+    pthread_mutex_lock(&e->m_lock);
+
+    if (e->m_stopping || (e->m_free_task == -1 && executor_grow(e) != 0)) {
+        pthread_mutex_unlock(&e->m_lock);
+        return -1;
+    }
+
+    int slot = e->m_free_task;
+    executor_task_t* task = &e->m_tasks[slot];
+
+    if (eventq_push(&e->m_queue, executor_key(e, priority, estimate), 0, e->m_sequence, slot) != 0) {
+        pthread_mutex_unlock(&e->m_lock);
+        return -1;
+    }
+
+    e->m_free_task = task->m_next_free;
+    e->m_sequence++;
+    task->m_function = function;
+    task->m_arg = arg;
+    task->m_priority = priority;
+    task->m_estimate = estimate;
+    task->m_submit_time = executor_now(e);
+    e->m_outstanding++;
+
+    pthread_cond_signal(&e->m_ready);
+    pthread_mutex_unlock(&e->m_lock);
+    return 0;
+}
+
+
+/**
+  Waits until every task submitted so far has finished.
+
+  @param e a pointer to an instance of the executor_t data structure
+ */
+void executor_wait(executor_t *e)
+{
+    pthread_mutex_lock(&e->m_lock);
+    while (e->m_outstanding > 0)
+        pthread_cond_wait(&e->m_drained, &e->m_lock);
+    pthread_mutex_unlock(&e->m_lock);
+}
+
+
+/**
+  Returns the average waiting time of the finished tasks, in microseconds:
+  the time from submission until a worker started the task.
+
+  @param e a pointer to an instance of the executor_t data structure
+  @return the average waiting time, or 0 if no task has finished
+ */
+double executor_average_waiting_time(executor_t *e)
+{
+    pthread_mutex_lock(&e->m_lock);
+    double average = (e->m_completed > 0) ? e->m_total_waiting_time / e->m_completed : 0;
+    pthread_mutex_unlock(&e->m_lock);
+    return average;
+}
+
+
+/**
+  Returns the average turnaround time of the finished tasks, in microseconds:
+  the time from submission until the task returned.
+
+  @param e a pointer to an instance of the executor_t data structure
+  @return the average turnaround time, or 0 if no task has finished
+ */
+double executor_average_turnaround_time(executor_t *e)
+{
+    pthread_mutex_lock(&e->m_lock);
+    double average = (e->m_completed > 0) ? e->m_total_turnaround_time / e->m_completed : 0;
+    pthread_mutex_unlock(&e->m_lock);
+    return average;
+}
+
+
+/**
+  Returns the average response time of the finished tasks, in microseconds:
+  the time from submission until the task first ran.  As tasks are never
+  interrupted, this is also their waiting time.
+
+  @param e a pointer to an instance of the executor_t data structure
+  @return the average response time, or 0 if no task has finished
+ */
+double executor_average_response_time(executor_t *e)
+{
+    pthread_mutex_lock(&e->m_lock);
+    double average = (e->m_completed > 0) ? e->m_total_response_time / e->m_completed : 0;
+    pthread_mutex_unlock(&e->m_lock);
+    return average;
+}
+
+
+/**
+  Runs the tasks still queued, stops the worker threads and frees all memory
+  associated with the executor.
+
+  @param e a pointer to an instance of the executor_t data structure
+ */
+void executor_destroy(executor_t *e)
+{
+    int i;
+
+    pthread_mutex_lock(&e->m_lock);
+    e->m_stopping = 1;
+    pthread_cond_broadcast(&e->m_ready);
+    pthread_mutex_unlock(&e->m_lock);
+
+    for (i = 0; i < e->m_cores; i++)
+        pthread_join(e->m_workers[i], NULL);
+
+    eventq_destroy(&e->m_queue);
+    free(e->m_tasks);
+    free(e->m_workers);
+    pthread_cond_destroy(&e->m_ready);
+    pthread_cond_destroy(&e->m_drained);
+    pthread_mutex_destroy(&e->m_lock);
+}
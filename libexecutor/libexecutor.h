@@ -0,0 +1,88 @@
+/** @file libexecutor.h
+ */
+
+#ifndef LIBEXECUTOR_H_
+#define LIBEXECUTOR_H_
+
+#include <pthread.h>
+#include <time.h>
+
+#include "../libscheduler/libscheduler.h"
+#include "../libeventq/libeventq.h"
+
+/**
+  A task's run-time estimate when the caller has none.
+*/
+#define EXECUTOR_NO_ESTIMATE -1
+
+/**
+  Function run by a task
+*/
+typedef void (*executor_function_t)(void *arg);
+
+/**
+  Task Data Structure
+
+  A closure waiting in, or taken from, the ready queue.  Times are in
+  microseconds since the executor was started.
+*/
+typedef struct _executor_task_t
+{
+    executor_function_t m_function;
+    void* m_arg;
+    int m_priority;
+    int m_estimate;
+    double m_submit_time;
+    int m_next_free;    // next unused slot, while this one is unused
+} executor_task_t;
+
+/**
+  Executor Data Structure
+
+  Runs closures on a pool of worker threads, one per core, in the order of a
+  scheduling scheme.  Ready tasks wait on a heap ordered by the scheme's key
+  (nothing for FCFS and RR, the run-time estimate for SJF and PSJF, the
+  priority for PRI and PPRI) and then by submission order.  A running task is
+  never interrupted, so the preemptive schemes order the queue like their
+  non-preemptive counterparts and RR runs tasks in arrival order.
+
+  Tasks are kept in m_tasks, a pool of slots recycled through a free list;
+  the heap holds slot indices.
+*/
+typedef struct _executor_t
+{
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_ready;     // signalled when a task is queued or the executor stops
+    pthread_cond_t m_drained;   // signalled when the last outstanding task finishes
+
+    scheme_t m_scheme;
+    eventq_t m_queue;
+    executor_task_t* m_tasks;
+    int m_task_capacity, m_free_task;
+    int m_sequence;             // submission order, restarted whenever the queue empties
+
+    pthread_t* m_workers;
+    int m_cores;
+    int m_outstanding;          // tasks submitted and not yet finished
+    int m_stopping;
+    struct timespec m_start;
+
+    double m_total_waiting_time;
+    double m_total_turnaround_time;
+    double m_total_response_time;
+    unsigned long m_completed;
+} executor_t;
+
+
+int    executor_init                   (executor_t *e, int cores, scheme_t scheme);
+
+int    executor_submit                 (executor_t *e, executor_function_t function, void *arg, int priority, int estimate);
+void   executor_wait                   (executor_t *e);
+
+double executor_average_waiting_time   (executor_t *e);
+double executor_average_turnaround_time(executor_t *e);
+double executor_average_response_time  (executor_t *e);
+
+void   executor_destroy                (executor_t *e);
+
+#endif /* LIBEXECUTOR_H_ */
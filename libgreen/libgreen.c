@@ -0,0 +1,440 @@
+/** @file libgreen.c
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "libgreen.h"
+
+/**
+  Signal the workers' timers send when a quantum expires.
+*/
+#define GREEN_PREEMPT_SIGNAL SIGRTMIN
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+//The worker running on this kernel thread, or NULL
+static __thread green_worker_t *green_current_worker;
+
+
+/**
+  Returns the worker of the calling kernel thread.  A green thread can resume
+  on another kernel thread than it left, so the worker is looked up afresh,
+  never kept across a switch.
+ */
+static __attribute__((noinline)) green_worker_t *green_self()
+{
+    return green_current_worker;
+}
+
+
+static double green_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static void green_block(sigset_t *saved)
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, GREEN_PREEMPT_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &set, saved);
+}
+
+
+/**
+  Accounts for a green thread resuming on the calling worker.
+ */
+static void green_entered()
+{
+    green_worker_t* w = green_self();
+
+    if (w->m_left_at > 0) {
+        w->m_stats.m_switch_ns += green_now_ns() - w->m_left_at;
+        w->m_stats.m_timed_switches++;
+    }
+}
+
+
+/**
+  Handler of the timer signal: switches the running green thread out.  It
+  runs on the green thread's stack, which keeps the frame until the thread
+  resumes and the handler returns to where it was interrupted.
+ */
+static void green_preempt(int signal)
+{
+    green_worker_t* w = green_self();
+    green_thread_t* t = (w != NULL) ? w->m_current : NULL;
+
+    if (t == NULL)
+        return;
+
+    w->m_left_at = green_now_ns();
+    w->m_stats.m_preemptions++;
+    swapcontext(&t->m_context, &w->m_context);
+    green_entered();
+}
+
+
+/**
+  Entry point of every green thread.
+
+  Green threads are always switched to with the timer signal blocked, and
+  unblock it themselves once they run: a mask unblocked by swapcontext()
+  would let the signal in before the switch is complete, while the worker
+  still runs on its own stack.
+ */
+static void green_start()
+{
+    green_entered();
+    green_preempt_enable();
+
+    green_thread_t* t = green_self()->m_current;
+    t->m_function(t->m_arg);
+
+    green_block(NULL);
+    green_worker_t* w = green_self();
+    t->m_finished = 1;
+    w->m_left_at = green_now_ns();
+    setcontext(&w->m_context);
+}
+
+
+/**
+  Starts or stops the worker's timer.
+
+  @param w the worker
+  @param quantum_us microseconds until the timer fires, or 0 to stop it
+ */
+static void green_arm(green_worker_t *w, int quantum_us)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = quantum_us / 1000000;
+    spec.it_value.tv_nsec = (quantum_us % 1000000) * 1000L;
+    timer_settime(w->m_timer, 0, &spec, NULL);
+}
+
+
+/**
+  Body of the worker threads: runs the green thread at the head of the run
+  queue for a quantum, or until it yields or finishes, until the runtime
+  stops and no green thread is left.  The timer signal is blocked except
+  while a green thread runs.
+ */
+static void *green_worker(void *arg)
+{
+    green_worker_t* w = arg;
+    green_runtime_t* rt = w->m_runtime;
+    sigset_t preempt_set;
+
+    green_block(NULL);
+    sigemptyset(&preempt_set);
+    sigaddset(&preempt_set, GREEN_PREEMPT_SIGNAL);
+    green_current_worker = w;
+
+    if (rt->m_quantum_us > 0) {
+        struct sigevent event;
+
+        // CPU-time clocks only advance on the kernel's scheduler tick, too
+        // coarsely for short quanta, so the slice is measured in real time
+        memset(&event, 0, sizeof(event));
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = GREEN_PREEMPT_SIGNAL;
+        event.sigev_notify_thread_id = syscall(SYS_gettid);
+        w->m_has_timer = timer_create(CLOCK_MONOTONIC, &event, &w->m_timer) == 0;
+    }
+
+    pthread_mutex_lock(&rt->m_lock);
+    for (;;) {
+        if (rt->m_head == NULL && !rt->m_stopping) {
+            // Time spent waiting for work is not switching
+            w->m_left_at = 0;
+            while (rt->m_head == NULL && !rt->m_stopping)
+                pthread_cond_wait(&rt->m_ready, &rt->m_lock);
+        }
+        if (rt->m_head == NULL)
+            break;
+
+        green_thread_t* t = rt->m_head;
+        rt->m_head = t->m_next;
+        if (rt->m_head == NULL)
+            rt->m_tail = NULL;
+        pthread_mutex_unlock(&rt->m_lock);
+
+        w->m_current = t;
+        if (w->m_has_timer)
+            green_arm(w, rt->m_quantum_us);
+        swapcontext(&w->m_context, &t->m_context);
+
+        if (w->m_has_timer) {
+            // A quantum that ran out as the thread left must not cut the next one short
+            struct timespec zero = {0, 0};
+            green_arm(w, 0);
+            sigtimedwait(&preempt_set, NULL, &zero);
+        }
+        w->m_current = NULL;
+        w->m_stats.m_switches++;
+
+        pthread_mutex_lock(&rt->m_lock);
+        if (t->m_finished) {
+            free(t->m_stack);
+            free(t);
+            if (--rt->m_live == 0)
+                pthread_cond_broadcast(&rt->m_drained);
+        } else {
+            t->m_next = NULL;
+            if (rt->m_tail != NULL)
+                rt->m_tail->m_next = t;
+            else
+                rt->m_head = t;
+            rt->m_tail = t;
+        }
+    }
+    pthread_mutex_unlock(&rt->m_lock);
+
+    if (w->m_has_timer)
+        timer_delete(w->m_timer);
+    green_current_worker = NULL;
+    return NULL;
+}
+
+
+/**
+  Initializes the green_runtime_t data structure and starts its workers.
+
+  @param rt a pointer to an instance of the green_runtime_t data structure
+  @param workers the number of kernel threads green threads run on
+  @param quantum_us the time slice of a green thread, in microseconds, or 0 for no preemption
+  @return 0 on success
+  @return -1 if the runtime could not be started
+ */
+int green_init(green_runtime_t *rt, int workers, int quantum_us)
+{
+    struct sigaction action;
+    int i;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = green_preempt;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(GREEN_PREEMPT_SIGNAL, &action, NULL) != 0)
+        return -1;
+
+    pthread_mutex_init(&rt->m_lock, NULL);
+    pthread_cond_init(&rt->m_ready, NULL);
+    pthread_cond_init(&rt->m_drained, NULL);
+    rt->m_head = rt->m_tail = NULL;
+    rt->m_live = 0;
+    rt->m_stopping = 0;
+    rt->m_quantum_us = quantum_us;
+    rt->m_worker_count = 0;
+
+    rt->m_workers = calloc(workers, sizeof(green_worker_t));
+    if (rt->m_workers == NULL) {
+        green_destroy(rt);
+        return -1;
+    }
+
+    for (i = 0; i < workers; i++) {
+        rt->m_workers[i].m_runtime = rt;
+        if (pthread_create(&rt->m_workers[i].m_thread, NULL, green_worker, &rt->m_workers[i]) != 0) {
+            green_destroy(rt);
+            return -1;
+        }
+        rt->m_worker_count++;
+    }
+
+    return 0;
+}
+
+
+/**
+  Sets up the context a green thread starts in: green_start() on the given
+  stack, with the caller's signal mask, in which the timer signal is blocked.
+
+  @return 0 on success, -1 on failure
+ */
+static int green_make_context(green_thread_t *t, void *stack)
+{
+    if (getcontext(&t->m_context) != 0)
+        return -1;
+
+    t->m_context.uc_stack.ss_sp = stack;
+    t->m_context.uc_stack.ss_size = GREEN_STACK_SIZE;
+    t->m_context.uc_link = NULL;
+    pthread_sigmask(SIG_SETMASK, NULL, &t->m_context.uc_sigmask);
+    makecontext(&t->m_context, green_start, 0);
+    return 0;
+}
+
+
+/**
+  Creates a green thread and queues it to run.  Green threads may spawn
+  further green threads.
+
+  @param rt a pointer to an instance of the green_runtime_t data structure
+  @param function the function the green thread runs
+  @param arg the argument to pass to function
+  @return 0 on success
+  @return -1 if the runtime is stopping or the green thread could not be created
+ */
+int green_spawn(green_runtime_t *rt, green_function_t function, void *arg)
+{
+    sigset_t saved;
+    int result = -1;
+
+    green_block(&saved);
+
+    green_thread_t* t = malloc(sizeof(green_thread_t));
+    void* stack = malloc(GREEN_STACK_SIZE);
+    if (t != NULL && stack != NULL && green_make_context(t, stack) == 0) {
+        t->m_stack = stack;
+        t->m_function = function;
+        t->m_arg = arg;
+        t->m_finished = 0;
+        t->m_next = NULL;
+
+        pthread_mutex_lock(&rt->m_lock);
+        if (!rt->m_stopping) {
+            if (rt->m_tail != NULL)
+                rt->m_tail->m_next = t;
+            else
+                rt->m_head = t;
+            rt->m_tail = t;
+            rt->m_live++;
+            pthread_cond_signal(&rt->m_ready);
+            result = 0;
+        }
+        pthread_mutex_unlock(&rt->m_lock);
+    }
+
+    if (result != 0) {
+        free(t);
+        free(stack);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    return result;
+}
+
+
+/**
+  Gives up the rest of the calling green thread's quantum, moving it to the
+  back of the run queue.  Outside a green thread this does nothing.
+ */
+void green_yield()
+{
+    sigset_t saved;
+
+    green_block(&saved);
+
+    green_worker_t* w = green_self();
+    if (w != NULL && w->m_current != NULL) {
+        green_thread_t* t = w->m_current;
+        w->m_left_at = green_now_ns();
+        w->m_stats.m_yields++;
+        swapcontext(&t->m_context, &w->m_context);
+        green_entered();
+    }
+
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+}
+
+
+/**
+  Stops the calling green thread from being preempted until
+  green_preempt_enable() is called.  A quantum that expires meanwhile ends
+  as soon as preemption is enabled again.
+ */
+void green_preempt_disable()
+{
+    green_block(NULL);
+}
+
+
+/**
+  Lets the calling green thread be preempted again.
+ */
+void green_preempt_enable()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, GREEN_PREEMPT_SIGNAL);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+}
+
+
+/**
+  Waits until every green thread spawned so far has finished.  This must not
+  be called from a green thread.
+
+  @param rt a pointer to an instance of the green_runtime_t data structure
+ */
+void green_wait(green_runtime_t *rt)
+{
+    pthread_mutex_lock(&rt->m_lock);
+    while (rt->m_live > 0)
+        pthread_cond_wait(&rt->m_drained, &rt->m_lock);
+    pthread_mutex_unlock(&rt->m_lock);
+}
+
+
+/**
+  Returns the switch counters of all the workers, summed.  They are exact
+  once green_wait() has returned.
+
+  @param rt a pointer to an instance of the green_runtime_t data structure
+  @param stats set to the counters
+ */
+void green_get_stats(green_runtime_t *rt, green_stats_t *stats)
+{
+    int i;
+
+    memset(stats, 0, sizeof(green_stats_t));
+    for (i = 0; i < rt->m_worker_count; i++) {
+        green_stats_t* w = &rt->m_workers[i].m_stats;
+        stats->m_switches += w->m_switches;
+        stats->m_preemptions += w->m_preemptions;
+        stats->m_yields += w->m_yields;
+        stats->m_timed_switches += w->m_timed_switches;
+        stats->m_switch_ns += w->m_switch_ns;
+    }
+}
+
+
+/**
+  Runs the green threads still queued, stops the workers and frees all
+  memory associated with the runtime.  This must not be called from a green
+  thread.
+
+  @param rt a pointer to an instance of the green_runtime_t data structure
+ */
+void green_destroy(green_runtime_t *rt)
+{
+    int i;
+
+    pthread_mutex_lock(&rt->m_lock);
+    rt->m_stopping = 1;
+    pthread_cond_broadcast(&rt->m_ready);
+    pthread_mutex_unlock(&rt->m_lock);
+
+    for (i = 0; i < rt->m_worker_count; i++)
+        pthread_join(rt->m_workers[i].m_thread, NULL);
+
+    free(rt->m_workers);
+    pthread_cond_destroy(&rt->m_ready);
+    pthread_cond_destroy(&rt->m_drained);
+    pthread_mutex_destroy(&rt->m_lock);
+}
@@ -0,0 +1,106 @@
+/** @file libgreen.h
+ */
+
+#ifndef LIBGREEN_H_
+#define LIBGREEN_H_
+
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+
+/**
+  Stack size of each green thread.
+*/
+#define GREEN_STACK_SIZE (64 * 1024)
+
+/**
+  Function run by a green thread
+*/
+typedef void (*green_function_t)(void *arg);
+
+/**
+  Green Thread Data Structure
+*/
+typedef struct _green_thread_t
+{
+    ucontext_t m_context;
+    void* m_stack;
+    green_function_t m_function;
+    void* m_arg;
+    int m_finished;
+    struct _green_thread_t* m_next;     // next thread in the run queue
+} green_thread_t;
+
+/**
+  Counters of the switches made by a runtime
+*/
+typedef struct _green_stats_t
+{
+    unsigned long m_switches;       // green threads taken off a worker, for any reason
+    unsigned long m_preemptions;    // taken off by the timer
+    unsigned long m_yields;         // taken off by green_yield()
+    unsigned long m_timed_switches; // switches whose cost was measured
+    double m_switch_ns;             // total time from leaving one green thread to entering the next
+} green_stats_t;
+
+/**
+  Worker Data Structure
+
+  A kernel thread that runs green threads.  While a green thread runs, the
+  worker's timer counts down the quantum; when it
+  expires, the timer's signal switches back to the worker, which puts the
+  green thread at the back of the run queue.
+*/
+typedef struct _green_worker_t
+{
+    struct _green_runtime_t* m_runtime;
+    pthread_t m_thread;
+    ucontext_t m_context;           // the worker's own loop, switched back to
+    green_thread_t* m_current;
+    timer_t m_timer;
+    int m_has_timer;
+    double m_left_at;               // when the last green thread left, or 0 if unknown
+    green_stats_t m_stats;
+} green_worker_t;
+
+/**
+  Runtime Data Structure
+
+  Green threads multiplexed round robin over a few worker threads, taken
+  from one shared run queue.  Every worker starts a green thread with a
+  fresh quantum; a green thread preempted on one worker may resume on
+  another.
+
+  Preemption is asynchronous, so a green thread can be switched out
+  anywhere, including inside library calls that take locks, such as
+  malloc() and printf().  Such calls should be bracketed by
+  green_preempt_disable() and green_preempt_enable().
+*/
+typedef struct _green_runtime_t
+{
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_ready;         // signalled when a green thread is queued or the runtime stops
+    pthread_cond_t m_drained;       // signalled when the last green thread finishes
+    green_thread_t *m_head, *m_tail;
+    int m_live;                     // green threads spawned and not yet finished
+    int m_stopping;
+
+    int m_quantum_us;
+    green_worker_t* m_workers;
+    int m_worker_count;
+} green_runtime_t;
+
+
+int  green_init           (green_runtime_t *rt, int workers, int quantum_us);
+
+int  green_spawn          (green_runtime_t *rt, green_function_t function, void *arg);
+void green_yield          ();
+void green_preempt_disable();
+void green_preempt_enable ();
+void green_wait           (green_runtime_t *rt);
+void green_get_stats      (green_runtime_t *rt, green_stats_t *stats);
+
+void green_destroy        (green_runtime_t *rt);
+
+#endif /* LIBGREEN_H_ */
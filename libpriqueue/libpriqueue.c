@@ -22,6 +22,8 @@ void priqueue_init(priqueue_t *q, int(*comparer)(const void *, const void *))
     q->m_front = NULL;
     q->m_size = 0;
     q->m_comparer = comparer;
+    q->m_stats.m_comparisons = 0;
+    q->m_stats.m_allocations = 0;
 }
 
 
@@ -36,6 +38,7 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 {
     if(q->m_size == 0) {
        Node* temp = malloc(sizeof(Node));
+       q->m_stats.m_allocations++;
        temp->m_value = ptr;
        temp->m_next = NULL;
        q->m_front = temp;
@@ -44,6 +47,7 @@ int priqueue_offer(priqueue_t *q, void *ptr)
     }
     else {
         Node* new = malloc(sizeof(Node));
+        q->m_stats.m_allocations++;
         new->m_value = ptr;
         new->m_next = NULL;
         
@@ -55,6 +59,7 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 
         int index = 0;
         while(temp->m_next != NULL) {
+        	q->m_stats.m_comparisons++;
         	if(q->m_comparer(temp->m_value, (temp->m_next)->m_value) > 0) {
         		void* tempValue = (temp->m_next)->m_value;
         		(temp->m_next)->m_value = temp->m_value;
@@ -240,6 +245,21 @@ int priqueue_size(priqueue_t *q)
 }
 
 
+/**
+  Returns the counters of the work q has done since it was initialized.
+
+  The counters are plain increments on the paths that do the work, cheap
+  enough to be always on.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param stats set to the counters of q
+ */
+void priqueue_get_stats(priqueue_t *q, priqueue_stats_t *stats)
+{
+	*stats = q->m_stats;
+}
+
+
 /**
   Destroys and frees all the memory associated with q.
   
@@ -12,6 +12,15 @@ typedef struct Node {
     struct Node* m_next;
 } Node;
 
+/**
+  Counters of the work done by a priqueue, kept as it runs
+*/
+typedef struct _priqueue_stats_t
+{
+    unsigned long m_comparisons;  // calls to the comparer
+    unsigned long m_allocations;  // nodes allocated
+} priqueue_stats_t;
+
 /**
   Priqueue Data Structure
 */
@@ -20,6 +29,7 @@ typedef struct _priqueue_t
     Node* m_front;
     int m_size;
     int (*m_comparer) (const void* a, const void* b);
+    priqueue_stats_t m_stats;
 } priqueue_t;
 
 
@@ -32,6 +42,7 @@ void * priqueue_at       (priqueue_t *q, int index);
 int    priqueue_remove   (priqueue_t *q, void *ptr);
 void * priqueue_remove_at(priqueue_t *q, int index);
 int    priqueue_size     (priqueue_t *q);
+void   priqueue_get_stats(priqueue_t *q, priqueue_stats_t *stats);
 
 void   priqueue_destroy  (priqueue_t *q);
 
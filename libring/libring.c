@@ -0,0 +1,108 @@
+/** @file libring.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libring.h"
+
+
+/**
+  Initializes the ring_t data structure.
+
+  @param r a pointer to an instance of the ring_t data structure
+  @param capacity the number of elements the ring holds, rounded up to a power of two
+  @param element_size the size of each element in bytes
+  @return 0 on success
+  @return -1 if the ring could not be allocated
+ */
+int ring_init(ring_t *r, size_t capacity, size_t element_size)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    atomic_init(&r->m_head, 0);
+    atomic_init(&r->m_tail, 0);
+    r->m_tail_cache = 0;
+    r->m_head_cache = 0;
+    r->m_capacity = size;
+    r->m_element_size = element_size;
+    r->m_buffer = malloc(size * element_size);
+
+    return (r->m_buffer != NULL) ? 0 : -1;
+}
+
+
+/**
+  Appends an element.  Only the producer thread may call this.
+
+  @param r a pointer to an instance of the ring_t data structure
+  @param element a pointer to the element to copy into the ring
+  @return 0 on success
+  @return -1 if the ring is full
+ */
+int ring_push(ring_t *r, const void *element)
+{
+    size_t head = atomic_load_explicit(&r->m_head, memory_order_relaxed);
+
+    if (head - r->m_tail_cache == r->m_capacity) {
+        r->m_tail_cache = atomic_load_explicit(&r->m_tail, memory_order_acquire);
+        if (head - r->m_tail_cache == r->m_capacity)
+            return -1;
+    }
+
+    memcpy(r->m_buffer + (head & (r->m_capacity - 1)) * r->m_element_size, element, r->m_element_size);
+    atomic_store_explicit(&r->m_head, head + 1, memory_order_release);
+    return 0;
+}
+
+
+/**
+  Removes the oldest element.  Only the consumer thread may call this.
+
+  @param r a pointer to an instance of the ring_t data structure
+  @param element a pointer to where the element is copied
+  @return 0 on success
+  @return -1 if the ring is empty
+ */
+int ring_pop(ring_t *r, void *element)
+{
+    size_t tail = atomic_load_explicit(&r->m_tail, memory_order_relaxed);
+
+    if (tail == r->m_head_cache) {
+        r->m_head_cache = atomic_load_explicit(&r->m_head, memory_order_acquire);
+        if (tail == r->m_head_cache)
+            return -1;
+    }
+
+    memcpy(element, r->m_buffer + (tail & (r->m_capacity - 1)) * r->m_element_size, r->m_element_size);
+    atomic_store_explicit(&r->m_tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+
+/**
+  Returns the number of elements the ring can hold.
+
+  @param r a pointer to an instance of the ring_t data structure
+  @return the capacity of the ring
+ */
+size_t ring_capacity(ring_t *r)
+{
+    return r->m_capacity;
+}
+
+
+/**
+  Frees all the memory associated with the ring.  Neither thread may use it
+  afterwards.
+
+  @param r a pointer to an instance of the ring_t data structure
+ */
+void ring_destroy(ring_t *r)
+{
+    free(r->m_buffer);
+    r->m_buffer = NULL;
+}
@@ -0,0 +1,42 @@
+/** @file libring.h
+ */
+
+#ifndef LIBRING_H_
+#define LIBRING_H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define RING_CACHE_LINE 64
+
+/**
+  Ring Data Structure
+
+  A bounded, lock-free queue of fixed-size elements for exactly one producer
+  thread and one consumer thread.  Each side owns one index and keeps a
+  cached copy of the other's, so the shared cache lines are only touched when
+  the ring looks full (producer) or empty (consumer).
+*/
+typedef struct _ring_t
+{
+    _Alignas(RING_CACHE_LINE) atomic_size_t m_head;   // next slot to write; written by the producer
+    size_t m_tail_cache;                               // producer's last view of m_tail
+
+    _Alignas(RING_CACHE_LINE) atomic_size_t m_tail;   // next slot to read; written by the consumer
+    size_t m_head_cache;                               // consumer's last view of m_head
+
+    _Alignas(RING_CACHE_LINE) char* m_buffer;
+    size_t m_capacity;
+    size_t m_element_size;
+} ring_t;
+
+
+int    ring_init    (ring_t *r, size_t capacity, size_t element_size);
+
+int    ring_push    (ring_t *r, const void *element);
+int    ring_pop     (ring_t *r, void *element);
+size_t ring_capacity(ring_t *r);
+
+void   ring_destroy (ring_t *r);
+
+#endif /* LIBRING_H_ */
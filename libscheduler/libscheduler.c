@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "libscheduler.h"
 #include "../libpriqueue/libpriqueue.h"
@@ -24,15 +25,58 @@ typedef struct _job_t {
 	int pause_time;
 	int idle_time;
 	int remaining_time;
+
+	//Jobs that block are queued again by the time they woke, so their first arrival and start are kept
+	int submit_time;
+	int first_start_time;  //-1 until the job first blocks
+	int blocked_time;
 } job_t;
 
-//Global variables
-priqueue_t *job_queue;
-scheme_t current_scheduling_scheme;
-int total_waiting_time;
-int total_turnaround_time;
-int total_response_time;
-int total_number_of_jobs;
+//The instance used by the functions without the _r suffix
+static scheduler_t default_scheduler;
+
+//Shard each thread tried first on its last scheduler_mt_new_job(), plus one, and the instance it
+//belongs to; a thread calling another instance starts over on that instance's shards
+static __thread unsigned int scheduler_mt_hint;
+static __thread scheduler_mt_t *scheduler_mt_hint_owner;
+
+//Adds the queue depth held since the last call to the time-weighted total, in whole
+//job-time units; the size is read off the queue rather than through a call
+static void scheduler_account_time(scheduler_t *scheduler, int time) {
+	if (scheduler->m_first_time == -1) {
+		scheduler->m_first_time = time;
+	} else {
+		scheduler->m_depth_area += (long long) scheduler->m_job_queue->m_size
+				* (time - scheduler->m_last_time);
+	}
+	scheduler->m_last_time = time;
+}
+
+//Records that core_id was given job_number (-1 if it was left idle)
+static void scheduler_account_dispatch(scheduler_t *scheduler, int core_id, int job_number) {
+	if (core_id < 0 || core_id >= scheduler->m_stats.m_cores) {
+		return;
+	}
+
+	int previous_job = scheduler->m_core_job[core_id];
+	if (job_number != previous_job) {
+		if (previous_job != -1) {
+			scheduler->m_stats.m_preemptions++;
+		}
+		if (job_number != -1) {
+			scheduler->m_stats.m_context_switches[core_id]++;
+		}
+		scheduler->m_core_job[core_id] = job_number;
+	}
+}
+
+//Raises the maximum queue depth; only needed after a job was queued, as the other calls never grow the queue
+static void scheduler_account_depth(scheduler_t *scheduler) {
+	int depth = scheduler->m_job_queue->m_size;
+	if (depth > scheduler->m_stats.m_max_queue_depth) {
+		scheduler->m_stats.m_max_queue_depth = depth;
+	}
+}
 
 /**
  Initalizes the scheduler.
@@ -43,66 +87,65 @@ int total_number_of_jobs;
  - You may assume that cores is a positive, non-zero number.
  - You may assume that scheme is a valid scheduling scheme.
 
+ @param scheduler the scheduler instance.
  @param cores the number of cores that is available by the scheduler. These cores will be known as core(id=0), core(id=1), ..., core(id=cores-1).
  @param scheme  the scheduling scheme that should be used. This value will be one of the six enum values of scheme_t
  */
-void scheduler_start_up(int cores, scheme_t scheme) {
+void scheduler_start_up_r(scheduler_t *scheduler, int cores, scheme_t scheme) {
 
 	//Set global variables
-	current_scheduling_scheme = scheme;
-	total_waiting_time = 0;
-	total_turnaround_time = 0;
-	total_response_time = 0;
-	total_number_of_jobs = 0;
+	scheduler->m_scheme = scheme;
+	scheduler->m_total_waiting_time = 0;
+	scheduler->m_total_turnaround_time = 0;
+	scheduler->m_total_response_time = 0;
+	scheduler->m_total_number_of_jobs = 0;
+
+	memset(&scheduler->m_stats, 0, sizeof(scheduler_stats_t));
+	scheduler->m_stats.m_cores = cores;
+	scheduler->m_stats.m_context_switches = calloc(cores, sizeof(unsigned long));
+	scheduler->m_core_job = malloc(cores * sizeof(int));
+	for (int i = 0; i < cores; i++) {
+		scheduler->m_core_job[i] = -1;
+	}
+	scheduler->m_first_time = -1;
+	scheduler->m_last_time = -1;
+	scheduler->m_depth_area = 0;
 
-	job_queue = malloc(sizeof(priqueue_t));
+	scheduler->m_job_queue = malloc(sizeof(priqueue_t));
+	scheduler->m_blocked_jobs = malloc(sizeof(priqueue_t));
+	priqueue_init(scheduler->m_blocked_jobs, compare_RR);
 
 	switch (scheme) {
 	case FCFS:
-		priqueue_init(job_queue, compare_FCFS);
+		priqueue_init(scheduler->m_job_queue, compare_FCFS);
 		break;
 	case SJF:
-		priqueue_init(job_queue, compare_SJF);
+		priqueue_init(scheduler->m_job_queue, compare_SJF);
 		break;
 	case PSJF:
-		priqueue_init(job_queue, compare_PSJF);
+		priqueue_init(scheduler->m_job_queue, compare_PSJF);
 		break;
 	case PRI:
-		priqueue_init(job_queue, compare_PRI);
+		priqueue_init(scheduler->m_job_queue, compare_PRI);
 		break;
 	case PPRI:
-		priqueue_init(job_queue, compare_PPRI);
+		priqueue_init(scheduler->m_job_queue, compare_PPRI);
 		break;
 	case RR:
-		priqueue_init(job_queue, compare_RR);
+		priqueue_init(scheduler->m_job_queue, compare_RR);
 		break;
 	}
 }
 
-/**
- Called when a new job arrives.
+static int scheduler_decide_offer(scheduler_t *scheduler, job_t *new_job, int time);
+static int scheduler_find_job(priqueue_t *queue, int job_number);
 
- If multiple cores are idle, the job should be assigned to the core with the
- lowest id.
- If the job arriving should be scheduled to run during the next
- time cycle, return the zero-based index of the core the job should be
- scheduled on. If another job is already running on the core specified,
- this will preempt the currently running job.
- Assumptions:
- - You may assume that every job wil have a unique arrival time.
-
- @param job_number a globally unique identification number of the job arriving.
- @param time the current time of the simulator.
- @param running_time the total number of time units this job will run before it will be finished.
- @param priority the priority of the job. (The lower the value, the higher the priority.)
- @return index of core job should be scheduled on
- @return -1 if no scheduling changes should be made.
-
- */
-int scheduler_new_job(int job_number, int time, int running_time, int priority) {
+//Decides what happens when a new job arrives; see scheduler_new_job_r()
+static int scheduler_decide_new_job(scheduler_t *scheduler, int job_number, int time, int running_time, int priority) {
 	//Create struct object and populate the members
 	job_t *new_job;
 	new_job = malloc(sizeof(job_t));
+	scheduler->m_stats.m_job_allocations++;
 
 	new_job->job_number = job_number;
 	new_job->running_time = running_time;
@@ -110,12 +153,20 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 
 	new_job->arrival_time = time;
 	new_job->remaining_time = running_time;
+	new_job->submit_time = time;
+	new_job->first_start_time = -1;
+	new_job->blocked_time = 0;
 
 	//Set global variables
-	total_number_of_jobs++;
+	scheduler->m_total_number_of_jobs++;
 
+	return scheduler_decide_offer(scheduler, new_job, time);
+}
+
+//Decides whether a job that is ready, new or woken, runs now; see scheduler_new_job_r()
+static int scheduler_decide_offer(scheduler_t *scheduler, job_t *new_job, int time) {
 	//Gather info job queue info
-	job_t* peek_job = priqueue_at(job_queue, 0);
+	job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 	if (peek_job != NULL) {
 		if (peek_job->init_start_time == time) {
 			peek_job->init_start_time = -1;
@@ -125,26 +176,28 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 				- (peek_job->start_time);
 	}
 
+#ifdef DEBUG
 	//******delete********
 	printf(
 			ANSI_COLOR_YELLOW"******** scheduler_new_job: Elements in jobs queue : ");
-	for (int i = 0; i < priqueue_size(job_queue); i++)
-		printf("%d ", *((int *) priqueue_at(job_queue, i)));
+	for (int i = 0; i < priqueue_size(scheduler->m_job_queue); i++)
+		printf("%d ", *((int *) priqueue_at(scheduler->m_job_queue, i)));
 	printf("*********"ANSI_COLOR_RESET"\n");
 	//^^^^^^delete^^^^^^^^
+#endif
 
 	//Main decision to schedule
-	if (current_scheduling_scheme == FCFS || current_scheduling_scheme == SJF
-			|| current_scheduling_scheme == PRI) {
-		priqueue_offer(job_queue, new_job);
+	if (scheduler->m_scheme == FCFS || scheduler->m_scheme == SJF
+			|| scheduler->m_scheme == PRI) {
+		priqueue_offer(scheduler->m_job_queue, new_job);
 		if (peek_job == NULL) {
 			new_job->start_time = time;
 			return 0;
 		} else {
 			return -1;
 		}
-	} else if (current_scheduling_scheme == PSJF) {
-		priqueue_offer(job_queue, new_job);
+	} else if (scheduler->m_scheme == PSJF) {
+		priqueue_offer(scheduler->m_job_queue, new_job);
 		if (peek_job == NULL) {
 			new_job->init_start_time = time;
 			new_job->start_time = time;
@@ -172,9 +225,9 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 			new_job->idle_time = 0;
 			return -1;
 		}
-	} else if (current_scheduling_scheme == PPRI) {
+	} else if (scheduler->m_scheme == PPRI) {
 
-		priqueue_offer(job_queue, new_job);
+		priqueue_offer(scheduler->m_job_queue, new_job);
 		if (peek_job == NULL) {
 			new_job->init_start_time = time;
 			new_job->start_time = time;
@@ -193,6 +246,7 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 				peek_job->pause_time = time;
 				peek_job->idle_time += 0;
 
+#ifdef DEBUG
 				printf(
 						ANSI_COLOR_YELLOW"******** current_scheduling_scheme == PPRI scheduler_new_job ***********\n");
 				printf("new_job->job_number : %d\n", new_job->job_number);
@@ -200,6 +254,7 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 				printf("new_job->init_start_time : %d\n",
 						new_job->init_start_time);
 				printf("*********"ANSI_COLOR_RESET"\n");
+#endif
 
 				return 0;
 			} else {
@@ -228,8 +283,8 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 //			new_job->pause_time = time;
 //			return -1;
 //		}
-	} else if (current_scheduling_scheme == RR) {
-		priqueue_offer(job_queue, new_job);
+	} else if (scheduler->m_scheme == RR) {
+		priqueue_offer(scheduler->m_job_queue, new_job);
 		if (peek_job == NULL) {
 			new_job->init_start_time = time;
 			new_job->start_time = time;
@@ -249,127 +304,149 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
 }
 
 /**
- Called when a job has completed execution.
+ Called when a new job arrives.
 
- The core_id, job_number and time parameters are provided for convenience. You may be able to calculate the values with your own data structure.
- If any job should be scheduled to run on the core free'd up by the
- finished job, return the job_number of the job that should be scheduled to
- run on core core_id.
+ If multiple cores are idle, the job should be assigned to the core with the
+ lowest id.
+ If the job arriving should be scheduled to run during the next
+ time cycle, return the zero-based index of the core the job should be
+ scheduled on. If another job is already running on the core specified,
+ this will preempt the currently running job.
+ Assumptions:
+ - You may assume that every job wil have a unique arrival time.
 
- @param core_id the zero-based index of the core where the job was located.
- @param job_number a globally unique identification number of the job.
+ @param scheduler the scheduler instance.
+ @param job_number a globally unique identification number of the job arriving.
  @param time the current time of the simulator.
- @return job_number of the job that should be scheduled to run on core core_id
- @return -1 if core should remain idle.
+ @param running_time the total number of time units this job will run before it will be finished.
+ @param priority the priority of the job. (The lower the value, the higher the priority.)
+ @return index of core job should be scheduled on
+ @return -1 if no scheduling changes should be made.
+
  */
-int scheduler_job_finished(int core_id, int job_number, int time) {
+int scheduler_new_job_r(scheduler_t *scheduler, int job_number, int time, int running_time, int priority) {
+	scheduler_account_time(scheduler, time);
+	scheduler->m_stats.m_new_job_calls++;
 
+	int core_id = scheduler_decide_new_job(scheduler, job_number, time, running_time, priority);
+	if (core_id >= 0) {
+		scheduler_account_dispatch(scheduler, core_id, job_number);
+	}
+	scheduler_account_depth(scheduler);
+	return core_id;
+}
+
+//Decides what runs after a job finishes; see scheduler_job_finished_r()
+static int scheduler_decide_job_finished(scheduler_t *scheduler, int core_id, int job_number, int time) {
+
+#ifdef DEBUG
 	//******delete********
 	printf(
 			ANSI_COLOR_MAGENTA"******** core_id: %d, job_number: %d, time: %d *********\n",
 			core_id, job_number, time);
 	printf(
 			ANSI_COLOR_MAGENTA"******** scheduler_job_finished: Elements in jobs queue : ");
-	for (int i = 0; i < priqueue_size(job_queue); i++)
-		printf("%d ", *((int *) priqueue_at(job_queue, i)));
+	for (int i = 0; i < priqueue_size(scheduler->m_job_queue); i++)
+		printf("%d ", *((int *) priqueue_at(scheduler->m_job_queue, i)));
 	printf("*********"ANSI_COLOR_RESET"\n");
 	//^^^^^^delete^^^^^^^^
+#endif
 
-	if (current_scheduling_scheme == FCFS) {
+	if (scheduler->m_scheme == FCFS) {
 		//Get info about the job finished
-		job_t* finished_job = priqueue_poll(job_queue);
+		job_t* finished_job = priqueue_poll(scheduler->m_job_queue);
 
 		//Calculate metrics
-		total_turnaround_time += time - finished_job->arrival_time;
-		total_response_time += finished_job->start_time
+		scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
+		scheduler->m_total_response_time += finished_job->start_time
 				- finished_job->arrival_time;
-		total_waiting_time += finished_job->start_time
+		scheduler->m_total_waiting_time += finished_job->start_time
 				- finished_job->arrival_time;
 		free(finished_job);
 
-		job_t* peek_job = priqueue_at(job_queue, 0);
+		job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 		if (peek_job == NULL) {
 			return -1;
 		} else {
 			peek_job->start_time = time;
 			return peek_job->job_number;
 		}
-	} else if (current_scheduling_scheme == SJF) {
+	} else if (scheduler->m_scheme == SJF) {
 		//find the finished job on the queue
-		int index_of_job;
+		int index_of_job = 0;
 
-		for (int i = 0; i < priqueue_size(job_queue); i++) {
-			job_t* temp_job = priqueue_at(job_queue, i);
+		for (int i = 0; i < priqueue_size(scheduler->m_job_queue); i++) {
+			job_t* temp_job = priqueue_at(scheduler->m_job_queue, i);
 			if (temp_job->job_number == job_number) {
 				index_of_job = i;
 			}
 		}
 
 		//Get info about the job finished
-		job_t* finished_job = priqueue_at(job_queue, index_of_job);
+		job_t* finished_job = priqueue_at(scheduler->m_job_queue, index_of_job);
 
 		//Calculate metrics
-		total_turnaround_time += time - finished_job->arrival_time;
-		total_response_time += finished_job->start_time
+		scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
+		scheduler->m_total_response_time += finished_job->start_time
 				- finished_job->arrival_time;
-		total_waiting_time += finished_job->start_time
+		scheduler->m_total_waiting_time += finished_job->start_time
 				- finished_job->arrival_time;
 
 		//remove finished job
-		priqueue_remove_at(job_queue, index_of_job);
+		priqueue_remove_at(scheduler->m_job_queue, index_of_job);
 		free(finished_job);
 
-		job_t* peek_job = priqueue_at(job_queue, 0);
+		job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 		if (peek_job == NULL) {
 			return -1;
 		} else {
 			peek_job->start_time = time;
 			return peek_job->job_number;
 		}
-	} else if (current_scheduling_scheme == PRI) {
+	} else if (scheduler->m_scheme == PRI) {
 		//find the finished job on the queue
-		int index_of_job;
+		int index_of_job = 0;
 
-		for (int i = 0; i < priqueue_size(job_queue); i++) {
-			job_t* temp_job = priqueue_at(job_queue, i);
+		for (int i = 0; i < priqueue_size(scheduler->m_job_queue); i++) {
+			job_t* temp_job = priqueue_at(scheduler->m_job_queue, i);
 			if (temp_job->job_number == job_number) {
 				index_of_job = i;
 			}
 		}
 
 		//Get info about the job finished
-		job_t* finished_job = priqueue_at(job_queue, index_of_job);
+		job_t* finished_job = priqueue_at(scheduler->m_job_queue, index_of_job);
 
 		//Calculate metrics
-		total_turnaround_time += time - finished_job->arrival_time;
-		total_response_time += finished_job->start_time
+		scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
+		scheduler->m_total_response_time += finished_job->start_time
 				- finished_job->arrival_time;
-		total_waiting_time += finished_job->start_time
+		scheduler->m_total_waiting_time += finished_job->start_time
 				- finished_job->arrival_time;
 
 		//remove finished job
-		priqueue_remove_at(job_queue, index_of_job);
+		priqueue_remove_at(scheduler->m_job_queue, index_of_job);
 		free(finished_job);
 
-		job_t* peek_job = priqueue_at(job_queue, 0);
+		job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 		if (peek_job == NULL) {
 			return -1;
 		} else {
 			peek_job->start_time = time;
 			return peek_job->job_number;
 		}
-	} else if (current_scheduling_scheme == PSJF) {
+	} else if (scheduler->m_scheme == PSJF) {
 		//Get info about the job finished
-		job_t* finished_job = priqueue_poll(job_queue);
+		job_t* finished_job = priqueue_poll(scheduler->m_job_queue);
 
 		//Calculate metrics
-		total_turnaround_time += time - finished_job->arrival_time;
-		total_response_time += finished_job->init_start_time
+		scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
+		scheduler->m_total_response_time += finished_job->init_start_time
 				- finished_job->arrival_time;
-		total_waiting_time += finished_job->idle_time;
+		scheduler->m_total_waiting_time += finished_job->idle_time;
 		free(finished_job);
 
-		job_t* peek_job = priqueue_at(job_queue, 0);
+		job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 		if (peek_job == NULL) {
 			return -1;
 		} else {
@@ -381,22 +458,23 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 					- (peek_job->pause_time);
 			return peek_job->job_number;
 		}
-	} else if (current_scheduling_scheme == PPRI) {
+	} else if (scheduler->m_scheme == PPRI) {
 		//Get info about the job finished
-		job_t* finished_job = priqueue_poll(job_queue);
+		job_t* finished_job = priqueue_poll(scheduler->m_job_queue);
 
 		//Calculate metrics
-		total_turnaround_time += time - finished_job->arrival_time;
-		total_response_time += finished_job->init_start_time
+		scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
+		scheduler->m_total_response_time += finished_job->init_start_time
 				- finished_job->arrival_time;
-		total_waiting_time += finished_job->idle_time;
+		scheduler->m_total_waiting_time += finished_job->idle_time;
 
+#ifdef DEBUG
 		printf(
 				ANSI_COLOR_GREEN"******** current_scheduling_scheme == PPRI ***********\n");
-		printf("total_waiting_time : %d\n", total_waiting_time);
-		printf("total_turnaround_time : %d\n", total_turnaround_time);
-		printf("total_response_time : %d\n", total_response_time);
-		printf("total_number_of_jobs : %d\n", total_number_of_jobs);
+		printf("total_waiting_time : %d\n", scheduler->m_total_waiting_time);
+		printf("total_turnaround_time : %d\n", scheduler->m_total_turnaround_time);
+		printf("total_response_time : %d\n", scheduler->m_total_response_time);
+		printf("total_number_of_jobs : %d\n", scheduler->m_total_number_of_jobs);
 		printf("finished_job->job_number : %d\n", finished_job->job_number);
 		printf("finished_job->arrival_time : %d\n", finished_job->arrival_time);
 		printf("finished_job->init_start_time : %d\n",
@@ -404,10 +482,11 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 		printf("finished_job  response_time : %d\n",
 				(finished_job->init_start_time - finished_job->arrival_time));
 		printf("*********"ANSI_COLOR_RESET"\n");
+#endif
 
 		free(finished_job);
 
-		job_t* peek_job = priqueue_at(job_queue, 0);
+		job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 		if (peek_job == NULL) {
 			return -1;
 		} else {
@@ -417,6 +496,7 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 				peek_job->pause_time = -1;
 				peek_job->idle_time = time - peek_job->arrival_time;
 
+#ifdef DEBUG
 				printf(
 						ANSI_COLOR_CYAN"******** current_scheduling_scheme == PPRI init_start_time == -1***********\n");
 				printf("peek_job->job_number : %d\n", peek_job->job_number);
@@ -424,9 +504,11 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 				printf("peek_job->init_start_time : %d ",
 						peek_job->init_start_time);
 			printf("*********"ANSI_COLOR_RESET"\n");
+#endif
 
 		} else {
 
+#ifdef DEBUG
 			printf(
 					ANSI_COLOR_RED"******** current_scheduling_scheme == PPRI ***********\n");
 			printf("peek_job->job_number : %d\n", peek_job->job_number);
@@ -434,6 +516,7 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 			printf("peek_job->init_start_time : %d ",
 					peek_job->init_start_time);
 			printf("*********"ANSI_COLOR_RESET"\n");
+#endif
 
 			if (peek_job->pause_time == -1) {
 				peek_job->idle_time += 0;
@@ -467,20 +550,20 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 //					- (peek_job->pause_time);
 //			return peek_job->job_number;
 //		}
-} else if (current_scheduling_scheme == RR) {
+} else if (scheduler->m_scheme == RR) {
 	//Get info about the job finished
-	job_t* finished_job = priqueue_poll(job_queue);
+	job_t* finished_job = priqueue_poll(scheduler->m_job_queue);
 
 	//Calculate metrics
-	total_turnaround_time += time - finished_job->arrival_time;
+	scheduler->m_total_turnaround_time += time - finished_job->arrival_time;
 
-	total_response_time += finished_job->init_start_time
+	scheduler->m_total_response_time += finished_job->init_start_time
 			- finished_job->arrival_time;
 
-	total_waiting_time += finished_job->idle_time;
+	scheduler->m_total_waiting_time += finished_job->idle_time;
 	free(finished_job);
 
-	job_t* peek_job = priqueue_at(job_queue, 0);
+	job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 	if (peek_job == NULL) {
 		return -1;
 	} else {
@@ -506,22 +589,58 @@ int scheduler_job_finished(int core_id, int job_number, int time) {
 }
 
 /**
- When the scheme is set to RR, called when the quantum timer has expired
- on a core.
+ Called when a job has completed execution.
 
- If any job should be scheduled to run on the core free'd up by
- the quantum expiration, return the job_number of the job that should be
- scheduled to run on core core_id.
+ The core_id, job_number and time parameters are provided for convenience. You may be able to calculate the values with your own data structure.
+ If any job should be scheduled to run on the core free'd up by the
+ finished job, return the job_number of the job that should be scheduled to
+ run on core core_id.
 
- @param core_id the zero-based index of the core where the quantum has expired.
+ @param scheduler the scheduler instance.
+ @param core_id the zero-based index of the core where the job was located.
+ @param job_number a globally unique identification number of the job.
  @param time the current time of the simulator.
- @return job_number of the job that should be scheduled on core cord_id
- @return -1 if core should remain idle
+ @return job_number of the job that should be scheduled to run on core core_id
+ @return -1 if core should remain idle.
  */
-int scheduler_quantum_expired(int core_id, int time) {
+int scheduler_job_finished_r(scheduler_t *scheduler, int core_id, int job_number, int time) {
+	scheduler_account_time(scheduler, time);
+	scheduler->m_stats.m_job_finished_calls++;
+
+	//A job that has blocked was queued again when it woke, so the schemes' own
+	//bookkeeping only covers its last CPU burst; count it from its submission
+	job_t blocked_job;
+	int has_blocked = 0;
+	if (scheduler->m_stats.m_job_blocked_calls > 0) {
+		int index = scheduler_find_job(scheduler->m_job_queue, job_number);
+		if (index >= 0) {
+			blocked_job = *(job_t *) priqueue_at(scheduler->m_job_queue, index);
+			has_blocked = (blocked_job.first_start_time != -1);
+		}
+	}
+	int waiting_time = scheduler->m_total_waiting_time;
+	int turnaround_time = scheduler->m_total_turnaround_time;
+	int response_time = scheduler->m_total_response_time;
+
+	int next_job = scheduler_decide_job_finished(scheduler, core_id, job_number, time);
+	if (has_blocked) {
+		scheduler->m_total_turnaround_time = turnaround_time + (time - blocked_job.submit_time);
+		scheduler->m_total_waiting_time = waiting_time + (time - blocked_job.submit_time)
+				- blocked_job.running_time - blocked_job.blocked_time;
+		scheduler->m_total_response_time = response_time + (blocked_job.first_start_time - blocked_job.submit_time);
+	}
+	if (core_id >= 0 && core_id < scheduler->m_stats.m_cores) {
+		scheduler->m_core_job[core_id] = -1;
+	}
+	scheduler_account_dispatch(scheduler, core_id, next_job);
+	return next_job;
+}
+
+//Decides what runs after a quantum expires; see scheduler_quantum_expired_r()
+static int scheduler_decide_quantum_expired(scheduler_t *scheduler, int core_id, int time) {
 //Check the job at the front of the queue
 //this is the job that caused the quantum to expire
-job_t* peek_job = priqueue_at(job_queue, 0);
+job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
 
 if (peek_job == NULL) {
 	//No job at the front of the queue
@@ -530,7 +649,7 @@ if (peek_job == NULL) {
 	//There exits a job at the front of the queue
 	//Check if this is the only job in the queue
 
-	job_t* peek_job_second = priqueue_at(job_queue, 1);
+	job_t* peek_job_second = priqueue_at(scheduler->m_job_queue, 1);
 
 	if (peek_job_second == NULL) {
 		//Only job in the queue
@@ -554,13 +673,13 @@ if (peek_job == NULL) {
 	} else {
 		//More the one job in the queue
 		//Remove the first job from the queue and put it to the back.
-		job_t* first_job = priqueue_poll(job_queue);
+		job_t* first_job = priqueue_poll(scheduler->m_job_queue);
 		first_job->pause_time = time;
 		first_job->idle_time += 0;
-		priqueue_offer(job_queue, first_job);
+		priqueue_offer(scheduler->m_job_queue, first_job);
 
 		//Check the new job at the front of the queue
-		job_t* peek_job_again = priqueue_at(job_queue, 0);
+		job_t* peek_job_again = priqueue_at(scheduler->m_job_queue, 0);
 
 		//Check if this job has been scheduled before
 		if (peek_job_again->init_start_time == -1) {
@@ -589,15 +708,227 @@ if (peek_job == NULL) {
 }
 }
 
+/**
+ When the scheme is set to RR, called when the quantum timer has expired
+ on a core.
+
+ If any job should be scheduled to run on the core free'd up by
+ the quantum expiration, return the job_number of the job that should be
+ scheduled to run on core core_id.
+
+ @param scheduler the scheduler instance.
+ @param core_id the zero-based index of the core where the quantum has expired.
+ @param time the current time of the simulator.
+ @return job_number of the job that should be scheduled on core cord_id
+ @return -1 if core should remain idle
+ */
+int scheduler_quantum_expired_r(scheduler_t *scheduler, int core_id, int time) {
+	scheduler_account_time(scheduler, time);
+	scheduler->m_stats.m_quantum_expired_calls++;
+
+	int next_job = scheduler_decide_quantum_expired(scheduler, core_id, time);
+	scheduler_account_dispatch(scheduler, core_id, next_job);
+	return next_job;
+}
+
+//Index of job_number on queue, or -1 if it is not there
+static int scheduler_find_job(priqueue_t *queue, int job_number) {
+	Node *node;
+	int index = 0;
+
+	for (node = queue->m_front; node != NULL; node = node->m_next, index++) {
+		if (((job_t *) node->m_value)->job_number == job_number) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+//Starts the job at the front of the queue on the core a job left; see scheduler_job_blocked_r()
+static int scheduler_start_front(scheduler_t *scheduler, int time) {
+	job_t* peek_job = priqueue_at(scheduler->m_job_queue, 0);
+	if (peek_job == NULL) {
+		return -1;
+	}
+
+	if (scheduler->m_scheme == FCFS || scheduler->m_scheme == SJF
+			|| scheduler->m_scheme == PRI) {
+		peek_job->start_time = time;
+	} else if (peek_job->init_start_time == -1) {
+		peek_job->init_start_time = time;
+		peek_job->start_time = time;
+		peek_job->pause_time = -1;
+		peek_job->idle_time = time - peek_job->arrival_time;
+	} else {
+		if (peek_job->pause_time != -1) {
+			peek_job->idle_time += time - peek_job->pause_time;
+		}
+		peek_job->start_time = time;
+	}
+	return peek_job->job_number;
+}
+
+//Decides what runs after a job blocks; see scheduler_job_blocked_r()
+static int scheduler_decide_job_blocked(scheduler_t *scheduler, int job_number, int time) {
+	int index = scheduler_find_job(scheduler->m_job_queue, job_number);
+	if (index == -1) {
+		return -1;
+	}
+
+	job_t* blocked_job = priqueue_remove_at(scheduler->m_job_queue, index);
+	if (blocked_job->first_start_time == -1) {
+		if (scheduler->m_scheme == FCFS || scheduler->m_scheme == SJF
+				|| scheduler->m_scheme == PRI || blocked_job->init_start_time == -1) {
+			blocked_job->first_start_time = blocked_job->start_time;
+		} else {
+			blocked_job->first_start_time = blocked_job->init_start_time;
+		}
+	}
+	blocked_job->remaining_time -= time - blocked_job->start_time;
+	blocked_job->pause_time = time;
+	priqueue_offer(scheduler->m_blocked_jobs, blocked_job);
+
+	return scheduler_start_front(scheduler, time);
+}
+
+/**
+ Called when the job running on a core has ended a CPU burst and waits on
+ I/O.  The job leaves the queue until scheduler_job_woke() is called for it;
+ the core is free for another job meanwhile.
+
+ @param scheduler the scheduler instance.
+ @param core_id the zero-based index of the core where the job was running.
+ @param job_number a globally unique identification number of the job.
+ @param time the current time of the simulator.
+ @return job_number of the job that should be scheduled to run on core core_id
+ @return -1 if core should remain idle.
+ */
+int scheduler_job_blocked_r(scheduler_t *scheduler, int core_id, int job_number, int time) {
+	scheduler_account_time(scheduler, time);
+	scheduler->m_stats.m_job_blocked_calls++;
+
+	int next_job = scheduler_decide_job_blocked(scheduler, job_number, time);
+	if (core_id >= 0 && core_id < scheduler->m_stats.m_cores) {
+		scheduler->m_core_job[core_id] = -1;
+	}
+	scheduler_account_dispatch(scheduler, core_id, next_job);
+	return next_job;
+}
+
+/**
+ Called when a blocked job's I/O has completed and it is ready to run again.
+
+ The job is queued as if it arrived at time, with what is left of its
+ running time, and may preempt as a new job would.  Its averages still count
+ from when it first arrived, and the time it spent blocked is not waiting.
+
+ @param scheduler the scheduler instance.
+ @param job_number the number of a job given to scheduler_job_blocked().
+ @param time the current time of the simulator.
+ @return index of core job should be scheduled on
+ @return -1 if no scheduling changes should be made.
+ */
+int scheduler_job_woke_r(scheduler_t *scheduler, int job_number, int time) {
+	scheduler_account_time(scheduler, time);
+	scheduler->m_stats.m_job_woke_calls++;
+
+	int index = scheduler_find_job(scheduler->m_blocked_jobs, job_number);
+	if (index == -1) {
+		return -1;
+	}
+
+	job_t* woken_job = priqueue_remove_at(scheduler->m_blocked_jobs, index);
+	woken_job->blocked_time += time - woken_job->pause_time;
+	woken_job->arrival_time = time;
+
+	int core_id = scheduler_decide_offer(scheduler, woken_job, time);
+	if (core_id >= 0) {
+		scheduler_account_dispatch(scheduler, core_id, job_number);
+	}
+	scheduler_account_depth(scheduler);
+	return core_id;
+}
+
+/**
+ Takes a waiting job, the first or the last one eligible accepts, off the
+ scheduler.  The job is forgotten, and not counted in the averages.
+
+ @return job_number of the job taken, or -1 if none was.
+ */
+static int scheduler_take_waiting(scheduler_t *scheduler, int (*eligible)(int job_number, void *arg), void *arg, int last) {
+	Node *node;
+	int index = 0, taken = -1;
+
+	//One walk down the queue, stopping at the first job that may be taken unless the last is wanted
+	for (node = scheduler->m_job_queue->m_front; node != NULL && (last || taken == -1); node = node->m_next, index++) {
+		job_t *job = node->m_value;
+		int running = 0;
+
+		for (int i = 0; i < scheduler->m_stats.m_cores; i++) {
+			if (scheduler->m_core_job[i] == job->job_number) {
+				running = 1;
+			}
+		}
+
+		if (!running && (eligible == NULL || eligible(job->job_number, arg))) {
+			taken = index;
+		}
+	}
+
+	if (taken == -1) {
+		return -1;
+	}
+
+	job_t *job = priqueue_remove_at(scheduler->m_job_queue, taken);
+	int job_number = job->job_number;
+	free(job);
+	scheduler->m_total_number_of_jobs--;
+	return job_number;
+}
+
+/**
+ Takes a waiting job off the scheduler, so that it can be run elsewhere, e.g.
+ by the scheduler of an idle core.
+
+ Of the jobs that are waiting rather than running on a core, the one that
+ would run last is taken; with eligible, the one that would run last of
+ those it accepts.  The job is forgotten, and not counted in the averages
+ of this scheduler.
+
+ @param scheduler the scheduler instance.
+ @param eligible if not NULL, called with the job number of each waiting job and arg; nonzero if the job may be taken.
+ @param arg passed to eligible.
+ @return job_number of the job taken
+ @return -1 if no job is waiting (or none is eligible).
+ */
+int scheduler_steal_job_r(scheduler_t *scheduler, int (*eligible)(int job_number, void *arg), void *arg) {
+	return scheduler_take_waiting(scheduler, eligible, arg, 1);
+}
+
+/**
+ Takes the waiting job the scheduler would run next off it, so that it can be
+ run elsewhere, e.g. on a faster core that went idle.  Under SJF and PSJF this
+ is the shortest waiting job, under PRI and PPRI the one of highest priority.
+ The job is forgotten, and not counted in the averages of this scheduler.
+
+ @param scheduler the scheduler instance.
+ @return job_number of the job taken
+ @return -1 if no job is waiting.
+ */
+int scheduler_take_next_job_r(scheduler_t *scheduler) {
+	return scheduler_take_waiting(scheduler, NULL, NULL, 0);
+}
+
 /**
  Returns the average waiting time of all jobs scheduled by your scheduler.
 
  Assumptions:
  - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+ @param scheduler the scheduler instance.
  @return the average waiting time of all jobs scheduled.
  */
-float scheduler_average_waiting_time() {
-return ((float) (total_waiting_time) / total_number_of_jobs);
+float scheduler_average_waiting_time_r(scheduler_t *scheduler) {
+return ((float) (scheduler->m_total_waiting_time) / scheduler->m_total_number_of_jobs);
 }
 
 /**
@@ -605,10 +936,11 @@ return ((float) (total_waiting_time) / total_number_of_jobs);
 
  Assumptions:
  - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+ @param scheduler the scheduler instance.
  @return the average turnaround time of all jobs scheduled.
  */
-float scheduler_average_turnaround_time() {
-return ((float) (total_turnaround_time) / total_number_of_jobs);
+float scheduler_average_turnaround_time_r(scheduler_t *scheduler) {
+return ((float) (scheduler->m_total_turnaround_time) / scheduler->m_total_number_of_jobs);
 }
 
 /**
@@ -616,10 +948,11 @@ return ((float) (total_turnaround_time) / total_number_of_jobs);
 
  Assumptions:
  - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+ @param scheduler the scheduler instance.
  @return the average response time of all jobs scheduled.
  */
-float scheduler_average_response_time() {
-return ((float) (total_response_time) / total_number_of_jobs);
+float scheduler_average_response_time_r(scheduler_t *scheduler) {
+return ((float) (scheduler->m_total_response_time) / scheduler->m_total_number_of_jobs);
 }
 
 /**
@@ -627,9 +960,14 @@ return ((float) (total_response_time) / total_number_of_jobs);
 
  Assumptions:
  - This function will be the last function called in your library.
+
+ @param scheduler the scheduler instance.
  */
-void scheduler_clean_up() {
-free(job_queue);
+void scheduler_clean_up_r(scheduler_t *scheduler) {
+free(scheduler->m_job_queue);
+free(scheduler->m_blocked_jobs);
+free(scheduler->m_core_job);
+free(scheduler->m_stats.m_context_switches);
 }
 
 /**
@@ -647,15 +985,332 @@ free(job_queue);
 
  This function is not required and will not be graded. You may leave it
  blank if you do not find it useful.
+
+ @param scheduler the scheduler instance.
+ */
+void scheduler_show_queue_r(scheduler_t *scheduler) {
+for (int i = 0; i < priqueue_size(scheduler->m_job_queue); i++) {
+	printf("%d()", *((int *) priqueue_at(scheduler->m_job_queue, i)));
+}
+}
+
+/**
+ Returns the counters of the work the scheduler has done since it started up.
+
+ The counters are kept by the entry points as they run, with plain
+ increments, so they are always on.  Queue depths count every job the
+ scheduler holds, running or waiting, and the mean is weighted by the time
+ between calls.
+
+ Assumptions:
+ - The per-core context switch counts stay valid until the scheduler is cleaned up.
+
+ @param scheduler the scheduler instance.
+ @param stats set to the counters of the scheduler.
+ */
+void scheduler_get_stats_r(scheduler_t *scheduler, scheduler_stats_t *stats) {
+	priqueue_stats_t queue_stats;
+	priqueue_get_stats(scheduler->m_job_queue, &queue_stats);
+
+	*stats = scheduler->m_stats;
+	stats->m_comparisons = queue_stats.m_comparisons;
+	stats->m_node_allocations = queue_stats.m_allocations;
+	stats->m_queue_depth = priqueue_size(scheduler->m_job_queue);
+
+	int span = scheduler->m_last_time - scheduler->m_first_time;
+	stats->m_mean_queue_depth = (span > 0) ? (double) scheduler->m_depth_area / span : stats->m_queue_depth;
+}
+
+//Makes what a shard's scheduler has counted so far readable without its lock
+static void scheduler_mt_publish(scheduler_shard_t *shard) {
+	scheduler_t *scheduler = &shard->m_scheduler;
+
+	atomic_store_explicit(&shard->m_new_job_calls, scheduler->m_stats.m_new_job_calls, memory_order_relaxed);
+	atomic_store_explicit(&shard->m_job_finished_calls, scheduler->m_stats.m_job_finished_calls, memory_order_relaxed);
+	atomic_store_explicit(&shard->m_quantum_expired_calls, scheduler->m_stats.m_quantum_expired_calls, memory_order_relaxed);
+	atomic_store_explicit(&shard->m_total_waiting_time, scheduler->m_total_waiting_time, memory_order_relaxed);
+	atomic_store_explicit(&shard->m_total_turnaround_time, scheduler->m_total_turnaround_time, memory_order_relaxed);
+	atomic_store_explicit(&shard->m_total_response_time, scheduler->m_total_response_time, memory_order_relaxed);
+}
+
+/**
+ Initalizes a thread-safe scheduler.
+
+ Assumptions:
+ - This is the first function called on the instance, and it is not called by several threads at once.
+
+ @param scheduler the thread-safe scheduler instance.
+ @param cores the number of cores that is available by the scheduler.
+ @param scheme the scheduling scheme that should be used.
+ @param shards the number of independently locked schedulers the cores are dealt out among, at most cores.
+ @return 0 on success
+ @return -1 if the scheduler could not be allocated
+ */
+int scheduler_mt_start_up(scheduler_mt_t *scheduler, int cores, scheme_t scheme, int shards) {
+	if (shards > cores) {
+		shards = cores;
+	}
+	if (shards < 1) {
+		shards = 1;
+	}
+
+	if (posix_memalign((void **) &scheduler->m_shards, SCHEDULER_CACHE_LINE, shards * sizeof(scheduler_shard_t)) != 0) {
+		return -1;
+	}
+	scheduler->m_shard_count = shards;
+	scheduler->m_cores = cores;
+	atomic_init(&scheduler->m_threads, 0);
+
+	for (int i = 0; i < shards; i++) {
+		scheduler_shard_t *shard = &scheduler->m_shards[i];
+		pthread_mutex_init(&shard->m_lock, NULL);
+		scheduler_start_up_r(&shard->m_scheduler, (cores - i + shards - 1) / shards, scheme);
+		scheduler_mt_publish(shard);
+	}
+	return 0;
+}
+
+/**
+ Called when a new job arrives, from any thread.
+
+ The job is handed to one shard, and the core returned is one of that
+ shard's cores.
+
+ @param scheduler the thread-safe scheduler instance.
+ @param job_number a globally unique identification number of the job arriving.
+ @param time the current time of the simulator.
+ @param running_time the total number of time units this job will run before it will be finished.
+ @param priority the priority of the job. (The lower the value, the higher the priority.)
+ @return index of core job should be scheduled on
+ @return -1 if no scheduling changes should be made.
+ */
+int scheduler_mt_new_job(scheduler_mt_t *scheduler, int job_number, int time, int running_time, int priority) {
+	int count = scheduler->m_shard_count;
+
+	if (scheduler_mt_hint_owner != scheduler) {
+		scheduler_mt_hint = atomic_fetch_add_explicit(&scheduler->m_threads, 1, memory_order_relaxed) % count + 1;
+		scheduler_mt_hint_owner = scheduler;
+	}
+
+	//Take the first free shard from the hint on, or wait for the hint's
+	int index = (scheduler_mt_hint - 1) % count;
+	scheduler_shard_t *shard = NULL;
+	for (int i = 0; i < count; i++) {
+		if (pthread_mutex_trylock(&scheduler->m_shards[(index + i) % count].m_lock) == 0) {
+			index = (index + i) % count;
+			shard = &scheduler->m_shards[index];
+			break;
+		}
+	}
+	if (shard == NULL) {
+		shard = &scheduler->m_shards[index];
+		pthread_mutex_lock(&shard->m_lock);
+	}
+	scheduler_mt_hint = index + 1;
+
+	int core_id = scheduler_new_job_r(&shard->m_scheduler, job_number, time, running_time, priority);
+	scheduler_mt_publish(shard);
+	pthread_mutex_unlock(&shard->m_lock);
+
+	return (core_id >= 0) ? index + core_id * count : core_id;
+}
+
+/**
+ Called when a job has completed execution, from any thread.
+
+ @param scheduler the thread-safe scheduler instance.
+ @param core_id the zero-based index of the core where the job was located.
+ @param job_number a globally unique identification number of the job.
+ @param time the current time of the simulator.
+ @return job_number of the job that should be scheduled to run on core core_id
+ @return -1 if core should remain idle.
+ */
+int scheduler_mt_job_finished(scheduler_mt_t *scheduler, int core_id, int job_number, int time) {
+	scheduler_shard_t *shard = &scheduler->m_shards[core_id % scheduler->m_shard_count];
+
+	pthread_mutex_lock(&shard->m_lock);
+	int next_job = scheduler_job_finished_r(&shard->m_scheduler, core_id / scheduler->m_shard_count, job_number, time);
+	scheduler_mt_publish(shard);
+	pthread_mutex_unlock(&shard->m_lock);
+
+	return next_job;
+}
+
+/**
+ When the scheme is set to RR, called when the quantum timer has expired
+ on a core, from any thread.
+
+ @param scheduler the thread-safe scheduler instance.
+ @param core_id the zero-based index of the core where the quantum has expired.
+ @param time the current time of the simulator.
+ @return job_number of the job that should be scheduled on core cord_id
+ @return -1 if core should remain idle
+ */
+int scheduler_mt_quantum_expired(scheduler_mt_t *scheduler, int core_id, int time) {
+	scheduler_shard_t *shard = &scheduler->m_shards[core_id % scheduler->m_shard_count];
+
+	pthread_mutex_lock(&shard->m_lock);
+	int next_job = scheduler_quantum_expired_r(&shard->m_scheduler, core_id / scheduler->m_shard_count, time);
+	scheduler_mt_publish(shard);
+	pthread_mutex_unlock(&shard->m_lock);
+
+	return next_job;
+}
+
+//Sums a published total over the shards, without taking their locks
+static float scheduler_mt_average(scheduler_mt_t *scheduler, size_t offset) {
+	long total = 0;
+	unsigned long jobs = 0;
+
+	for (int i = 0; i < scheduler->m_shard_count; i++) {
+		scheduler_shard_t *shard = &scheduler->m_shards[i];
+		total += atomic_load_explicit((atomic_long *) ((char *) shard + offset), memory_order_relaxed);
+		jobs += atomic_load_explicit(&shard->m_new_job_calls, memory_order_relaxed);
+	}
+	return (float) total / jobs;
+}
+
+/**
+ Returns the average waiting time of all jobs scheduled by the shards.  It
+ does not take any lock, so it may be called while other threads schedule.
+
+ @param scheduler the thread-safe scheduler instance.
+ @return the average waiting time of all jobs scheduled.
  */
+float scheduler_mt_average_waiting_time(scheduler_mt_t *scheduler) {
+	return scheduler_mt_average(scheduler, offsetof(scheduler_shard_t, m_total_waiting_time));
+}
+
+/**
+ Returns the average turnaround time of all jobs scheduled by the shards.
+ It does not take any lock.
+
+ @param scheduler the thread-safe scheduler instance.
+ @return the average turnaround time of all jobs scheduled.
+ */
+float scheduler_mt_average_turnaround_time(scheduler_mt_t *scheduler) {
+	return scheduler_mt_average(scheduler, offsetof(scheduler_shard_t, m_total_turnaround_time));
+}
+
+/**
+ Returns the average response time of all jobs scheduled by the shards.  It
+ does not take any lock.
+
+ @param scheduler the thread-safe scheduler instance.
+ @return the average response time of all jobs scheduled.
+ */
+float scheduler_mt_average_response_time(scheduler_mt_t *scheduler) {
+	return scheduler_mt_average(scheduler, offsetof(scheduler_shard_t, m_total_response_time));
+}
+
+/**
+ Returns the calls made to each entry point so far, summed over the shards.
+ It does not take any lock.
+
+ @param scheduler the thread-safe scheduler instance.
+ @param new_job_calls set to the number of scheduler_mt_new_job() calls.
+ @param job_finished_calls set to the number of scheduler_mt_job_finished() calls.
+ @param quantum_expired_calls set to the number of scheduler_mt_quantum_expired() calls.
+ */
+void scheduler_mt_get_calls(scheduler_mt_t *scheduler, unsigned long *new_job_calls, unsigned long *job_finished_calls, unsigned long *quantum_expired_calls) {
+	*new_job_calls = *job_finished_calls = *quantum_expired_calls = 0;
+
+	for (int i = 0; i < scheduler->m_shard_count; i++) {
+		scheduler_shard_t *shard = &scheduler->m_shards[i];
+		*new_job_calls += atomic_load_explicit(&shard->m_new_job_calls, memory_order_relaxed);
+		*job_finished_calls += atomic_load_explicit(&shard->m_job_finished_calls, memory_order_relaxed);
+		*quantum_expired_calls += atomic_load_explicit(&shard->m_quantum_expired_calls, memory_order_relaxed);
+	}
+}
+
+/**
+ Frees any memory associated with a thread-safe scheduler.
+
+ Assumptions:
+ - No other thread is calling into the scheduler.
+
+ @param scheduler the thread-safe scheduler instance.
+ */
+void scheduler_mt_clean_up(scheduler_mt_t *scheduler) {
+	for (int i = 0; i < scheduler->m_shard_count; i++) {
+		scheduler_clean_up_r(&scheduler->m_shards[i].m_scheduler);
+		pthread_mutex_destroy(&scheduler->m_shards[i].m_lock);
+	}
+	free(scheduler->m_shards);
+}
+
+/**
+ The functions below operate on the scheduler's built-in instance, for
+ callers that only ever need one scheduler.
+ */
+void scheduler_start_up(int cores, scheme_t scheme) {
+	scheduler_start_up_r(&default_scheduler, cores, scheme);
+}
+
+int scheduler_new_job(int job_number, int time, int running_time, int priority) {
+	return scheduler_new_job_r(&default_scheduler, job_number, time, running_time, priority);
+}
+
+int scheduler_job_finished(int core_id, int job_number, int time) {
+	return scheduler_job_finished_r(&default_scheduler, core_id, job_number, time);
+}
+
+int scheduler_quantum_expired(int core_id, int time) {
+	return scheduler_quantum_expired_r(&default_scheduler, core_id, time);
+}
+
+int scheduler_steal_job(int (*eligible)(int job_number, void *arg), void *arg) {
+	return scheduler_steal_job_r(&default_scheduler, eligible, arg);
+}
+
+int scheduler_take_next_job() {
+	return scheduler_take_next_job_r(&default_scheduler);
+}
+
+int scheduler_job_blocked(int core_id, int job_number, int time) {
+	return scheduler_job_blocked_r(&default_scheduler, core_id, job_number, time);
+}
+
+int scheduler_job_woke(int job_number, int time) {
+	return scheduler_job_woke_r(&default_scheduler, job_number, time);
+}
+
+float scheduler_average_waiting_time() {
+	return scheduler_average_waiting_time_r(&default_scheduler);
+}
+
+float scheduler_average_turnaround_time() {
+	return scheduler_average_turnaround_time_r(&default_scheduler);
+}
+
+float scheduler_average_response_time() {
+	return scheduler_average_response_time_r(&default_scheduler);
+}
+
+void scheduler_clean_up() {
+	scheduler_clean_up_r(&default_scheduler);
+}
+
 void scheduler_show_queue() {
-for (int i = 0; i < priqueue_size(job_queue); i++) {
-	printf("%d()", *((int *) priqueue_at(job_queue, i)));
+	scheduler_show_queue_r(&default_scheduler);
 }
+
+void scheduler_get_stats(scheduler_stats_t *stats) {
+	scheduler_get_stats_r(&default_scheduler, stats);
+}
+
+//Jobs that tie on every key keep the order they arrived in, even when they
+//share an arrival time, so a new job never lands ahead of the running one.
+int compare_job_numbers(const void* a, const void* b) {
+return (((job_t*) a)->job_number - ((job_t*) b)->job_number);
 }
 
 int compare_FCFS(const void* a, const void* b) {
-return (((job_t*) a)->arrival_time - ((job_t*) b)->arrival_time);
+int compare = ((job_t*) a)->arrival_time - ((job_t*) b)->arrival_time;
+if (compare == 0) {
+	compare = compare_job_numbers(a, b);
+}
+return (compare);
 }
 
 int compare_SJF(const void* a, const void* b) {
@@ -668,6 +1323,9 @@ int compare = ((job_t*) a)->remaining_time - ((job_t*) b)->remaining_time;
 if (compare == 0) {
 	compare = ((job_t*) a)->arrival_time - ((job_t*) b)->arrival_time;
 }
+if (compare == 0) {
+	compare = compare_job_numbers(a, b);
+}
 return (compare);
 }
 
@@ -676,6 +1334,9 @@ int compare = ((job_t*) a)->priority - ((job_t*) b)->priority;
 if (compare == 0) {
 	compare = ((job_t*) a)->arrival_time - ((job_t*) b)->arrival_time;
 }
+if (compare == 0) {
+	compare = compare_job_numbers(a, b);
+}
 return (compare);
 }
 
@@ -685,6 +1346,9 @@ int compare = ((job_t*) a)->priority - ((job_t*) b)->priority;
 if (compare == 0) {
 	compare = ((job_t*) a)->arrival_time - ((job_t*) b)->arrival_time;
 }
+if (compare == 0) {
+	compare = compare_job_numbers(a, b);
+}
 return (compare);
 }
 
@@ -4,6 +4,11 @@
 #ifndef LIBSCHEDULER_H_
 #define LIBSCHEDULER_H_
 
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../libpriqueue/libpriqueue.h"
+
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
 #define ANSI_COLOR_YELLOW  "\x1b[33m"
@@ -12,22 +17,141 @@
 #define ANSI_COLOR_CYAN    "\x1b[36m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
+#define SCHEDULER_CACHE_LINE 64
+
 
 /**
   Constants which represent the different scheduling algorithms
 */
 typedef enum {FCFS = 0, SJF, PSJF, PRI, PPRI, RR} scheme_t;
 
+/**
+  Counters of the work done by a scheduler, kept as it runs
+*/
+typedef struct _scheduler_stats_t
+{
+    unsigned long m_new_job_calls;
+    unsigned long m_job_finished_calls;
+    unsigned long m_quantum_expired_calls;
+    unsigned long m_job_blocked_calls;
+    unsigned long m_job_woke_calls;
+
+    unsigned long m_job_allocations;
+    unsigned long m_node_allocations;   // by the job queue
+    unsigned long m_comparisons;        // comparer calls made by the job queue
+
+    int m_queue_depth;                  // jobs held now, running or waiting
+    int m_max_queue_depth;
+    double m_mean_queue_depth;          // weighted by time, from the first call to the last
+
+    unsigned long m_preemptions;        // jobs taken off a core before they finished
+    int m_cores;
+    unsigned long *m_context_switches;  // per core, times it was given a different job
+} scheduler_stats_t;
+
+/**
+  Scheduler Data Structure
+
+  Everything one scheduler knows.  Instances are independent of each other,
+  so several schedulers can run side by side, e.g. one per thread; the
+  functions without the _r suffix use a single built-in instance.
+*/
+typedef struct _scheduler_t
+{
+    priqueue_t *m_job_queue;
+    priqueue_t *m_blocked_jobs;         // jobs waiting on I/O, in the order they blocked
+    scheme_t m_scheme;
+    int m_total_waiting_time;
+    int m_total_turnaround_time;
+    int m_total_response_time;
+    int m_total_number_of_jobs;
+
+    scheduler_stats_t m_stats;
+    int *m_core_job;                    // job each core was last given, or -1
+    int m_first_time, m_last_time;      // times of the first and the latest call
+    long long m_depth_area;             // queue depth integrated over time
+} scheduler_t;
+
+/**
+  Shard Data Structure
+
+  One scheduler of a thread-safe scheduler, behind its own lock.  The
+  counters and totals below are copies published by the holder of m_lock
+  after every call, so they can be read without taking it.
+*/
+typedef struct _scheduler_shard_t
+{
+    _Alignas(SCHEDULER_CACHE_LINE) pthread_mutex_t m_lock;
+    scheduler_t m_scheduler;
+
+    atomic_ulong m_new_job_calls;
+    atomic_ulong m_job_finished_calls;
+    atomic_ulong m_quantum_expired_calls;
+    atomic_long m_total_waiting_time;
+    atomic_long m_total_turnaround_time;
+    atomic_long m_total_response_time;
+} scheduler_shard_t;
+
+/**
+  Thread-Safe Scheduler Data Structure
+
+  A scheduler that any number of threads may call at once.  The cores are
+  dealt out among independent shards, core c going to shard c % m_shard_count,
+  so the calls for a core take only the lock of its shard.  New jobs go to
+  whichever shard the calling thread can lock first, starting from the last
+  one it used on this instance, so that producers spread over the shards
+  rather than queue up on one lock.  A job stays in the shard it arrived at and only ever runs
+  on that shard's cores.
+*/
+typedef struct _scheduler_mt_t
+{
+    scheduler_shard_t *m_shards;
+    int m_shard_count;
+    int m_cores;
+    atomic_uint m_threads;  // threads that have started on this instance, to spread their first shards
+} scheduler_mt_t;
+
 void  scheduler_start_up               (int cores, scheme_t scheme);
 int   scheduler_new_job                (int job_number, int time, int running_time, int priority);
 int   scheduler_job_finished           (int core_id, int job_number, int time);
 int   scheduler_quantum_expired        (int core_id, int time);
+int   scheduler_job_blocked            (int core_id, int job_number, int time);
+int   scheduler_job_woke               (int job_number, int time);
+int   scheduler_steal_job              (int (*eligible)(int job_number, void *arg), void *arg);
+int   scheduler_take_next_job          ();
 float scheduler_average_turnaround_time();
 float scheduler_average_waiting_time   ();
 float scheduler_average_response_time  ();
 void  scheduler_clean_up               ();
 
 void  scheduler_show_queue             ();
+void  scheduler_get_stats               (scheduler_stats_t *stats);
+
+void  scheduler_start_up_r               (scheduler_t *scheduler, int cores, scheme_t scheme);
+int   scheduler_new_job_r                (scheduler_t *scheduler, int job_number, int time, int running_time, int priority);
+int   scheduler_job_finished_r           (scheduler_t *scheduler, int core_id, int job_number, int time);
+int   scheduler_quantum_expired_r        (scheduler_t *scheduler, int core_id, int time);
+int   scheduler_job_blocked_r            (scheduler_t *scheduler, int core_id, int job_number, int time);
+int   scheduler_job_woke_r               (scheduler_t *scheduler, int job_number, int time);
+int   scheduler_steal_job_r              (scheduler_t *scheduler, int (*eligible)(int job_number, void *arg), void *arg);
+int   scheduler_take_next_job_r          (scheduler_t *scheduler);
+float scheduler_average_turnaround_time_r(scheduler_t *scheduler);
+float scheduler_average_waiting_time_r   (scheduler_t *scheduler);
+float scheduler_average_response_time_r  (scheduler_t *scheduler);
+void  scheduler_clean_up_r               (scheduler_t *scheduler);
+
+void  scheduler_show_queue_r             (scheduler_t *scheduler);
+void  scheduler_get_stats_r               (scheduler_t *scheduler, scheduler_stats_t *stats);
+
+int   scheduler_mt_start_up               (scheduler_mt_t *scheduler, int cores, scheme_t scheme, int shards);
+int   scheduler_mt_new_job                (scheduler_mt_t *scheduler, int job_number, int time, int running_time, int priority);
+int   scheduler_mt_job_finished           (scheduler_mt_t *scheduler, int core_id, int job_number, int time);
+int   scheduler_mt_quantum_expired        (scheduler_mt_t *scheduler, int core_id, int time);
+float scheduler_mt_average_turnaround_time(scheduler_mt_t *scheduler);
+float scheduler_mt_average_waiting_time   (scheduler_mt_t *scheduler);
+float scheduler_mt_average_response_time  (scheduler_mt_t *scheduler);
+void  scheduler_mt_get_calls              (scheduler_mt_t *scheduler, unsigned long *new_job_calls, unsigned long *job_finished_calls, unsigned long *quantum_expired_calls);
+void  scheduler_mt_clean_up               (scheduler_mt_t *scheduler);
 
 //Compare functions
 int compare_FCFS(const void* a, const void* b);
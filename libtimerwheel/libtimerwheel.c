@@ -0,0 +1,197 @@
+/** @file libtimerwheel.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "libtimerwheel.h"
+
+#define TIMERWHEEL_MASK (TIMERWHEEL_SLOTS - 1)
+
+
+/**
+  Links a timer into the slot matching its expiry, relative to the current
+  time of the wheel.  Level k holds timers expiring within 64^(k+1) time
+  units; timers further out than the top level can express are parked in the
+  top level and re-filed when that slot is cascaded.
+ */
+static void timerwheel_file(timerwheel_t *w, wheel_timer_t *t)
+{
+    unsigned int delta = (t->m_expires > w->m_now) ? (unsigned int)(t->m_expires - w->m_now) : 0;
+    unsigned int expires = (t->m_expires > w->m_now) ? (unsigned int)t->m_expires : (unsigned int)w->m_now;
+    int level = 0;
+
+    while (level < TIMERWHEEL_LEVELS - 1 && delta >= (1u << (TIMERWHEEL_SLOT_BITS * (level + 1))))
+        level++;
+
+    if (level == TIMERWHEEL_LEVELS - 1 && delta >= (1u << (TIMERWHEEL_SLOT_BITS * TIMERWHEEL_LEVELS)) - 1)
+        expires = (unsigned int)w->m_now + (1u << (TIMERWHEEL_SLOT_BITS * TIMERWHEEL_LEVELS)) - 1;
+
+    wheel_timer_t** head = &w->m_slots[level][(expires >> (TIMERWHEEL_SLOT_BITS * level)) & TIMERWHEEL_MASK];
+
+    t->m_pprev = head;
+    t->m_next = *head;
+    if (*head != NULL)
+        (*head)->m_pprev = &t->m_next;
+    *head = t;
+}
+
+
+/**
+  Unlinks a timer from whichever slot list it is on.
+ */
+static void timerwheel_unlink(wheel_timer_t *t)
+{
+    *t->m_pprev = t->m_next;
+    if (t->m_next != NULL)
+        t->m_next->m_pprev = t->m_pprev;
+
+    t->m_next = NULL;
+    t->m_pprev = NULL;
+}
+
+
+/**
+  Moves every timer in a slot of an upper level down to the level matching
+  its remaining time.
+
+  @return the slot index that was cascaded
+ */
+static int timerwheel_cascade(timerwheel_t *w, int level)
+{
+    int slot = (w->m_now >> (TIMERWHEEL_SLOT_BITS * level)) & TIMERWHEEL_MASK;
+    wheel_timer_t* t = w->m_slots[level][slot];
+
+    w->m_slots[level][slot] = NULL;
+    while (t != NULL) {
+        wheel_timer_t* next = t->m_next;
+        timerwheel_file(w, t);
+        t = next;
+    }
+
+    return slot;
+}
+
+
+/**
+  Initializes the timerwheel_t data structure.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param now the first time unit that timerwheel_advance() will process
+ */
+void timerwheel_init(timerwheel_t *w, int now)
+{
+    int level, slot;
+    for (level = 0; level < TIMERWHEEL_LEVELS; level++)
+        for (slot = 0; slot < TIMERWHEEL_SLOTS; slot++)
+            w->m_slots[level][slot] = NULL;
+
+    w->m_now = now;
+    w->m_size = 0;
+}
+
+
+/**
+  Initializes a timer that is not yet on any wheel.
+
+  @param t a pointer to the timer
+  @param key caller-defined identifier returned with the timer when it expires
+ */
+void timerwheel_timer(wheel_timer_t *t, int key)
+{
+    t->m_expires = 0;
+    t->m_key = key;
+    t->m_pending = 0;
+    t->m_next = NULL;
+    t->m_pprev = NULL;
+}
+
+
+/**
+  Arms a timer in O(1).  A timer that is already pending is re-armed.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param t a pointer to the timer
+  @param expires the time unit at which timerwheel_advance() should return the timer
+ */
+void timerwheel_add(timerwheel_t *w, wheel_timer_t *t, int expires)
+{
+    if (t->m_pending)
+        timerwheel_cancel(w, t);
+
+    t->m_expires = expires;
+    t->m_pending = 1;
+    timerwheel_file(w, t);
+    w->m_size++;
+}
+
+
+/**
+  Disarms a timer.  Cancelling a timer that is not pending has no effect.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param t a pointer to the timer
+ */
+void timerwheel_cancel(timerwheel_t *w, wheel_timer_t *t)
+{
+    if (!t->m_pending)
+        return;
+
+    timerwheel_unlink(t);
+    t->m_pending = 0;
+    w->m_size--;
+}
+
+
+/**
+  Processes every time unit up to and including time, returning the timers
+  that expired.  Each time unit costs O(1) plus the amortized cost of
+  cascading upper levels, so a tick with nothing to do is constant time.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param time the last time unit to process
+  @return a list, linked through m_next, of the expired timers (no longer pending)
+  @return NULL if no timer expired
+ */
+wheel_timer_t *timerwheel_advance(timerwheel_t *w, int time)
+{
+    wheel_timer_t* expired = NULL;
+
+    while (w->m_now <= time) {
+        int slot = w->m_now & TIMERWHEEL_MASK;
+        int level = 1;
+
+        if (slot == 0)
+            while (level < TIMERWHEEL_LEVELS && timerwheel_cascade(w, level) == 0)
+                level++;
+
+        wheel_timer_t* t = w->m_slots[0][slot];
+        w->m_slots[0][slot] = NULL;
+
+        while (t != NULL) {
+            wheel_timer_t* next = t->m_next;
+            t->m_pending = 0;
+            t->m_pprev = NULL;
+            t->m_next = expired;
+            expired = t;
+            w->m_size--;
+            t = next;
+        }
+
+        w->m_now++;
+    }
+
+    return expired;
+}
+
+
+/**
+  Returns the number of pending timers.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @return the number of pending timers
+ */
+int timerwheel_size(timerwheel_t *w)
+{
+    return w->m_size;
+}
@@ -0,0 +1,44 @@
+/** @file libtimerwheel.h
+ */
+
+#ifndef LIBTIMERWHEEL_H_
+#define LIBTIMERWHEEL_H_
+
+#define TIMERWHEEL_LEVELS     5
+#define TIMERWHEEL_SLOT_BITS  6
+#define TIMERWHEEL_SLOTS      (1 << TIMERWHEEL_SLOT_BITS)
+
+/**
+  Timer Data Structure
+
+  Timers are owned by the caller and linked into the wheel in place, so adding
+  and cancelling a timer never allocates.
+*/
+typedef struct _wheel_timer_t {
+    int m_expires;
+    int m_key;
+    int m_pending;
+    struct _wheel_timer_t* m_next;
+    struct _wheel_timer_t** m_pprev;
+} wheel_timer_t;
+
+/**
+  Timerwheel Data Structure
+*/
+typedef struct _timerwheel_t
+{
+    wheel_timer_t* m_slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+    int m_now;
+    int m_size;
+} timerwheel_t;
+
+
+void            timerwheel_init   (timerwheel_t *w, int now);
+void            timerwheel_timer  (wheel_timer_t *t, int key);
+
+void            timerwheel_add    (timerwheel_t *w, wheel_timer_t *t, int expires);
+void            timerwheel_cancel (timerwheel_t *w, wheel_timer_t *t);
+wheel_timer_t * timerwheel_advance(timerwheel_t *w, int time);
+int             timerwheel_size   (timerwheel_t *w);
+
+#endif /* LIBTIMERWHEEL_H_ */
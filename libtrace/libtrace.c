@@ -0,0 +1,124 @@
+/** @file libtrace.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "libtrace.h"
+
+
+/**
+  Starts the next event, separating it from the previous one.
+ */
+static void trace_next(trace_t *t)
+{
+    fputs(t->m_first ? "\n" : ",\n", t->m_file);
+    t->m_first = 0;
+}
+
+
+/**
+  Names a track of the trace.
+ */
+static void trace_name_track(trace_t *t, int track, const char *name)
+{
+    trace_next(t);
+    fprintf(t->m_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", track, name);
+
+    // Keeps the tracks in core order rather than in order of first use
+    trace_next(t);
+    fprintf(t->m_file, "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"sort_index\":%d}}", track, track);
+}
+
+
+/**
+  Creates a trace file and writes its header and the names of its tracks.
+
+  @param t a pointer to an instance of the trace_t data structure
+  @param file_name the file to write
+  @param cores the number of cores, each given its own track
+  @return 0 on success
+  @return -1 if the file could not be created
+ */
+int trace_open(trace_t *t, const char *file_name, int cores)
+{
+    char name[32];
+    int i;
+
+    if ((t->m_file = fopen(file_name, "w")) == NULL)
+        return -1;
+
+    if ((t->m_buffer = malloc(TRACE_BUFFER_SIZE)) != NULL)
+        setvbuf(t->m_file, t->m_buffer, _IOFBF, TRACE_BUFFER_SIZE);
+
+    t->m_cores = cores;
+    t->m_first = 1;
+
+    fputs("{\"traceEvents\":[", t->m_file);
+    trace_next(t);
+    fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Simulator\"}}", t->m_file);
+
+    for (i = 0; i < cores; i++) {
+        snprintf(name, sizeof(name), "Core %d", i);
+        trace_name_track(t, i, name);
+    }
+    trace_name_track(t, cores, "Scheduler");
+
+    return 0;
+}
+
+
+/**
+  Writes a slice in which a core ran a job from start until end.  Empty
+  slices are not written.
+
+  @param t a pointer to an instance of the trace_t data structure
+  @param core_id the core that ran the job
+  @param job_id the job
+  @param start the first time unit of the slice
+  @param end the time unit after the last one of the slice
+ */
+void trace_slice(trace_t *t, int core_id, int job_id, int start, int end)
+{
+    if (end <= start)
+        return;
+
+    trace_next(t);
+    fprintf(t->m_file, "{\"name\":\"Job %d\",\"cat\":\"job\",\"ph\":\"X\",\"ts\":%d,\"dur\":%d,\"pid\":0,\"tid\":%d,\"args\":{\"job\":%d}}",
+            job_id, start, end - start, core_id, job_id);
+}
+
+
+/**
+  Writes an instant event concerning a job.
+
+  @param t a pointer to an instance of the trace_t data structure
+  @param name the name of the event
+  @param core_id the core whose track the event is shown on, or -1 for the scheduler's track
+  @param job_id the job
+  @param time the time unit of the event
+ */
+void trace_instant(trace_t *t, const char *name, int core_id, int job_id, int time)
+{
+    trace_next(t);
+    fprintf(t->m_file, "{\"name\":\"%s\",\"cat\":\"scheduler\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%d,\"pid\":0,\"tid\":%d,\"args\":{\"job\":%d}}",
+            name, time, (core_id == -1) ? t->m_cores : core_id, job_id);
+}
+
+
+/**
+  Ends the trace and closes its file.
+
+  @param t a pointer to an instance of the trace_t data structure
+  @return 0 on success
+  @return -1 if the trace could not be written completely
+ */
+int trace_close(trace_t *t)
+{
+    fputs("\n]}\n", t->m_file);
+
+    int result = (!ferror(t->m_file) && fclose(t->m_file) == 0) ? 0 : -1;
+
+    free(t->m_buffer);
+    return result;
+}
@@ -0,0 +1,39 @@
+/** @file libtrace.h
+ */
+
+#ifndef LIBTRACE_H_
+#define LIBTRACE_H_
+
+#include <stdio.h>
+
+/**
+  Size of the buffer a trace is written through.
+*/
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+/**
+  Trace Data Structure
+
+  Writes a schedule as Chrome Trace Event JSON, which chrome://tracing and
+  Perfetto open.  Each core is a thread track of one process, with a further
+  track for events that belong to no core.  Events are written as they
+  happen, so memory does not grow with the length of the trace.  One time
+  unit is written as one microsecond.
+*/
+typedef struct _trace_t
+{
+    FILE* m_file;
+    char* m_buffer;
+    int m_cores;
+    int m_first;    // no event has been written yet
+} trace_t;
+
+
+int  trace_open   (trace_t *t, const char *file_name, int cores);
+
+void trace_slice  (trace_t *t, int core_id, int job_id, int start, int end);
+void trace_instant(trace_t *t, const char *name, int core_id, int job_id, int time);
+
+int  trace_close  (trace_t *t);
+
+#endif /* LIBTRACE_H_ */
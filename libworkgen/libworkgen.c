@@ -0,0 +1,400 @@
+/** @file libworkgen.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "libworkgen.h"
+
+#define WORKGEN_MAX_RUN_TIME 1000000000.0
+
+
+/**
+  Seeds the generator state from a single value with splitmix64.
+ */
+static void workgen_seed(workgen_t *g, uint64_t seed)
+{
+    int i;
+    for (i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        g->m_state[i] = z ^ (z >> 31);
+    }
+}
+
+
+static uint64_t workgen_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+
+/**
+  Returns the next 64 random bits (xoshiro256**).
+ */
+static uint64_t workgen_bits(workgen_t *g)
+{
+    uint64_t* s = g->m_state;
+    uint64_t result = workgen_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = workgen_rotl(s[3], 45);
+
+    return result;
+}
+
+
+/**
+  Returns a uniform random number in (0, 1].
+ */
+static double workgen_unit(workgen_t *g)
+{
+    return ((workgen_bits(g) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+
+/**
+  Returns a uniform random number in [0, 1).
+ */
+static double workgen_unit0(workgen_t *g)
+{
+    return (workgen_bits(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+/**
+  Parses up to count ':'-separated numbers.
+
+  @return the number of numbers parsed, or -1 on a malformed number
+ */
+static int workgen_parse_params(const char *text, double *params, int count)
+{
+    int parsed = 0;
+
+    while (*text != '\0' && parsed < count) {
+        char* end;
+        params[parsed++] = strtod(text, &end);
+        if (end == text || (*end != ':' && *end != '\0'))
+            return -1;
+        text = (*end == ':') ? end + 1 : end;
+    }
+
+    return (*text == '\0') ? parsed : -1;
+}
+
+
+/**
+  Parses a distribution such as "exp:10" into d, accepting only the kinds
+  listed in allowed (terminated by -1).
+
+  @return 0 on success, -1 if the distribution is unknown, not allowed or has bad parameters
+ */
+static int workgen_parse_dist(const char *text, workgen_dist_t *d, const int *allowed)
+{
+    static const struct { const char* name; workgen_kind_t kind; int params; } kinds[] = {
+        {"poisson", WORKGEN_POISSON, 1}, {"bursty", WORKGEN_BURSTY, 2},
+        {"const", WORKGEN_CONST, 1}, {"uniform", WORKGEN_UNIFORM, 2}, {"exp", WORKGEN_EXP, 1},
+        {"pareto", WORKGEN_PARETO, 2}, {"bimodal", WORKGEN_BIMODAL, 3}, {"weighted", WORKGEN_WEIGHTED, 0},
+    };
+    const char* colon = strchr(text, ':');
+    size_t length = (colon != NULL) ? (size_t)(colon - text) : strlen(text);
+    unsigned int i;
+
+    for (i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+        if (strlen(kinds[i].name) == length && strncmp(kinds[i].name, text, length) == 0)
+            break;
+    if (i == sizeof(kinds) / sizeof(kinds[0]) || colon == NULL)
+        return -1;
+
+    while (*allowed != -1 && *allowed != (int)kinds[i].kind)
+        allowed++;
+    if (*allowed == -1)
+        return -1;
+
+    d->m_kind = kinds[i].kind;
+    d->m_weight_count = 0;
+
+    if (d->m_kind == WORKGEN_WEIGHTED) {
+        const char* p = colon + 1;
+        double total = 0;
+
+        while (*p != '\0') {
+            char* end;
+            if (d->m_weight_count == WORKGEN_MAX_WEIGHTS)
+                return -1;
+            d->m_weights[d->m_weight_count] = strtod(p, &end);
+            if (end == p || d->m_weights[d->m_weight_count] < 0 || (*end != '/' && *end != '\0'))
+                return -1;
+            total += d->m_weights[d->m_weight_count++];
+            p = (*end == '/') ? end + 1 : end;
+        }
+        return (total > 0) ? 0 : -1;
+    }
+
+    if (workgen_parse_params(colon + 1, d->m_param, kinds[i].params) != kinds[i].params)
+        return -1;
+
+    switch (d->m_kind) {
+        case WORKGEN_POISSON:
+        case WORKGEN_EXP:
+            return (d->m_param[0] > 0) ? 0 : -1;
+        case WORKGEN_BURSTY:
+            return (d->m_param[0] > 0 && d->m_param[1] >= 1) ? 0 : -1;
+        case WORKGEN_UNIFORM:
+            return (d->m_param[0] <= d->m_param[1]) ? 0 : -1;
+        case WORKGEN_PARETO:
+            return (d->m_param[0] > 0 && d->m_param[1] > 0) ? 0 : -1;
+        case WORKGEN_BIMODAL:
+            return (d->m_param[0] > 0 && d->m_param[1] > 0 && d->m_param[2] >= 0 && d->m_param[2] <= 1) ? 0 : -1;
+        default:
+            return 0;
+    }
+}
+
+
+/**
+  Initializes a generator from a specification: a comma-separated list of
+  key=value settings, each optional.
+    n=<jobs>                    number of jobs (default 1000)
+    seed=<seed>                 random seed (default 1)
+    arrival=<distribution>      poisson:<rate> or bursty:<rate>:<mean burst size> (default poisson:0.1)
+    run=<distribution>          const:<t>, uniform:<lo>:<hi>, exp:<mean>, pareto:<alpha>:<min>
+                                or bimodal:<short>:<long>:<probability of long> (default exp:8)
+    priority=<distribution>     const:<p>, uniform:<lo>:<hi> or weighted:<w0>/<w1>/... (default uniform:0:9)
+    io=<bursts>:<mean wait>     split each run time into up to that many CPU bursts, separated by
+                                exponential I/O waits of that mean (default none)
+
+  @param g a pointer to an instance of the workgen_t data structure
+  @param spec the specification, eg: "n=100000,seed=7,arrival=bursty:0.2:8,run=pareto:1.5:2"
+  @return 0 on success
+  @return -1 if the specification is malformed
+ */
+int workgen_init(workgen_t *g, const char *spec)
+{
+    static const int arrivals[] = {WORKGEN_POISSON, WORKGEN_BURSTY, -1};
+    static const int runs[] = {WORKGEN_CONST, WORKGEN_UNIFORM, WORKGEN_EXP, WORKGEN_PARETO, WORKGEN_BIMODAL, -1};
+    static const int priorities[] = {WORKGEN_CONST, WORKGEN_UNIFORM, WORKGEN_WEIGHTED, -1};
+    unsigned long long seed = 1;
+    char setting[256];
+
+    g->m_count = 1000;
+    g->m_generated = 0;
+    g->m_clock = 0;
+    g->m_burst_left = 0;
+    g->m_burst_count = 0;
+    g->m_io_bursts = 1;
+    g->m_io_wait = 0;
+    workgen_parse_dist("poisson:0.1", &g->m_arrival, arrivals);
+    workgen_parse_dist("exp:8", &g->m_run, runs);
+    workgen_parse_dist("uniform:0:9", &g->m_priority, priorities);
+
+    while (*spec != '\0') {
+        size_t length = strcspn(spec, ",");
+        if (length >= sizeof(setting))
+            return -1;
+        memcpy(setting, spec, length);
+        setting[length] = '\0';
+        spec += length + (spec[length] == ',');
+
+        char* value = strchr(setting, '=');
+        char* end;
+        if (value == NULL)
+            return -1;
+        *value++ = '\0';
+
+        if (strcmp(setting, "n") == 0) {
+            g->m_count = strtoll(value, &end, 10);
+            if (end == value || *end != '\0' || g->m_count < 0 || g->m_count > INT_MAX)
+                return -1;
+        } else if (strcmp(setting, "seed") == 0) {
+            seed = strtoull(value, &end, 10);
+            if (end == value || *end != '\0')
+                return -1;
+        } else if (strcmp(setting, "arrival") == 0) {
+            if (workgen_parse_dist(value, &g->m_arrival, arrivals) != 0)
+                return -1;
+        } else if (strcmp(setting, "run") == 0) {
+            if (workgen_parse_dist(value, &g->m_run, runs) != 0)
+                return -1;
+        } else if (strcmp(setting, "priority") == 0) {
+            if (workgen_parse_dist(value, &g->m_priority, priorities) != 0)
+                return -1;
+        } else if (strcmp(setting, "io") == 0) {
+            double params[2];
+            if (workgen_parse_params(value, params, 2) != 2 || params[0] < 1 || params[0] > WORKGEN_MAX_BURSTS || params[1] <= 0)
+                return -1;
+            g->m_io_bursts = (int)params[0];
+            g->m_io_wait = params[1];
+        } else
+            return -1;
+    }
+
+    workgen_seed(g, seed);
+    return 0;
+}
+
+
+/**
+  Draws an integer uniformly from [lo, hi].
+ */
+static double workgen_uniform(workgen_t *g, double lo, double hi)
+{
+    return floor(lo) + floor(workgen_unit0(g) * (floor(hi) - floor(lo) + 1));
+}
+
+
+/**
+  Draws a run time of at least one time unit.
+ */
+static int workgen_run_time(workgen_t *g)
+{
+    workgen_dist_t* d = &g->m_run;
+    double run_time;
+
+    switch (d->m_kind) {
+        case WORKGEN_UNIFORM:
+            run_time = workgen_uniform(g, d->m_param[0], d->m_param[1]);
+            break;
+        case WORKGEN_EXP:
+            run_time = ceil(-log(workgen_unit(g)) * d->m_param[0]);
+            break;
+        case WORKGEN_PARETO:
+            run_time = floor(d->m_param[1] / pow(workgen_unit(g), 1.0 / d->m_param[0]));
+            break;
+        case WORKGEN_BIMODAL:
+            run_time = ceil((workgen_unit(g) <= d->m_param[2]) ? d->m_param[1] : d->m_param[0]);
+            break;
+        default:
+            run_time = ceil(d->m_param[0]);
+            break;
+    }
+
+    if (run_time < 1)
+        return 1;
+    return (run_time > WORKGEN_MAX_RUN_TIME) ? (int)WORKGEN_MAX_RUN_TIME : (int)run_time;
+}
+
+
+static int workgen_priority(workgen_t *g)
+{
+    workgen_dist_t* d = &g->m_priority;
+    int i;
+
+    if (d->m_kind == WORKGEN_UNIFORM)
+        return (int)workgen_uniform(g, d->m_param[0], d->m_param[1]);
+
+    if (d->m_kind == WORKGEN_WEIGHTED) {
+        double total = 0, pick;
+        for (i = 0; i < d->m_weight_count; i++)
+            total += d->m_weights[i];
+
+        pick = workgen_unit(g) * total;
+        for (i = 0; i < d->m_weight_count - 1; i++) {
+            if (pick <= d->m_weights[i])
+                break;
+            pick -= d->m_weights[i];
+        }
+        return i;
+    }
+
+    return (int)d->m_param[0];
+}
+
+
+/**
+  Splits a run time into CPU bursts as even as can be, separated by I/O
+  waits of at least one time unit, into m_bursts.
+ */
+static void workgen_bursts(workgen_t *g, int run_time)
+{
+    int count = (run_time < g->m_io_bursts) ? run_time : g->m_io_bursts;
+    int i;
+
+    g->m_burst_count = 0;
+    if (count < 2)
+        return;
+
+    for (i = 0; i < count; i++) {
+        if (i > 0) {
+            double wait = ceil(-log(workgen_unit(g)) * g->m_io_wait);
+            g->m_bursts[g->m_burst_count++] = (wait < 1) ? 1 : (wait > WORKGEN_MAX_RUN_TIME) ? (int)WORKGEN_MAX_RUN_TIME : (int)wait;
+        }
+        g->m_bursts[g->m_burst_count++] = run_time / count + (i < run_time % count);
+    }
+}
+
+
+/**
+  Generates the next job.  Arrival times never decrease.
+
+  Poisson arrivals are spaced by exponential gaps with mean 1/rate.  Bursty
+  arrivals come in bursts whose sizes are geometric with the given mean and
+  whose starts are Poisson with rate rate/size, so the long-run rate is the
+  same; every job of a burst arrives in the same time unit.
+
+  @param g a pointer to an instance of the workgen_t data structure
+  @param arrival_time set to the arrival time of the job
+  @param run_time set to the run time of the job
+  @param priority set to the priority of the job
+  @return 1 if a job was generated
+  @return 0 once n jobs have been generated, or if arrival times would overflow an int
+ */
+int workgen_next(workgen_t *g, int *arrival_time, int *run_time, int *priority)
+{
+    workgen_dist_t* arrival = &g->m_arrival;
+
+    if (g->m_generated == g->m_count)
+        return 0;
+
+    if (arrival->m_kind == WORKGEN_BURSTY) {
+        if (g->m_burst_left == 0) {
+            double size = arrival->m_param[1];
+
+            g->m_clock += -log(workgen_unit(g)) * size / arrival->m_param[0];
+            g->m_burst_left = 1;
+            if (size > 1)
+                g->m_burst_left += (long long)floor(log(workgen_unit(g)) / log(1 - 1 / size));
+        }
+        g->m_burst_left--;
+    } else
+        g->m_clock += -log(workgen_unit(g)) / arrival->m_param[0];
+
+    if (g->m_clock >= INT_MAX)
+        return 0;
+
+    *arrival_time = (int)g->m_clock;
+    *run_time = workgen_run_time(g);
+    *priority = workgen_priority(g);
+    if (g->m_io_bursts > 1)
+        workgen_bursts(g, *run_time);
+    g->m_generated++;
+    return 1;
+}
+
+
+/**
+  Prints the specification syntax accepted by workgen_init().
+
+  @param stream where to print
+ */
+void workgen_usage(FILE *stream)
+{
+    fprintf(stream, "Workload specifications are comma-separated settings, all optional:\n");
+    fprintf(stream, "  n=<jobs>                 number of jobs (default 1000)\n");
+    fprintf(stream, "  seed=<seed>              random seed (default 1)\n");
+    fprintf(stream, "  arrival=poisson:<rate>   or bursty:<rate>:<mean burst size> (default poisson:0.1)\n");
+    fprintf(stream, "  run=exp:<mean>           or const:<t>, uniform:<lo>:<hi>, pareto:<alpha>:<min>,\n");
+    fprintf(stream, "                           bimodal:<short>:<long>:<probability of long> (default exp:8)\n");
+    fprintf(stream, "  priority=uniform:<lo>:<hi> or const:<p>, weighted:<w0>/<w1>/... (default uniform:0:9)\n");
+    fprintf(stream, "  io=<bursts>:<mean wait>  split run times into up to that many CPU bursts, separated by\n");
+    fprintf(stream, "                           exponential I/O waits of that mean (default none)\n");
+}
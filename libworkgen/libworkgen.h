@@ -0,0 +1,65 @@
+/** @file libworkgen.h
+ */
+
+#ifndef LIBWORKGEN_H_
+#define LIBWORKGEN_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define WORKGEN_MAX_WEIGHTS 64
+#define WORKGEN_MAX_BURSTS  64
+
+/**
+  Distributions the generator can draw from
+*/
+typedef enum {WORKGEN_POISSON = 0, WORKGEN_BURSTY,
+              WORKGEN_CONST, WORKGEN_UNIFORM, WORKGEN_EXP, WORKGEN_PARETO, WORKGEN_BIMODAL,
+              WORKGEN_WEIGHTED} workgen_kind_t;
+
+/**
+  A distribution and its parameters
+*/
+typedef struct _workgen_dist_t
+{
+    workgen_kind_t m_kind;
+    double m_param[3];
+    double m_weights[WORKGEN_MAX_WEIGHTS];
+    int m_weight_count;
+} workgen_dist_t;
+
+/**
+  Workgen Data Structure
+
+  A seeded, deterministic source of synthetic jobs: the same specification
+  always yields the same jobs, in arrival order.
+
+  With io set, the run time of each job is split into up to m_io_bursts CPU
+  bursts separated by I/O waits; the bursts of the job last generated are
+  left in m_bursts (see workload_t), m_burst_count being 0 if it has one.
+*/
+typedef struct _workgen_t
+{
+    uint64_t m_state[4];
+    long long m_count;
+    long long m_generated;
+
+    workgen_dist_t m_arrival;
+    workgen_dist_t m_run;
+    workgen_dist_t m_priority;
+    int m_io_bursts;
+    double m_io_wait;
+
+    double m_clock;
+    long long m_burst_left;
+    int m_bursts[2 * WORKGEN_MAX_BURSTS - 1];
+    int m_burst_count;
+} workgen_t;
+
+
+int  workgen_init(workgen_t *g, const char *spec);
+int  workgen_next(workgen_t *g, int *arrival_time, int *run_time, int *priority);
+
+void workgen_usage(FILE *stream);
+
+#endif /* LIBWORKGEN_H_ */
@@ -0,0 +1,1136 @@
+/** @file libworkload.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libworkload.h"
+
+// Fault the whole file in up front rather than one page at a time
+#ifdef MAP_POPULATE
+#define WORKLOAD_MAP_FLAGS MAP_POPULATE
+#else
+#define WORKLOAD_MAP_FLAGS 0
+#endif
+
+
+/**
+  Initializes the workload_t data structure to an empty workload.
+
+  @param w a pointer to an instance of the workload_t data structure
+ */
+void workload_init(workload_t *w)
+{
+    w->m_count = 0;
+    w->m_arrival_time = NULL;
+    w->m_run_time = NULL;
+    w->m_priority = NULL;
+    w->m_cores = NULL;
+    w->m_burst_start = NULL;
+    w->m_bursts = NULL;
+    w->m_burst_capacity = 0;
+    w->m_dependency_start = NULL;
+    w->m_dependencies = NULL;
+    w->m_dependency_capacity = 0;
+    w->m_error_line = 0;
+    w->m_mapping = NULL;
+    w->m_mapping_length = 0;
+}
+
+
+/**
+  Allocates room for capacity jobs.
+
+  @return 0 on success, -1 if out of memory
+ */
+static int workload_reserve(workload_t *w, size_t capacity)
+{
+    if (capacity == 0)
+        capacity = 1;
+
+    w->m_arrival_time = malloc(capacity * sizeof(int));
+    w->m_run_time = malloc(capacity * sizeof(int));
+    w->m_priority = malloc(capacity * sizeof(int));
+
+    if (w->m_arrival_time == NULL || w->m_run_time == NULL || w->m_priority == NULL)
+        return -1;
+    return 0;
+}
+
+
+/**
+  Grows a list column, such as the bursts, to hold at least count values.
+
+  @return 0 on success, -1 if out of memory
+ */
+static int workload_reserve_list(int **values, size_t *capacity, size_t count)
+{
+    size_t grown_capacity = (*capacity > 0) ? *capacity : 1024;
+
+    if (count <= *capacity)
+        return 0;
+    while (grown_capacity < count)
+        grown_capacity *= 2;
+
+    int* grown = realloc(*values, grown_capacity * sizeof(int));
+    if (grown == NULL)
+        return -1;
+    *values = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+
+/**
+  Counts the lines of a buffer, including a last line with no newline.
+
+  @param last set to the first byte after the last newline
+ */
+static size_t workload_count_lines(const char *data, size_t length, const char **last)
+{
+    const char* end = data + length;
+    size_t lines = 0;
+
+    *last = data;
+    while (data < end) {
+        const char* newline = memchr(data, '\n', end - data);
+        lines++;
+        if (newline == NULL)
+            break;
+        data = newline + 1;
+        *last = data;
+    }
+
+    return lines;
+}
+
+
+/**
+  Parses a field holding a decimal integer, surrounded by optional blanks,
+  that is followed by the separator sep.  Fields that are neither signed nor
+  padded take a fast path with a single, well-predicted branch per digit.
+  The caller guarantees that the text ends in a newline, so the scan needs no
+  bounds checks.
+
+  @return a pointer past the separator on success
+  @return NULL if the field is not an integer that fits in an int
+ */
+static const char *workload_parse_field(const char *p, int *value, char sep)
+{
+    const char* digits = p;
+    unsigned int magnitude = 0, digit;
+
+    while ((digit = (unsigned char)*p - '0') < 10) {
+        magnitude = magnitude * 10 + digit;
+        p++;
+    }
+
+    if (*p == sep && p != digits && p - digits < 10) {
+        *value = (int)magnitude;
+        return p + 1;
+    }
+
+    // Slow path: blanks, a sign, ten digits or a malformed field
+    unsigned long long wide = 0;
+    int negative = 0;
+
+    p = digits;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+
+    digits = p;
+    while ((digit = (unsigned char)*p - '0') < 10 && p - digits <= 10) {
+        wide = wide * 10 + digit;
+        p++;
+    }
+
+    if (p == digits || p - digits > 10 || wide > (unsigned long long)INT_MAX + negative)
+        return NULL;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r')
+        p++;
+    if (*p != sep)
+        return NULL;
+
+    *value = negative ? (int)(-(long long)wide) : (int)wide;
+    return p + 1;
+}
+
+
+/**
+  Parses the last field of a line.  It is usually followed by the newline,
+  but may be followed by a carriage return or by further, ignored columns.
+
+  @return a pointer past the newline, or NULL if the field is malformed
+ */
+static const char *workload_parse_last_field(const char *p, const char *end, int *value)
+{
+    const char* q = workload_parse_field(p, value, '\n');
+    if (q == NULL) {
+        const char* eol = memchr(p, '\n', end - p);
+        const char* comma = memchr(p, ',', eol - p);
+        if (comma == NULL || workload_parse_field(p, value, ',') == NULL)
+            return NULL;
+        q = eol + 1;
+    }
+
+    return q;
+}
+
+
+/**
+  Parses a list of non-negative numbers separated by '/', which may be
+  empty, into (*values)[at] on, growing the list column as needed.
+
+  @return a pointer past the list and any blanks after it, or NULL if a
+  number does not fit in an int or the column could not be grown
+ */
+static const char *workload_parse_list(const char *p, int **values, size_t *capacity, size_t at, int *count)
+{
+    *count = 0;
+    while (*p == ' ' || *p == '\t')
+        p++;
+
+    while ((unsigned int)((unsigned char)*p - '0') < 10) {
+        long long value = 0;
+        while ((unsigned int)((unsigned char)*p - '0') < 10 && value <= INT_MAX)
+            value = value * 10 + (*p++ - '0');
+        if (value > INT_MAX || workload_reserve_list(values, capacity, at + *count + 1) != 0)
+            return NULL;
+
+        (*values)[at + (*count)++] = (int)value;
+
+        if (*p != '/')
+            break;
+        p++;
+    }
+
+    while (*p == ' ' || *p == '\t' || *p == '\r')
+        p++;
+    return p;
+}
+
+
+/**
+  Parses the list columns of the next job of w, its bursts and then its
+  dependencies (whichever w has), as the last fields of a line.  A single
+  burst is the whole run time and is not kept.
+
+  @return a pointer past the newline, or NULL if a field is malformed, the
+  CPU bursts do not add up to run_time or the lists could not be allocated
+ */
+static const char *workload_parse_lists(workload_t *w, const char *p, const char *end, int run_time)
+{
+    const char* eol = memchr(p, '\n', end - p);
+    int count, i;
+
+    if (w->m_burst_start != NULL) {
+        size_t at = w->m_burst_start[w->m_count];
+        long long cpu = 0;
+
+        if ((p = workload_parse_list(p, &w->m_bursts, &w->m_burst_capacity, at, &count)) == NULL)
+            return NULL;
+        for (i = 0; i < count; i += 2) {
+            if (w->m_bursts[at + i] == 0)
+                return NULL;
+            cpu += w->m_bursts[at + i];
+        }
+        if (count > 0 && (count % 2 == 0 || cpu != run_time))
+            return NULL;
+        w->m_burst_start[w->m_count + 1] = at + ((count > 1) ? count : 0);
+
+        if (w->m_dependency_start != NULL && *p++ != ',')
+            return NULL;
+    }
+
+    if (w->m_dependency_start != NULL) {
+        size_t at = w->m_dependency_start[w->m_count];
+
+        if ((p = workload_parse_list(p, &w->m_dependencies, &w->m_dependency_capacity, at, &count)) == NULL)
+            return NULL;
+        w->m_dependency_start[w->m_count + 1] = at + count;
+    }
+
+    if (*p != '\n' && *p != ',')
+        return NULL;
+    return eol + 1;
+}
+
+
+/**
+  Parses the newline-terminated line at *cursor, moving *cursor past it.
+
+  @param cores where to store the cores column, or NULL if the workload has none
+  @param lists the workload to add the bursts and dependencies columns to, or NULL if it has neither
+  @return 1 if the line held a job, 0 if it was blank, -1 if it was malformed
+ */
+static int workload_parse_line(const char **cursor, const char *end, int *arrival_time, int *run_time, int *priority, int *cores,
+        workload_t *lists)
+{
+    const char* p = *cursor;
+
+    if ((unsigned int)((unsigned char)*p - '0') >= 10) {
+        const char* blank = p;
+        while (*blank == ' ' || *blank == '\t' || *blank == '\r')
+            blank++;
+        if (*blank == '\n') {
+            *cursor = blank + 1;
+            return 0;
+        }
+    }
+
+    if ((p = workload_parse_field(p, arrival_time, ',')) == NULL ||
+            (p = workload_parse_field(p, run_time, ',')) == NULL)
+        return -1;
+
+    const char* q;
+    if (cores == NULL && lists == NULL)
+        q = workload_parse_last_field(p, end, priority);
+    else if ((p = workload_parse_field(p, priority, ',')) == NULL)
+        return -1;
+    else if (lists == NULL)
+        q = workload_parse_last_field(p, end, cores);
+    else if (cores != NULL && (p = workload_parse_field(p, cores, ',')) == NULL)
+        return -1;
+    else
+        q = workload_parse_lists(lists, p, end, *run_time);
+
+    if (q == NULL)
+        return -1;
+
+    *cursor = q;
+    return 1;
+}
+
+
+/**
+  Checks whether the header line of CSV text names a column, counted from
+  0, name, quoted or not.
+ */
+static int workload_has_column(const char *data, size_t length, int index, const char *name)
+{
+    const char* eol = memchr(data, '\n', length);
+    const char* end = (eol != NULL) ? eol : data + length;
+    const char* p = data;
+    int n = strlen(name);
+    int column;
+
+    for (column = 0; column < index; column++) {
+        p = memchr(p, ',', end - p);
+        if (p == NULL)
+            return 0;
+        p++;
+    }
+
+    while (p < end && (*p == ' ' || *p == '"'))
+        p++;
+    return end - p >= n && strncasecmp(p, name, n) == 0 &&
+        (end - p == n || p[n] == '"' || p[n] == ',' || p[n] == ' ' || p[n] == '\r');
+}
+
+
+/**
+  Returns the name of the first optional column the header line of CSV text
+  has, or NULL if it has none.
+ */
+static const char *workload_optional_column(const char *data, size_t length)
+{
+    if (workload_has_column(data, length, 3, "Cores"))
+        return "Cores";
+    if (workload_has_column(data, length, 3, "Bursts"))
+        return "Bursts";
+    if (workload_has_column(data, length, 3, "Dependencies"))
+        return "Dependencies";
+    return NULL;
+}
+
+
+/**
+  Parses newline-terminated lines of jobs into w.
+
+  @return the number of the last line parsed, negated if it was malformed
+ */
+static int workload_parse_lines(workload_t *w, const char *p, const char *end, int line)
+{
+    while (p < end) {
+        int n = w->m_count;
+        line++;
+
+        switch (workload_parse_line(&p, end, &w->m_arrival_time[n], &w->m_run_time[n], &w->m_priority[n],
+                    (w->m_cores != NULL) ? &w->m_cores[n] : NULL, (w->m_burst_start != NULL || w->m_dependency_start != NULL) ? w : NULL)) {
+            case 1:
+                w->m_count++;
+                break;
+            case -1:
+                return -line;
+        }
+    }
+
+    return line;
+}
+
+
+/**
+  Parses a workload from CSV text already in memory.
+
+  Every line after the header holds the arrival time, run time and
+  priority of one job.  The header is otherwise ignored, except that it
+  names the optional columns that may follow the priority, in this order:
+
+  - "Cores", read into m_cores (only as the fourth column);
+  - "Bursts", read into m_bursts, such as 3/10/2 for 3 time units of CPU,
+    an I/O wait of 10 and 2 more of CPU, or nothing for a job without I/O;
+  - "Dependencies", read into m_dependencies, such as 0/4, or nothing.
+
+  Further columns are ignored, as are blank lines.  The job arrays are sized
+  by counting lines first, so they are never grown, and the text is parsed
+  in place in a single pass.
+
+  @param w a pointer to an initialized, empty instance of the workload_t data structure
+  @param data the CSV text
+  @param length the length of data in bytes
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_FORMAT if a line is malformed; its line number is stored in m_error_line
+  @return WORKLOAD_ERROR_MEMORY if the jobs could not be allocated
+ */
+workload_status_t workload_parse_csv(workload_t *w, const char *data, size_t length)
+{
+    const char* end = data + length;
+    const char* last;
+    const char* p;
+    int line;
+    size_t lines = workload_count_lines(data, length, &last);
+
+    if (workload_reserve(w, lines) != 0)
+        return WORKLOAD_ERROR_MEMORY;
+    if (workload_has_column(data, length, 3, "Cores") && (w->m_cores = malloc((lines > 0 ? lines : 1) * sizeof(int))) == NULL)
+        return WORKLOAD_ERROR_MEMORY;
+    if (workload_has_column(data, length, (w->m_cores != NULL) ? 4 : 3, "Bursts")) {
+        if ((w->m_burst_start = malloc((lines + 1) * sizeof(int))) == NULL)
+            return WORKLOAD_ERROR_MEMORY;
+        w->m_burst_start[0] = 0;
+    }
+    if (workload_has_column(data, length, 3 + (w->m_cores != NULL) + (w->m_burst_start != NULL), "Dependencies")) {
+        if ((w->m_dependency_start = malloc((lines + 1) * sizeof(int))) == NULL)
+            return WORKLOAD_ERROR_MEMORY;
+        w->m_dependency_start[0] = 0;
+    }
+
+    // Ignore the first (header) line
+    p = memchr(data, '\n', length);
+    if (p == NULL)
+        return WORKLOAD_OK;
+    p++;
+
+    // Every line before last ends in a newline; a final unterminated line
+    // is copied out and given one.
+    line = workload_parse_lines(w, p, last, 1);
+
+    if (line > 0 && last < end) {
+        char* tail = malloc(end - last + 1);
+        if (tail == NULL)
+            return WORKLOAD_ERROR_MEMORY;
+
+        memcpy(tail, last, end - last);
+        tail[end - last] = '\n';
+        line = workload_parse_lines(w, tail, tail + (end - last) + 1, line);
+        free(tail);
+    }
+
+    if (line < 0) {
+        w->m_error_line = -line;
+        return WORKLOAD_ERROR_FORMAT;
+    }
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Reads a little-endian unsigned integer of width bytes.
+ */
+static uint64_t workload_get_le(const unsigned char *p, int width)
+{
+    uint64_t value = 0;
+    while (width-- > 0)
+        value = (value << 8) | p[width];
+    return value;
+}
+
+
+/**
+  Writes a little-endian unsigned integer of width bytes.
+ */
+static void workload_put_le(unsigned char *p, uint64_t value, int width)
+{
+    int i;
+    for (i = 0; i < width; i++, value >>= 8)
+        p[i] = (unsigned char)value;
+}
+
+
+static int workload_little_endian(void)
+{
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one;
+}
+
+
+/**
+  Checks whether a buffer starts with the magic of a binary workload file.
+ */
+static int workload_is_binary(const void *data, size_t length)
+{
+    return length >= sizeof(workload_header_t) && memcmp(data, WORKLOAD_MAGIC, 8) == 0;
+}
+
+
+/**
+  Points w at the columns of a binary workload held in data, validating the
+  header and column descriptors against the length of the file.  When
+  data is in host byte order and suitably aligned, the columns are used in
+  place; otherwise (big-endian hosts, or unaligned buffers) they are copied.
+
+  @param in_place set to nonzero if the columns point into data
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_FORMAT if the file is truncated, of another version, or misses a column
+  (the cores column is optional)
+  @return WORKLOAD_ERROR_MEMORY if the columns had to be copied and could not be allocated
+ */
+static workload_status_t workload_parse_binary(workload_t *w, const void *data, size_t length, int *in_place)
+{
+    const unsigned char* bytes = data;
+    const unsigned char* columns[4] = {NULL, NULL, NULL, NULL};
+    uint32_t version = (uint32_t)workload_get_le(bytes + 8, 4);
+    uint32_t column_count = (uint32_t)workload_get_le(bytes + 12, 4);
+    uint64_t job_count = workload_get_le(bytes + 16, 8);
+    uint32_t i;
+
+    *in_place = 0;
+    if (version != WORKLOAD_VERSION || job_count > INT_MAX ||
+            column_count > (length - sizeof(workload_header_t)) / sizeof(workload_column_t))
+        return WORKLOAD_ERROR_FORMAT;
+
+    for (i = 0; i < column_count; i++) {
+        const unsigned char* descriptor = bytes + sizeof(workload_header_t) + i * sizeof(workload_column_t);
+        uint32_t id = (uint32_t)workload_get_le(descriptor, 4);
+        uint32_t width = (uint32_t)workload_get_le(descriptor + 4, 4);
+        uint64_t offset = workload_get_le(descriptor + 8, 8);
+
+        if (width == 0 || offset > length || job_count > (length - offset) / width)
+            return WORKLOAD_ERROR_FORMAT;
+
+        if (id >= WORKLOAD_COLUMN_ARRIVAL_TIME && id <= WORKLOAD_COLUMN_CORES) {
+            if (width != sizeof(int32_t))
+                return WORKLOAD_ERROR_FORMAT;
+            columns[id - WORKLOAD_COLUMN_ARRIVAL_TIME] = bytes + offset;
+        }
+    }
+
+    if (columns[0] == NULL || columns[1] == NULL || columns[2] == NULL)
+        return WORKLOAD_ERROR_FORMAT;
+
+    w->m_count = (int)job_count;
+
+    if (workload_little_endian() && sizeof(int) == sizeof(int32_t) &&
+            ((uintptr_t)columns[0] | (uintptr_t)columns[1] | (uintptr_t)columns[2] | (uintptr_t)columns[3]) % sizeof(int) == 0) {
+        w->m_arrival_time = (int*)columns[0];
+        w->m_run_time = (int*)columns[1];
+        w->m_priority = (int*)columns[2];
+        w->m_cores = (int*)columns[3];
+        *in_place = 1;
+        return WORKLOAD_OK;
+    }
+
+    if (workload_reserve(w, w->m_count) != 0)
+        return WORKLOAD_ERROR_MEMORY;
+    if (columns[3] != NULL && (w->m_cores = malloc((w->m_count > 0 ? w->m_count : 1) * sizeof(int))) == NULL)
+        return WORKLOAD_ERROR_MEMORY;
+
+    int j;
+    for (j = 0; j < w->m_count; j++) {
+        w->m_arrival_time[j] = (int32_t)workload_get_le(columns[0] + 4 * j, 4);
+        w->m_run_time[j] = (int32_t)workload_get_le(columns[1] + 4 * j, 4);
+        w->m_priority[j] = (int32_t)workload_get_le(columns[2] + 4 * j, 4);
+        if (columns[3] != NULL)
+            w->m_cores[j] = (int32_t)workload_get_le(columns[3] + 4 * j, 4);
+    }
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Opens a workload file for reading; "-" is the standard input.
+
+  @return a file descriptor, or -1 on failure
+ */
+static int workload_open(const char *file_name)
+{
+    if (strcmp(file_name, "-") == 0)
+        return dup(STDIN_FILENO);
+    return open(file_name, O_RDONLY);
+}
+
+
+/**
+  Loads a workload from a file, mapping it into memory if possible and
+  reading it into a buffer otherwise (for pipes and the like).
+
+  @param detect nonzero to accept binary workload files as well as CSV
+ */
+static workload_status_t workload_load_file(workload_t *w, const char *file_name, int detect)
+{
+    struct stat st;
+    workload_status_t status;
+    int in_place = 0;
+
+    int fd = workload_open(file_name);
+    if (fd == -1)
+        return WORKLOAD_ERROR_OPEN;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            close(fd);
+            return (workload_reserve(w, 0) == 0) ? WORKLOAD_OK : WORKLOAD_ERROR_MEMORY;
+        }
+
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | WORKLOAD_MAP_FLAGS, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+
+            if (detect && workload_is_binary(data, st.st_size)) {
+                status = workload_parse_binary(w, data, st.st_size, &in_place);
+                if (status == WORKLOAD_OK && in_place) {
+                    // The columns live in the mapping, which is kept until workload_destroy()
+                    w->m_mapping = data;
+                    w->m_mapping_length = st.st_size;
+                    return status;
+                }
+            } else {
+                madvise(data, st.st_size, MADV_SEQUENTIAL);
+                status = workload_parse_csv(w, data, st.st_size);
+            }
+
+            munmap(data, st.st_size);
+            return status;
+        }
+    }
+
+    size_t length = 0, size = 1 << 16;
+    char* buffer = malloc(size);
+    ssize_t got;
+
+    while (buffer != NULL && (got = read(fd, buffer + length, size - length)) > 0) {
+        length += got;
+        if (length == size) {
+            char* grown = realloc(buffer, size * 2);
+            if (grown == NULL)
+                free(buffer);
+            buffer = grown;
+            size *= 2;
+        }
+    }
+    close(fd);
+
+    if (buffer == NULL)
+        return WORKLOAD_ERROR_MEMORY;
+
+    if (detect && workload_is_binary(buffer, length)) {
+        status = workload_parse_binary(w, buffer, length, &in_place);
+        if (status == WORKLOAD_OK && in_place) {
+            // Used in place; keep the buffer rather than copying it again
+            w->m_mapping = buffer;
+            w->m_mapping_length = 0;
+            return status;
+        }
+    } else
+        status = workload_parse_csv(w, buffer, length);
+
+    free(buffer);
+    return status;
+}
+
+
+/**
+  Loads a workload from a file that is either in the binary workload format
+  (recognized by its leading WORKLOAD_MAGIC) or CSV (see workload_load_csv()).
+
+  Binary files need no parsing: on little-endian hosts the file is mapped
+  and its columns are used in place until workload_destroy().
+
+  @param w a pointer to an initialized, empty instance of the workload_t data structure
+  @param file_name the path of the workload file, or "-" for the standard input
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_OPEN if the file could not be opened or read
+  @return WORKLOAD_ERROR_FORMAT if the file is malformed; for CSV, the line number is stored in m_error_line
+  @return WORKLOAD_ERROR_MEMORY if the jobs could not be allocated
+ */
+workload_status_t workload_load(workload_t *w, const char *file_name)
+{
+    return workload_load_file(w, file_name, 1);
+}
+
+
+/**
+  Loads a workload from a CSV file (see workload_parse_csv()).
+
+  The file is mapped into memory and parsed in place rather than read line
+  by line.  Inputs that cannot be mapped, such as pipes, are read into a
+  buffer instead.
+
+  @param w a pointer to an initialized, empty instance of the workload_t data structure
+  @param file_name the path of the CSV file, or "-" for the standard input
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_OPEN if the file could not be opened or read
+  @return WORKLOAD_ERROR_FORMAT if a line is malformed; its line number is stored in m_error_line
+  @return WORKLOAD_ERROR_MEMORY if the jobs could not be allocated
+ */
+workload_status_t workload_load_csv(workload_t *w, const char *file_name)
+{
+    return workload_load_file(w, file_name, 0);
+}
+
+
+/**
+  Fills a workload with synthetic jobs drawn by a generator (see
+  workgen_init()), and with their bursts if the generator splits them.
+
+  @param w a pointer to an initialized, empty instance of the workload_t data structure
+  @param spec the generator specification
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_FORMAT if the specification is malformed
+  @return WORKLOAD_ERROR_MEMORY if the jobs could not be allocated
+ */
+workload_status_t workload_generate(workload_t *w, const char *spec)
+{
+    workgen_t generator;
+
+    if (workgen_init(&generator, spec) != 0)
+        return WORKLOAD_ERROR_FORMAT;
+    if (workload_reserve(w, generator.m_count) != 0)
+        return WORKLOAD_ERROR_MEMORY;
+    if (generator.m_io_bursts > 1) {
+        if ((w->m_burst_start = malloc((generator.m_count + 1) * sizeof(int))) == NULL)
+            return WORKLOAD_ERROR_MEMORY;
+        w->m_burst_start[0] = 0;
+    }
+
+    while (workgen_next(&generator, &w->m_arrival_time[w->m_count], &w->m_run_time[w->m_count], &w->m_priority[w->m_count])) {
+        if (w->m_burst_start != NULL) {
+            int at = w->m_burst_start[w->m_count];
+            if (workload_reserve_list(&w->m_bursts, &w->m_burst_capacity, at + generator.m_burst_count) != 0)
+                return WORKLOAD_ERROR_MEMORY;
+            memcpy(&w->m_bursts[at], generator.m_bursts, generator.m_burst_count * sizeof(int));
+            w->m_burst_start[w->m_count + 1] = at + generator.m_burst_count;
+        }
+        w->m_count++;
+    }
+
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Writes a workload in the binary workload format: the header, one
+  descriptor per column, and the columns as 8-byte aligned little-endian
+  arrays of 32-bit integers.  The cores column is written only if the
+  workload has one.  Bursts and dependencies have no column in the format,
+  so a workload with either is not written.
+
+  @param w a pointer to an instance of the workload_t data structure
+  @param file_name the path of the file to create
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_OPEN if the file could not be created
+  @return WORKLOAD_ERROR_WRITE if the file could not be written
+  @return WORKLOAD_ERROR_FORMAT if the workload has bursts or dependencies
+ */
+workload_status_t workload_save_binary(workload_t *w, const char *file_name)
+{
+    const int* columns[4] = {w->m_arrival_time, w->m_run_time, w->m_priority, w->m_cores};
+    int column_count = (w->m_cores != NULL) ? 4 : 3;
+    unsigned char header[sizeof(workload_header_t) + 4 * sizeof(workload_column_t)];
+    size_t header_length = sizeof(workload_header_t) + column_count * sizeof(workload_column_t);
+    uint64_t column_length = ((uint64_t)w->m_count * sizeof(int32_t) + 7) & ~(uint64_t)7;
+    int i, j;
+
+    if (w->m_burst_start != NULL || w->m_dependency_start != NULL)
+        return WORKLOAD_ERROR_FORMAT;
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, WORKLOAD_MAGIC, 8);
+    workload_put_le(header + 8, WORKLOAD_VERSION, 4);
+    workload_put_le(header + 12, column_count, 4);
+    workload_put_le(header + 16, w->m_count, 8);
+
+    for (i = 0; i < column_count; i++) {
+        unsigned char* descriptor = header + sizeof(workload_header_t) + i * sizeof(workload_column_t);
+        workload_put_le(descriptor, WORKLOAD_COLUMN_ARRIVAL_TIME + i, 4);
+        workload_put_le(descriptor + 4, sizeof(int32_t), 4);
+        workload_put_le(descriptor + 8, header_length + i * column_length, 8);
+    }
+
+    FILE* file = fopen(file_name, "wb");
+    if (file == NULL)
+        return WORKLOAD_ERROR_OPEN;
+
+    int failed = (fwrite(header, header_length, 1, file) != 1);
+
+    for (i = 0; i < column_count && !failed; i++) {
+        static const unsigned char padding[8];
+
+        if (workload_little_endian() && sizeof(int) == sizeof(int32_t))
+            failed = (fwrite(columns[i], sizeof(int32_t), w->m_count, file) != (size_t)w->m_count);
+        else {
+            for (j = 0; j < w->m_count && !failed; j++) {
+                unsigned char element[4];
+                workload_put_le(element, (uint32_t)columns[i][j], 4);
+                failed = (fwrite(element, 4, 1, file) != 1);
+            }
+        }
+
+        size_t pad = column_length - (uint64_t)w->m_count * sizeof(int32_t);
+        if (!failed && pad > 0)
+            failed = (fwrite(padding, 1, pad, file) != pad);
+    }
+
+    if (fclose(file) != 0)
+        failed = 1;
+
+    return failed ? WORKLOAD_ERROR_WRITE : WORKLOAD_OK;
+}
+
+
+/**
+  Frees all the memory associated with w.
+
+  @param w a pointer to an instance of the workload_t data structure
+ */
+void workload_destroy(workload_t *w)
+{
+    if (w->m_mapping == NULL) {
+        free(w->m_arrival_time);
+        free(w->m_run_time);
+        free(w->m_priority);
+        free(w->m_cores);
+    } else if (w->m_mapping_length > 0)
+        munmap(w->m_mapping, w->m_mapping_length);
+    else
+        free(w->m_mapping);
+    free(w->m_burst_start);
+    free(w->m_bursts);
+    free(w->m_dependency_start);
+    free(w->m_dependencies);
+
+    workload_init(w);
+}
+
+
+/**
+  Resets a reader to read nothing.
+ */
+static void workload_reader_init(workload_reader_t *r)
+{
+    r->m_fd = -1;
+    r->m_buffer = NULL;
+    r->m_size = 1 << 16;
+    r->m_start = r->m_end = 0;
+    r->m_eof = 0;
+    r->m_line = 0;
+    r->m_error_line = 0;
+    r->m_column = NULL;
+    r->m_next = 0;
+    r->m_threaded = 0;
+    atomic_init(&r->m_stop, 0);
+    r->m_final = WORKLOAD_OK;
+    r->m_generating = 0;
+    workload_init(&r->m_binary);
+}
+
+
+/**
+  Opens a workload for reading one job at a time.  Regular files in the
+  binary workload format are mapped; anything else is read as CSV.
+
+  @param r a pointer to an instance of the workload_reader_t data structure
+  @param file_name the path of the workload file, or "-" for the standard input
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_OPEN if the file could not be opened
+  @return WORKLOAD_ERROR_FORMAT if a binary workload is malformed
+  @return WORKLOAD_ERROR_MEMORY if the buffer could not be allocated
+  @return WORKLOAD_ERROR_COLUMN if a binary workload has a column the reader cannot hand over
+ */
+workload_status_t workload_reader_open(workload_reader_t *r, const char *file_name)
+{
+    char magic[8];
+    struct stat st;
+
+    workload_reader_init(r);
+
+    r->m_fd = workload_open(file_name);
+    if (r->m_fd == -1)
+        return WORKLOAD_ERROR_OPEN;
+
+    if (fstat(r->m_fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            pread(r->m_fd, magic, 8, 0) == 8 && memcmp(magic, WORKLOAD_MAGIC, 8) == 0) {
+        close(r->m_fd);
+        r->m_fd = -1;
+
+        workload_status_t status = workload_load(&r->m_binary, file_name);
+        if (status == WORKLOAD_OK && r->m_binary.m_cores != NULL) {
+            r->m_column = "Cores";
+            return WORKLOAD_ERROR_COLUMN;
+        }
+        return status;
+    }
+
+    r->m_buffer = malloc(r->m_size);
+    return (r->m_buffer != NULL) ? WORKLOAD_OK : WORKLOAD_ERROR_MEMORY;
+}
+
+
+/**
+  Opens a reader over synthetic jobs drawn by a generator (see
+  workgen_init()) rather than over a file.
+
+  @param r a pointer to an instance of the workload_reader_t data structure
+  @param spec the generator specification
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_FORMAT if the specification is malformed
+  @return WORKLOAD_ERROR_COLUMN if the generator splits jobs into bursts, which the reader cannot hand over
+ */
+workload_status_t workload_reader_generate(workload_reader_t *r, const char *spec)
+{
+    workload_reader_init(r);
+
+    if (workgen_init(&r->m_generator, spec) != 0)
+        return WORKLOAD_ERROR_FORMAT;
+    if (r->m_generator.m_io_bursts > 1) {
+        r->m_column = "Bursts";
+        return WORKLOAD_ERROR_COLUMN;
+    }
+
+    r->m_generating = 1;
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Makes sure the buffer holds a whole line, reading more input as needed.
+
+  @return a pointer to the newline ending the first buffered line
+  @return NULL at the end of the input
+ */
+static char *workload_reader_fill(workload_reader_t *r)
+{
+    for (;;) {
+        char* eol = memchr(r->m_buffer + r->m_start, '\n', r->m_end - r->m_start);
+        if (eol != NULL)
+            return eol;
+
+        if (r->m_eof) {
+            if (r->m_start == r->m_end)
+                return NULL;
+            // Terminate a last line that has no newline
+            r->m_buffer[r->m_end++] = '\n';
+            continue;
+        }
+
+        memmove(r->m_buffer, r->m_buffer + r->m_start, r->m_end - r->m_start);
+        r->m_end -= r->m_start;
+        r->m_start = 0;
+
+        // Leave room for a terminating newline
+        if (r->m_end + 1 >= r->m_size) {
+            char* grown = realloc(r->m_buffer, r->m_size * 2);
+            if (grown == NULL)
+                return NULL;
+            r->m_buffer = grown;
+            r->m_size *= 2;
+        }
+
+        ssize_t got = read(r->m_fd, r->m_buffer + r->m_end, r->m_size - r->m_end - 1);
+        if (got <= 0)
+            r->m_eof = 1;
+        else
+            r->m_end += got;
+    }
+}
+
+
+/**
+  Reads the next job from the input itself (see workload_reader_next()).
+ */
+static workload_status_t workload_reader_read(workload_reader_t *r, int *arrival_time, int *run_time, int *priority)
+{
+    if (r->m_column != NULL)
+        return WORKLOAD_ERROR_COLUMN;
+    if (r->m_generating)
+        return workgen_next(&r->m_generator, arrival_time, run_time, priority) ? WORKLOAD_OK : WORKLOAD_END;
+
+    if (r->m_buffer == NULL) {
+        if (r->m_next == r->m_binary.m_count)
+            return WORKLOAD_END;
+
+        *arrival_time = r->m_binary.m_arrival_time[r->m_next];
+        *run_time = r->m_binary.m_run_time[r->m_next];
+        *priority = r->m_binary.m_priority[r->m_next];
+        r->m_next++;
+        return WORKLOAD_OK;
+    }
+
+    for (;;) {
+        char* eol = workload_reader_fill(r);
+        if (eol == NULL)
+            return r->m_eof ? WORKLOAD_END : WORKLOAD_ERROR_MEMORY;
+
+        const char* p = r->m_buffer + r->m_start;
+        if (++r->m_line == 1 && (r->m_column = workload_optional_column(p, eol + 1 - p)) != NULL)
+            return WORKLOAD_ERROR_COLUMN;
+        int parsed = (r->m_line == 1) ? 0 : workload_parse_line(&p, eol + 1, arrival_time, run_time, priority, NULL, NULL);
+
+        r->m_start = eol + 1 - r->m_buffer;
+
+        if (parsed == 1)
+            return WORKLOAD_OK;
+        if (parsed == -1) {
+            r->m_error_line = r->m_line;
+            return WORKLOAD_ERROR_FORMAT;
+        }
+    }
+}
+
+
+/**
+  A job, or the end of the workload, as handed from the loader thread to the
+  reader's user.
+*/
+typedef struct _workload_record_t
+{
+    int m_arrival_time, m_run_time, m_priority;
+    int m_status, m_error_line;
+} workload_record_t;
+
+
+/**
+  Body of the loader thread: reads jobs into the ring until the end of the
+  workload or an error, which is passed on as the last record.  When the
+  ring is full the thread yields until there is room (or the reader is
+  closed).
+ */
+static void *workload_reader_loader(void *arg)
+{
+    workload_reader_t* r = arg;
+    workload_record_t record;
+
+    do {
+        record.m_status = workload_reader_read(r, &record.m_arrival_time, &record.m_run_time, &record.m_priority);
+        record.m_error_line = r->m_error_line;
+
+        while (ring_push(&r->m_ring, &record) != 0) {
+            if (atomic_load_explicit(&r->m_stop, memory_order_relaxed))
+                return NULL;
+            sched_yield();
+        }
+    } while (record.m_status == WORKLOAD_OK);
+
+    return NULL;
+}
+
+
+/**
+  Moves reading and parsing to a loader thread, so that they overlap with
+  whatever the caller does between calls to workload_reader_next().  The
+  loader runs ahead by at most capacity jobs.
+
+  @param r a pointer to an open instance of the workload_reader_t data structure
+  @param capacity the number of parsed jobs the loader may buffer
+  @return WORKLOAD_OK on success
+  @return WORKLOAD_ERROR_MEMORY if the ring or the thread could not be created
+ */
+workload_status_t workload_reader_start(workload_reader_t *r, size_t capacity)
+{
+    if (ring_init(&r->m_ring, capacity, sizeof(workload_record_t)) != 0)
+        return WORKLOAD_ERROR_MEMORY;
+
+    if (pthread_create(&r->m_thread, NULL, workload_reader_loader, r) != 0) {
+        ring_destroy(&r->m_ring);
+        return WORKLOAD_ERROR_MEMORY;
+    }
+
+    r->m_threaded = 1;
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Reads the next job of a workload, in file order.  For CSV the header line
+  and blank lines are skipped.  With a loader thread, this waits until the
+  loader has parsed the job.
+
+  @param r a pointer to an open instance of the workload_reader_t data structure
+  @param arrival_time set to the arrival time of the job
+  @param run_time set to the run time of the job
+  @param priority set to the priority of the job
+  @return WORKLOAD_OK if a job was read
+  @return WORKLOAD_END at the end of the workload
+  @return WORKLOAD_ERROR_FORMAT if a line is malformed; its line number is stored in m_error_line
+  @return WORKLOAD_ERROR_MEMORY if a line is too long to buffer
+  @return WORKLOAD_ERROR_COLUMN if the header names a column the reader cannot hand over; m_column names it
+ */
+workload_status_t workload_reader_next(workload_reader_t *r, int *arrival_time, int *run_time, int *priority)
+{
+    workload_record_t record;
+
+    if (!r->m_threaded)
+        return workload_reader_read(r, arrival_time, run_time, priority);
+    if (r->m_final != WORKLOAD_OK)
+        return r->m_final;
+
+    while (ring_pop(&r->m_ring, &record) != 0)
+        sched_yield();
+
+    if (record.m_status != WORKLOAD_OK) {
+        // The loader has stopped; keep returning its final status
+        r->m_error_line = record.m_error_line;
+        r->m_final = record.m_status;
+        return record.m_status;
+    }
+
+    *arrival_time = record.m_arrival_time;
+    *run_time = record.m_run_time;
+    *priority = record.m_priority;
+    return WORKLOAD_OK;
+}
+
+
+/**
+  Closes a workload reader and frees its memory.
+
+  @param r a pointer to an instance of the workload_reader_t data structure
+ */
+void workload_reader_close(workload_reader_t *r)
+{
+    if (r->m_threaded) {
+        atomic_store(&r->m_stop, 1);
+        pthread_join(r->m_thread, NULL);
+        ring_destroy(&r->m_ring);
+        r->m_threaded = 0;
+    }
+
+    if (r->m_fd != -1)
+        close(r->m_fd);
+    free(r->m_buffer);
+    workload_destroy(&r->m_binary);
+
+    r->m_fd = -1;
+    r->m_buffer = NULL;
+}
@@ -0,0 +1,166 @@
+/** @file libworkload.h
+ */
+
+#ifndef LIBWORKLOAD_H_
+#define LIBWORKLOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "../libring/libring.h"
+#include "../libworkgen/libworkgen.h"
+
+/**
+  Binary workload files start with these eight bytes.
+*/
+#define WORKLOAD_MAGIC    "SCHEDWKL"
+#define WORKLOAD_VERSION  1
+
+/**
+  Column identifiers of the binary workload format.  Readers skip columns
+  they do not know, so new columns can be added without a new version.
+*/
+#define WORKLOAD_COLUMN_ARRIVAL_TIME  1
+#define WORKLOAD_COLUMN_RUN_TIME      2
+#define WORKLOAD_COLUMN_PRIORITY      3
+#define WORKLOAD_COLUMN_CORES         4
+
+/**
+  Results of loading a workload
+
+  WORKLOAD_ERROR_COLUMN is only returned by readers, for a workload with an
+  optional column they cannot hand over (see workload_reader_t).
+*/
+typedef enum {WORKLOAD_OK = 0, WORKLOAD_ERROR_OPEN, WORKLOAD_ERROR_FORMAT, WORKLOAD_ERROR_MEMORY, WORKLOAD_ERROR_WRITE, WORKLOAD_END,
+              WORKLOAD_ERROR_COLUMN} workload_status_t;
+
+/**
+  Header of a binary workload file
+
+  All fields are little-endian.  The header is followed by m_column_count
+  column descriptors and then by the columns themselves.
+*/
+typedef struct _workload_header_t
+{
+    char     m_magic[8];
+    uint32_t m_version;
+    uint32_t m_column_count;
+    uint64_t m_job_count;
+} workload_header_t;
+
+/**
+  Column descriptor of a binary workload file
+
+  A column is a contiguous array of m_job_count little-endian elements of
+  m_width bytes, starting m_offset bytes into the file.
+*/
+typedef struct _workload_column_t
+{
+    uint32_t m_id;
+    uint32_t m_width;
+    uint64_t m_offset;
+} workload_column_t;
+
+/**
+  Workload Data Structure
+
+  Jobs are stored column by column; job i arrives at m_arrival_time[i],
+  runs for m_run_time[i] time units and has priority m_priority[i].  When
+  a binary file is mapped, the columns point into m_mapping.
+
+  Parallel jobs need m_cores[i] cores at once.  The cores column is
+  optional; m_cores is NULL if the workload has none, and every job then
+  needs a single core.
+
+  Jobs may also alternate CPU bursts with I/O waits.  The bursts column is
+  optional too; m_burst_start is NULL if the workload has none.  Otherwise
+  the bursts of job i are m_bursts[m_burst_start[i]] up to, not including,
+  m_bursts[m_burst_start[i + 1]]: a CPU burst, then an I/O wait and a CPU
+  burst in turn, the CPU bursts adding up to its run time.  A job without
+  bursts runs for its run time in one go.
+
+  Jobs may depend on others, given by their place in the workload, counted
+  from 0.  The dependencies column is optional as well; m_dependency_start is
+  NULL if the workload has none, and otherwise indexes m_dependencies as
+  m_burst_start does m_bursts.  A job is only ready once every job it
+  depends on has finished.
+*/
+typedef struct _workload_t
+{
+    int m_count;
+    int* m_arrival_time;
+    int* m_run_time;
+    int* m_priority;
+    int* m_cores;
+    int* m_burst_start;
+    int* m_bursts;
+    size_t m_burst_capacity;
+    int* m_dependency_start;
+    int* m_dependencies;
+    size_t m_dependency_capacity;
+
+    int m_error_line;
+
+    void* m_mapping;
+    size_t m_mapping_length;
+} workload_t;
+
+/**
+  Workload Reader Data Structure
+
+  Reads the jobs of a workload one at a time.  CSV input is read through a
+  buffer that only grows to the longest line, so a reader can follow pipes
+  and traces of any length.  Binary workloads are mapped and walked in place.
+
+  A reader can also draw jobs from a generator instead of a file.
+
+  A reader only hands over the arrival time, run time and priority of each
+  job.  Rather than drop the cores of parallel jobs, the bursts of jobs with
+  I/O or the dependencies of jobs, it stops with WORKLOAD_ERROR_COLUMN on a
+  workload that has them, and m_column names the column.
+
+  Once workload_reader_start() is called, a loader thread does the reading
+  and parsing, handing jobs over through m_ring.
+*/
+typedef struct _workload_reader_t
+{
+    int m_fd;
+    char* m_buffer;
+    size_t m_size, m_start, m_end;
+    int m_eof;
+    int m_line;
+    int m_error_line;
+    const char* m_column;  // optional column that stopped the reader, with WORKLOAD_ERROR_COLUMN
+
+    workload_t m_binary;
+    int m_next;
+
+    workgen_t m_generator;
+    int m_generating;
+
+    ring_t m_ring;
+    pthread_t m_thread;
+    int m_threaded;
+    atomic_int m_stop;
+    workload_status_t m_final;  // status that ended the loader, once received
+} workload_reader_t;
+
+
+void              workload_init       (workload_t *w);
+
+workload_status_t workload_load       (workload_t *w, const char *file_name);
+workload_status_t workload_load_csv   (workload_t *w, const char *file_name);
+workload_status_t workload_parse_csv  (workload_t *w, const char *data, size_t length);
+workload_status_t workload_generate   (workload_t *w, const char *spec);
+workload_status_t workload_save_binary(workload_t *w, const char *file_name);
+
+void              workload_destroy    (workload_t *w);
+
+workload_status_t workload_reader_open    (workload_reader_t *r, const char *file_name);
+workload_status_t workload_reader_generate(workload_reader_t *r, const char *spec);
+workload_status_t workload_reader_start   (workload_reader_t *r, size_t capacity);
+workload_status_t workload_reader_next    (workload_reader_t *r, int *arrival_time, int *run_time, int *priority);
+void              workload_reader_close   (workload_reader_t *r);
+
+#endif /* LIBWORKLOAD_H_ */
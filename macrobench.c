@@ -0,0 +1,387 @@
+/** @file macrobench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+
+/**
+  Largest output of one simulator run (a one-row sweep table).
+*/
+#define RUN_OUTPUT_SIZE 4096
+
+/**
+  Slowdowns smaller than this many milliseconds are within the noise of the
+  clock and of process start-up, however large they are relatively.
+*/
+#define MIN_SIGNIFICANT_MS 2.0
+
+/**
+  Number of integers the calibration workload sorts.
+*/
+#define CALIBRATION_SIZE (1 << 17)
+
+/**
+  A named, fixed workload specification; the same specification always
+  generates the same jobs.
+*/
+typedef struct _scenario_t
+{
+	const char *name, *spec;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+	{"light",       "n=200000,seed=11,arrival=poisson:0.02,run=exp:8"},
+	{"saturated",   "n=10000,seed=12,arrival=poisson:0.12,run=exp:8"},
+	{"bursty",      "n=50000,seed=13,arrival=bursty:0.08:16,run=exp:8"},
+	{"heavytailed", "n=100000,seed=14,arrival=poisson:0.05,run=pareto:1.5:4"},
+};
+
+static const char *schemes[] = {"fcfs", "sjf", "psjf", "pri", "ppri", "rr4"};
+static const int cores[] = {1, 4, 64};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof(array[0])))
+
+/**
+  Results of one scenario, scheme and core count.  The scheduling metrics are
+  kept as printed so that they compare exactly.
+*/
+typedef struct _result_t
+{
+	char scenario[32], scheme[16];
+	int cores;
+	int jobs, makespan;
+	long long events;
+	double wall_ms;        // simulation only, the median of the repetitions
+	double cpu_ms;         // CPU time of the simulation, the median of the repetitions
+	double relative_cpu;   // CPU time over that of the calibration just before, the median of the repetitions
+	long peak_rss_kb;      // the largest of the repetitions
+	char waiting_time[32], turnaround_time[32], response_time[32];
+} result_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-r <repetitions>] [-b <baseline file>] [-t <threshold %%>] [-p <simulator>]\n", program_name);
+	fprintf(stderr, "Runs the light, saturated, bursty and heavytailed traces through every scheme at 1, 4 and 64 cores\n");
+	fprintf(stderr, "and prints wall and CPU time, events per second, peak RSS and the scheduling metrics of each run as CSV.\n");
+	fprintf(stderr, "Every run follows a calibration, a fixed sort, and its relative CPU time is its CPU time over the\n");
+	fprintf(stderr, "calibration's.  Times are the medians of the repetitions (default 5).  With -b, the runs are compared against\n");
+	fprintf(stderr, "a baseline written by an earlier run: the exit status is 1 if any run's relative CPU time is more than the\n");
+	fprintf(stderr, "baseline's by more than the threshold (default 20%%), or its metrics differ.  Relative times ride out spells\n");
+	fprintf(stderr, "when the machine is slower, but are best compared on the machine that wrote the baseline (make bench-baseline).\n");
+}
+
+int compare_int(const void *a, const void *b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+  Returns the CPU time, in milliseconds, this process takes to sort a fixed
+  array of pseudo-random integers.
+ */
+double calibrate()
+{
+	static int values[CALIBRATION_SIZE];
+	unsigned int seed = 1;
+	struct timespec start, end;
+	int i;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+	for (i = 0; i < CALIBRATION_SIZE; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		values[i] = seed >> 8;
+	}
+	qsort(values, CALIBRATION_SIZE, sizeof(int), compare_int);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+
+	return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+int compare_ms(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+  Returns the median of count times, which are sorted in place.
+ */
+double median_ms(double *times, int count)
+{
+	qsort(times, count, sizeof(double), compare_ms);
+	return (count % 2 == 1) ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2;
+}
+
+/**
+  Runs the simulator on one configuration as a single-row sweep, in its own
+  process so that its peak RSS can be told apart.
+
+  @return 0 on success, -1 if the simulator could not be run or failed
+ */
+int run_once(const char *simulator, const scenario_t *scenario, const char *scheme, int core_count, result_t *result)
+{
+	char grid[128], output[RUN_OUTPUT_SIZE];
+	int pipe_fds[2], status, length = 0;
+	ssize_t got;
+	struct rusage usage;
+
+	snprintf(grid, sizeof(grid), "schemes=%s,cores=%d,threads=1,format=csv", scheme, core_count);
+
+	if (pipe(pipe_fds) != 0)
+		return -1;
+
+	pid_t pid = fork();
+	if (pid == -1)
+		return -1;
+	if (pid == 0)
+	{
+		// The sweep's summary line on stderr is not wanted
+		int null_fd = open("/dev/null", O_WRONLY);
+		dup2(pipe_fds[1], STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		close(null_fd);
+		close(pipe_fds[0]);
+		close(pipe_fds[1]);
+		execl(simulator, simulator, "-m", "event", "-x", grid, "-g", scenario->spec, (char *)NULL);
+		_exit(127);
+	}
+
+	close(pipe_fds[1]);
+	while ((got = read(pipe_fds[0], output + length, sizeof(output) - 1 - length)) > 0)
+		length += got;
+	output[length] = '\0';
+	close(pipe_fds[0]);
+
+	if (wait4(pid, &status, 0, &usage) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return -1;
+
+	// Skip the header and split the row, whose columns are those of the sweep
+	// table: scheme, quantum (empty unless RR), cores, jobs, makespan, events,
+	// the three averages, wall and CPU time, and status
+	char *row = strchr(output, '\n');
+	char *fields[12];
+	int count = 0;
+	if (row == NULL)
+		return -1;
+	row++;
+	row[strcspn(row, "\n")] = '\0';
+	while (row != NULL && count < 12)
+		fields[count++] = strsep(&row, ",");
+	if (count < 12 || strcmp(fields[11], "ok") != 0)
+		return -1;
+
+	snprintf(result->scenario, sizeof(result->scenario), "%s", scenario->name);
+	snprintf(result->scheme, sizeof(result->scheme), "%s", scheme);
+	result->cores = core_count;
+	result->jobs = atoi(fields[3]);
+	result->makespan = atoi(fields[4]);
+	result->events = atoll(fields[5]);
+	snprintf(result->waiting_time, sizeof(result->waiting_time), "%s", fields[6]);
+	snprintf(result->turnaround_time, sizeof(result->turnaround_time), "%s", fields[7]);
+	snprintf(result->response_time, sizeof(result->response_time), "%s", fields[8]);
+	result->wall_ms = atof(fields[9]);
+	result->cpu_ms = atof(fields[10]);
+	result->peak_rss_kb = usage.ru_maxrss;
+	return 0;
+}
+
+void print_header(FILE *stream)
+{
+	fprintf(stream, "\"Scenario\",\"Scheme\",\"Cores\",\"Jobs\",\"Makespan\",\"Events\",\"Wall Time (ms)\",\"CPU Time (ms)\",\"Relative CPU Time\",\"Events per Second\",\"Peak RSS (KB)\","
+			"\"Average Waiting Time\",\"Average Turnaround Time\",\"Average Response Time\"\n");
+}
+
+void print_result(FILE *stream, result_t *r)
+{
+	fprintf(stream, "%s,%s,%d,%d,%d,%lld,%.3f,%.3f,%.4f,%.0f,%ld,%s,%s,%s\n", r->scenario, r->scheme, r->cores, r->jobs, r->makespan, r->events,
+			r->wall_ms, r->cpu_ms, r->relative_cpu, r->wall_ms > 0 ? r->events / (r->wall_ms / 1000) : 0.0, r->peak_rss_kb,
+			r->waiting_time, r->turnaround_time, r->response_time);
+}
+
+/**
+  Reads a file of results as printed by print_result(), after its header.
+
+  @return the number of results read, or -1 if the file could not be opened
+ */
+int read_results(const char *file_name, result_t *results, int size)
+{
+	FILE *file = fopen(file_name, "r");
+	char line[512];
+	int count = 0;
+
+	if (file == NULL)
+		return -1;
+
+	while (count < size && fgets(line, sizeof(line), file) != NULL)
+	{
+		result_t *r = &results[count];
+		double events_per_second;
+		if (line[0] == '"')
+			continue;
+		if (sscanf(line, "%31[^,],%15[^,],%d,%d,%d,%lld,%lf,%lf,%lf,%lf,%ld,%31[^,],%31[^,],%31[^,\n]", r->scenario, r->scheme, &r->cores, &r->jobs,
+				&r->makespan, &r->events, &r->wall_ms, &r->cpu_ms, &r->relative_cpu, &events_per_second, &r->peak_rss_kb,
+				r->waiting_time, r->turnaround_time, r->response_time) == 14)
+			count++;
+	}
+
+	fclose(file);
+	return count;
+}
+
+/**
+  Compares a run with its baseline, reporting why it fails the gate.
+
+  @return 0 if the run passes, 1 if not
+ */
+int compare_result(result_t *r, result_t *baseline, double threshold)
+{
+	int failed = 0;
+
+	if (r->jobs != baseline->jobs || r->makespan != baseline->makespan || r->events != baseline->events
+			|| strcmp(r->waiting_time, baseline->waiting_time) != 0 || strcmp(r->turnaround_time, baseline->turnaround_time) != 0
+			|| strcmp(r->response_time, baseline->response_time) != 0)
+	{
+		fprintf(stderr, "%s %s -c %d: metrics differ from the baseline (makespan %d, %lld events, %s/%s/%s; expected %d, %lld events, %s/%s/%s)\n",
+				r->scenario, r->scheme, r->cores, r->makespan, r->events, r->waiting_time, r->turnaround_time, r->response_time,
+				baseline->makespan, baseline->events, baseline->waiting_time, baseline->turnaround_time, baseline->response_time);
+		failed = 1;
+	}
+
+	// The slowdown in milliseconds is that of the relative times, on the baseline's scale
+	double ratio = r->relative_cpu / baseline->relative_cpu;
+	if (ratio > 1 + threshold && (ratio - 1) * baseline->cpu_ms > MIN_SIGNIFICANT_MS)
+	{
+		fprintf(stderr, "%s %s -c %d: a relative CPU time of %.4f is %.0f%% more than the baseline's %.4f (%.3f ms of CPU time, against %.3f ms)\n",
+				r->scenario, r->scheme, r->cores, r->relative_cpu, (ratio - 1) * 100, baseline->relative_cpu, r->cpu_ms, baseline->cpu_ms);
+		failed = 1;
+	}
+
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	const char *simulator = "./simulator", *baseline_name = NULL;
+	int repetitions = 5, c, i, j, k, rep;
+	double threshold = 0.20;
+
+	while ((c = getopt(argc, argv, "r:b:t:p:")) != -1)
+	{
+		switch (c)
+		{
+			case 'r': repetitions = atoi(optarg); break;
+			case 'b': baseline_name = optarg; break;
+			case 't': threshold = atof(optarg) / 100; break;
+			case 'p': simulator = optarg; break;
+			default:
+				print_usage(argv[0]);
+				return 2;
+		}
+	}
+
+	if (optind != argc || repetitions <= 0 || threshold < 0)
+	{
+		print_usage(argv[0]);
+		return 2;
+	}
+
+	int run_count = COUNT(scenarios) * COUNT(schemes) * COUNT(cores);
+	result_t *results = calloc(run_count, sizeof(result_t));
+	result_t *baseline = calloc(run_count, sizeof(result_t));
+	double *wall_ms = calloc(run_count * repetitions, sizeof(double));
+	double *cpu_ms = calloc(run_count * repetitions, sizeof(double));
+	double *relative_cpu = calloc(run_count * repetitions, sizeof(double));
+	int baseline_count = 0, count = 0;
+
+	if (baseline_name != NULL && (baseline_count = read_results(baseline_name, baseline, run_count)) == -1)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", baseline_name);
+		return 2;
+	}
+	if (baseline_name != NULL && baseline_count == 0)
+	{
+		fprintf(stderr, "The file \"%s\" holds no results; it may have been written by an older macrobench.\n", baseline_name);
+		return 2;
+	}
+
+	// Every repetition runs the whole matrix, so that the repetitions of a run
+	// are spread out rather than all caught in one busy spell of the machine;
+	// the median then shrugs off the spells that do catch a few of them
+	for (rep = 0; rep < repetitions; rep++)
+	{
+		count = 0;
+		for (i = 0; i < COUNT(scenarios); i++)
+		{
+			for (j = 0; j < COUNT(schemes); j++)
+			{
+				for (k = 0; k < COUNT(cores); k++)
+				{
+					result_t *r = &results[count++], run;
+					double calibration_ms = calibrate();
+
+					if (run_once(simulator, &scenarios[i], schemes[j], cores[k], &run) != 0)
+					{
+						fprintf(stderr, "Running %s -m event -x schemes=%s,cores=%d -g %s failed.\n", simulator, schemes[j], cores[k], scenarios[i].spec);
+						return 2;
+					}
+
+					if (rep == 0)
+						*r = run;
+					wall_ms[(count - 1) * repetitions + rep] = run.wall_ms;
+					cpu_ms[(count - 1) * repetitions + rep] = run.cpu_ms;
+					relative_cpu[(count - 1) * repetitions + rep] = run.cpu_ms / calibration_ms;
+					if (run.peak_rss_kb > r->peak_rss_kb)
+						r->peak_rss_kb = run.peak_rss_kb;
+				}
+			}
+		}
+	}
+
+	print_header(stdout);
+	for (i = 0; i < count; i++)
+	{
+		results[i].wall_ms = median_ms(&wall_ms[i * repetitions], repetitions);
+		results[i].cpu_ms = median_ms(&cpu_ms[i * repetitions], repetitions);
+		results[i].relative_cpu = median_ms(&relative_cpu[i * repetitions], repetitions);
+		print_result(stdout, &results[i]);
+	}
+	fflush(stdout);
+
+	if (baseline_name == NULL)
+		return 0;
+
+	int failures = 0, missing = 0;
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0; j < baseline_count; j++)
+			if (strcmp(results[i].scenario, baseline[j].scenario) == 0 && strcmp(results[i].scheme, baseline[j].scheme) == 0
+					&& results[i].cores == baseline[j].cores)
+				break;
+
+		if (j == baseline_count)
+			missing++;
+		else
+			failures += compare_result(&results[i], &baseline[j], threshold);
+	}
+
+	if (missing > 0)
+		fprintf(stderr, "%d run(s) have no baseline.\n", missing);
+	fprintf(stderr, "%d of %d run(s) failed against the baseline (threshold %.0f%%).\n", failures, count, threshold * 100);
+
+	free(results);
+	free(baseline);
+	free(wall_ms);
+	free(cpu_ms);
+	free(relative_cpu);
+	return (failures > 0) ? 1 : 0;
+}
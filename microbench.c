@@ -0,0 +1,513 @@
+/** @file microbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libpriqueue/libpriqueue.h"
+#include "libscheduler/libscheduler.h"
+
+
+/**
+  Each sample times batches of operations until at least this many
+  nanoseconds have been measured, so that short operations are not lost in
+  the resolution of the clock.
+*/
+#define SAMPLE_TARGET_NS 1000000.0
+
+/**
+  Largest number of operations in one batch.
+*/
+#define MAX_BATCH (1 << 16)
+
+/**
+  Default limits of the queue sizes and scheduler queue depths measured.
+  The scheduler stops earlier than the queue: under SJF and PRI,
+  scheduler_job_finished() costs time quadratic in the depth, and every
+  scheduler_new_job() batch is undone through it.
+*/
+#define DEFAULT_MAX_SIZE  1000000
+#define DEFAULT_MAX_DEPTH 1000
+
+/**
+  A batch of operations: runs count operations on a fixture and returns the
+  nanoseconds they took, putting the fixture back the way it was afterwards
+  (untimed).
+*/
+typedef double (*batch_t)(void *fixture, int count);
+
+/**
+  Options of a run, and where the results go.
+*/
+typedef struct _bench_t
+{
+	int repetitions, warmup;
+	int max_size, max_depth;
+	double clock_overhead;  // nanoseconds a pair of clock reads adds to a batch
+
+	FILE *json;
+	int results;
+} bench_t;
+
+/**
+  A queue filled with size values in order, plus values to offer on top of
+  them and random indices.
+*/
+typedef struct _queue_fixture_t
+{
+	priqueue_t queue;
+	int size;
+	int *values;   // even numbers, the contents of the queue
+	int *extra;    // odd numbers, landing anywhere in the queue when offered
+	int *index;    // random positions in the queue
+	void **taken;  // values taken out by the current batch
+} queue_fixture_t;
+
+/**
+  A scheduler with depth jobs queued on one core.
+*/
+typedef struct _scheduler_fixture_t
+{
+	scheduler_t scheduler;
+	scheme_t scheme;
+	int depth;
+	int running;   // job the scheduler runs on core 0, or -1
+	int next_job, time;
+	unsigned int seed;
+} scheduler_fixture_t;
+
+static const char *scheme_names[] = {"FCFS", "SJF", "PSJF", "PRI", "PPRI", "RR"};
+
+static void *volatile sink;
+static volatile int int_sink;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-r <repetitions>] [-w <warmup>] [-n <max queue size>] [-d <max scheduler depth>] [-j <json file>]\n", program_name);
+	fprintf(stderr, "Measures ns/op of every libpriqueue operation at queue sizes from 10 up to 10^6, and of\n");
+	fprintf(stderr, "scheduler_new_job(), scheduler_job_finished() and scheduler_quantum_expired() per scheme.\n");
+	fprintf(stderr, "Each result is the median and 99th percentile of the repetitions, after the warmup ones.\n");
+}
+
+double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int compare_ints(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+int compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+  Measures the cost of the two clock reads around a batch, which is taken
+  off every batch.
+ */
+double measure_clock_overhead()
+{
+	double best = 1e9;
+	int i;
+
+	for (i = 0; i < 1000; i++)
+	{
+		double start = now_ns();
+		double elapsed = now_ns() - start;
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+/**
+  Puts a value at the front of a queue without going through the comparer,
+  which is how the fixtures are built and restored in constant time.
+ */
+void queue_push_front(priqueue_t *q, void *value)
+{
+	Node *node = malloc(sizeof(Node));
+	node->m_value = value;
+	node->m_next = q->m_front;
+	q->m_front = node;
+	q->m_size++;
+}
+
+int queue_fixture_init(queue_fixture_t *f, int size)
+{
+	int i;
+	unsigned int seed = size;
+
+	f->size = size;
+	f->values = malloc(size * sizeof(int));
+	f->extra = malloc(MAX_BATCH * sizeof(int));
+	f->index = malloc(MAX_BATCH * sizeof(int));
+	f->taken = malloc(MAX_BATCH * sizeof(void *));
+	if (f->values == NULL || f->extra == NULL || f->index == NULL || f->taken == NULL)
+		return -1;
+
+	priqueue_init(&f->queue, compare_ints);
+	for (i = size - 1; i >= 0; i--)
+	{
+		f->values[i] = 2 * i;
+		queue_push_front(&f->queue, &f->values[i]);
+	}
+
+	for (i = 0; i < MAX_BATCH; i++)
+	{
+		f->extra[i] = 2 * (rand_r(&seed) % size) + 1;
+		f->index[i] = rand_r(&seed) % size;
+	}
+
+	return 0;
+}
+
+void queue_fixture_destroy(queue_fixture_t *f)
+{
+	if (priqueue_size(&f->queue) > 0)
+		priqueue_destroy(&f->queue);
+	free(f->values);
+	free(f->extra);
+	free(f->index);
+	free(f->taken);
+}
+
+double batch_offer(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		priqueue_offer(&f->queue, &f->extra[i]);
+	double elapsed = now_ns() - start;
+
+	for (i = 0; i < count; i++)
+		priqueue_remove(&f->queue, &f->extra[i]);
+	return elapsed;
+}
+
+double batch_peek(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		sink = priqueue_peek(&f->queue);
+	return now_ns() - start;
+}
+
+double batch_poll(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		f->taken[i] = priqueue_poll(&f->queue);
+	double elapsed = now_ns() - start;
+
+	for (i = count - 1; i >= 0; i--)
+		queue_push_front(&f->queue, f->taken[i]);
+	return elapsed;
+}
+
+double batch_at(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		sink = priqueue_at(&f->queue, f->index[i]);
+	return now_ns() - start;
+}
+
+double batch_remove(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		f->taken[i] = priqueue_remove(&f->queue, &f->values[f->index[i]]) ? &f->values[f->index[i]] : NULL;
+	double elapsed = now_ns() - start;
+
+	for (i = 0; i < count; i++)
+		if (f->taken[i] != NULL)
+			priqueue_offer(&f->queue, f->taken[i]);
+	return elapsed;
+}
+
+double batch_remove_at(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		f->taken[i] = priqueue_remove_at(&f->queue, f->index[i] % (f->size - i));
+	double elapsed = now_ns() - start;
+
+	for (i = 0; i < count; i++)
+		priqueue_offer(&f->queue, f->taken[i]);
+	return elapsed;
+}
+
+double batch_size(void *fixture, int count)
+{
+	queue_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		int_sink = priqueue_size(&f->queue);
+	return now_ns() - start;
+}
+
+/**
+  Hands the scheduler the next job, as the simulator would when it arrives.
+ */
+void scheduler_fixture_arrive(scheduler_fixture_t *f)
+{
+	int job = f->next_job++;
+	int core = scheduler_new_job_r(&f->scheduler, job, f->time++, 1 + rand_r(&f->seed) % 100, rand_r(&f->seed) % 10);
+	if (core == 0)
+		f->running = job;
+}
+
+/**
+  Tells the scheduler the running job finished, as the simulator would.
+ */
+void scheduler_fixture_finish(scheduler_fixture_t *f)
+{
+	f->running = scheduler_job_finished_r(&f->scheduler, 0, f->running, f->time++);
+}
+
+void scheduler_fixture_init(scheduler_fixture_t *f, scheme_t scheme, int depth)
+{
+	int i;
+
+	scheduler_start_up_r(&f->scheduler, 1, scheme);
+	f->scheme = scheme;
+	f->depth = depth;
+	f->running = -1;
+	f->next_job = 0;
+	f->time = 0;
+	f->seed = depth;
+
+	for (i = 0; i < depth; i++)
+		scheduler_fixture_arrive(f);
+}
+
+void scheduler_fixture_destroy(scheduler_fixture_t *f)
+{
+	while (f->running != -1)
+		scheduler_fixture_finish(f);
+	scheduler_clean_up_r(&f->scheduler);
+}
+
+double batch_new_job(void *fixture, int count)
+{
+	scheduler_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		scheduler_fixture_arrive(f);
+	double elapsed = now_ns() - start;
+
+	for (i = 0; i < count; i++)
+		scheduler_fixture_finish(f);
+	return elapsed;
+}
+
+double batch_job_finished(void *fixture, int count)
+{
+	scheduler_fixture_t *f = fixture;
+	int i;
+
+	for (i = 0; i < count; i++)
+		scheduler_fixture_arrive(f);
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		scheduler_fixture_finish(f);
+	return now_ns() - start;
+}
+
+double batch_quantum_expired(void *fixture, int count)
+{
+	scheduler_fixture_t *f = fixture;
+	int i;
+
+	double start = now_ns();
+	for (i = 0; i < count; i++)
+		f->running = scheduler_quantum_expired_r(&f->scheduler, 0, f->time++);
+	return now_ns() - start;
+}
+
+/**
+  Times one operation on a fixture and reports it.
+
+  The batch size doubles, up to max_batch, until a batch takes long enough to
+  measure; samples that are still too short repeat the batch.  Warmup samples
+  are discarded and the rest give the median and 99th percentile.
+ */
+void measure(bench_t *bench, const char *name, const char *scheme, int size, batch_t batch, void *fixture, int max_batch)
+{
+	int count = 1, batches = 1, i, j;
+	double elapsed;
+
+	if (max_batch > MAX_BATCH)
+		max_batch = MAX_BATCH;
+	if (max_batch < 1)
+		max_batch = 1;
+
+	batch(fixture, 1);
+	while ((elapsed = batch(fixture, count) - bench->clock_overhead) < SAMPLE_TARGET_NS && count < max_batch)
+		count = (2 * count < max_batch) ? 2 * count : max_batch;
+	if (elapsed < SAMPLE_TARGET_NS)
+		batches = (elapsed > 0) ? (int)(SAMPLE_TARGET_NS / elapsed) + 1 : 1000;
+
+	double *samples = malloc(bench->repetitions * sizeof(double));
+	for (i = -bench->warmup; i < bench->repetitions; i++)
+	{
+		double total = 0;
+		for (j = 0; j < batches; j++)
+			total += batch(fixture, count) - bench->clock_overhead;
+		if (i >= 0)
+			samples[i] = (total > 0 ? total : 0) / ((double)count * batches);
+	}
+
+	qsort(samples, bench->repetitions, sizeof(double), compare_doubles);
+	double median = (bench->repetitions % 2) ? samples[bench->repetitions / 2]
+			: (samples[bench->repetitions / 2 - 1] + samples[bench->repetitions / 2]) / 2;
+	int p99_index = (99 * bench->repetitions + 99) / 100 - 1;
+	double p99 = samples[p99_index];
+
+	printf("%-28s %-6s %8d %10d %14.1f %14.1f\n", name, scheme != NULL ? scheme : "-", size, count * batches, median, p99);
+	fflush(stdout);
+
+	if (bench->json != NULL)
+	{
+		fprintf(bench->json, "%s    {\"benchmark\": \"%s\", ", bench->results > 0 ? ",\n" : "", name);
+		if (scheme != NULL)
+			fprintf(bench->json, "\"scheme\": \"%s\", ", scheme);
+		else
+			fprintf(bench->json, "\"scheme\": null, ");
+		fprintf(bench->json, "\"size\": %d, \"ops_per_sample\": %d, \"median_ns\": %.2f, \"p99_ns\": %.2f, \"min_ns\": %.2f}",
+				size, count * batches, median, p99, samples[0]);
+	}
+	bench->results++;
+
+	free(samples);
+}
+
+void bench_queue(bench_t *bench)
+{
+	int size;
+
+	for (size = 10; size <= bench->max_size; size *= 10)
+	{
+		queue_fixture_t f;
+		if (queue_fixture_init(&f, size) != 0)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			exit(2);
+		}
+
+		measure(bench, "priqueue_offer", NULL, size, batch_offer, &f, size);
+		measure(bench, "priqueue_peek", NULL, size, batch_peek, &f, MAX_BATCH);
+		measure(bench, "priqueue_poll", NULL, size, batch_poll, &f, size);
+		measure(bench, "priqueue_at", NULL, size, batch_at, &f, MAX_BATCH);
+		measure(bench, "priqueue_remove", NULL, size, batch_remove, &f, size);
+		measure(bench, "priqueue_remove_at", NULL, size, batch_remove_at, &f, size);
+		measure(bench, "priqueue_size", NULL, size, batch_size, &f, MAX_BATCH);
+
+		queue_fixture_destroy(&f);
+	}
+}
+
+void bench_scheduler(bench_t *bench)
+{
+	int scheme, depth;
+
+	for (scheme = FCFS; scheme <= RR; scheme++)
+	{
+		for (depth = 10; depth <= bench->max_depth; depth *= 10)
+		{
+			scheduler_fixture_t f;
+
+			scheduler_fixture_init(&f, scheme, depth);
+			measure(bench, "scheduler_new_job", scheme_names[scheme], depth, batch_new_job, &f, depth);
+			measure(bench, "scheduler_job_finished", scheme_names[scheme], depth, batch_job_finished, &f, depth);
+			if (scheme == RR)
+				measure(bench, "scheduler_quantum_expired", scheme_names[scheme], depth, batch_quantum_expired, &f, MAX_BATCH);
+			scheduler_fixture_destroy(&f);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bench_t bench = {.repetitions = 20, .warmup = 3, .max_size = DEFAULT_MAX_SIZE, .max_depth = DEFAULT_MAX_DEPTH};
+	char *json_name = NULL;
+	int c;
+
+	while ((c = getopt(argc, argv, "r:w:n:d:j:")) != -1)
+	{
+		switch (c)
+		{
+			case 'r': bench.repetitions = atoi(optarg); break;
+			case 'w': bench.warmup = atoi(optarg); break;
+			case 'n': bench.max_size = atoi(optarg); break;
+			case 'd': bench.max_depth = atoi(optarg); break;
+			case 'j': json_name = optarg; break;
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (optind != argc || bench.repetitions <= 0 || bench.warmup < 0 || bench.max_size < 10 || bench.max_depth < 10)
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (json_name != NULL && (bench.json = fopen(json_name, "w")) == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", json_name);
+		return 2;
+	}
+
+	bench.clock_overhead = measure_clock_overhead();
+
+	if (bench.json != NULL)
+		fprintf(bench.json, "{\n  \"repetitions\": %d,\n  \"warmup\": %d,\n  \"clock_overhead_ns\": %.2f,\n  \"results\": [\n",
+				bench.repetitions, bench.warmup, bench.clock_overhead);
+
+	printf("%-28s %-6s %8s %10s %14s %14s\n", "operation", "scheme", "size", "ops/sample", "median ns/op", "p99 ns/op");
+	bench_queue(&bench);
+	bench_scheduler(&bench);
+
+	if (bench.json != NULL)
+	{
+		fprintf(bench.json, "\n  ]\n}\n");
+		fclose(bench.json);
+	}
+
+	return 0;
+}
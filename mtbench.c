@@ -0,0 +1,170 @@
+/** @file mtbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libscheduler/libscheduler.h"
+
+
+/**
+  Producer thread counts measured.
+*/
+static const int producer_counts[] = {1, 2, 4, 8, 16, 32};
+
+#define COUNT(array) ((int)(sizeof(array) / sizeof(array[0])))
+
+/**
+  A producer thread and the scheduler it calls.
+*/
+typedef struct _producer_t
+{
+	pthread_t thread;
+	scheduler_mt_t *scheduler;
+	pthread_barrier_t *start;
+	int first_job, jobs;
+	unsigned long calls;
+} producer_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-c <cores>] [-n <jobs per producer>] [-r <repetitions>]\n", program_name);
+	fprintf(stderr, "Measures the thread-safe scheduler with 1 to 32 producer threads, each submitting jobs (default\n");
+	fprintf(stderr, "200000) with scheduler_mt_new_job().  A producer given a core runs the jobs of that core to\n");
+	fprintf(stderr, "completion with scheduler_mt_job_finished(), so the queues stay short.  Each count is run with\n");
+	fprintf(stderr, "a single shard, where every call takes the same lock, and with one shard per core (default 64).\n");
+	fprintf(stderr, "Each result is the best of the repetitions (default 3).\n");
+}
+
+double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void *produce(void *arg)
+{
+	producer_t *p = arg;
+	int job;
+
+	pthread_barrier_wait(p->start);
+
+	for (job = p->first_job; job < p->first_job + p->jobs; job++)
+	{
+		int core_id = scheduler_mt_new_job(p->scheduler, job, 0, 1, 0);
+		int running = job;
+		p->calls++;
+
+		while (core_id >= 0 && running != -1)
+		{
+			running = scheduler_mt_job_finished(p->scheduler, core_id, running, 0);
+			p->calls++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+  Runs the producers against a fresh scheduler.
+
+  @return the scheduler calls made per second, or -1 if the run failed
+ */
+double run(int producers, int cores, int shards, int jobs)
+{
+	scheduler_mt_t scheduler;
+	pthread_barrier_t start;
+	producer_t *p = calloc(producers, sizeof(producer_t));
+	unsigned long calls = 0, new_job_calls, job_finished_calls, quantum_expired_calls;
+	int i;
+
+	if (p == NULL || scheduler_mt_start_up(&scheduler, cores, FCFS, shards) != 0)
+		return -1;
+	pthread_barrier_init(&start, NULL, producers + 1);
+
+	for (i = 0; i < producers; i++)
+	{
+		p[i].scheduler = &scheduler;
+		p[i].start = &start;
+		p[i].first_job = i * jobs;
+		p[i].jobs = jobs;
+		if (pthread_create(&p[i].thread, NULL, produce, &p[i]) != 0)
+			return -1;
+	}
+
+	pthread_barrier_wait(&start);
+	double begin = now_ns();
+	for (i = 0; i < producers; i++)
+	{
+		pthread_join(p[i].thread, NULL);
+		calls += p[i].calls;
+	}
+	double elapsed = now_ns() - begin;
+
+	// The lock-free counters must account for every call once all producers are done
+	scheduler_mt_get_calls(&scheduler, &new_job_calls, &job_finished_calls, &quantum_expired_calls);
+	if (new_job_calls + job_finished_calls != calls || new_job_calls != (unsigned long)producers * jobs)
+	{
+		fprintf(stderr, "The scheduler counted %lu calls; the producers made %lu.\n", new_job_calls + job_finished_calls, calls);
+		return -1;
+	}
+
+	pthread_barrier_destroy(&start);
+	scheduler_mt_clean_up(&scheduler);
+	free(p);
+	return calls / (elapsed / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	int cores = 64, jobs = 200000, repetitions = 3, c, i, j, rep;
+
+	while ((c = getopt(argc, argv, "c:n:r:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': cores = atoi(optarg); break;
+			case 'n': jobs = atoi(optarg); break;
+			case 'r': repetitions = atoi(optarg); break;
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (optind != argc || cores <= 0 || jobs <= 0 || repetitions <= 0)
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	printf("%9s %7s %16s %16s %8s\n", "producers", "cores", "1 shard calls/s", "sharded calls/s", "speedup");
+	for (i = 0; i < COUNT(producer_counts); i++)
+	{
+		double best[2] = {0, 0};
+
+		for (rep = 0; rep < repetitions; rep++)
+		{
+			for (j = 0; j < 2; j++)
+			{
+				double rate = run(producer_counts[i], cores, (j == 0) ? 1 : cores, jobs);
+				if (rate < 0)
+				{
+					fprintf(stderr, "Unable to run %d producers.\n", producer_counts[i]);
+					return 2;
+				}
+				if (rate > best[j])
+					best[j] = rate;
+			}
+		}
+
+		printf("%9d %7d %16.0f %16.0f %7.2fx\n", producer_counts[i], cores, best[0], best[1], best[1] / best[0]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+/** @file ringtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "libring/libring.h"
+
+#define HANDED_OVER 100000
+
+int failures = 0;
+
+void expect(const char *what, long value, long expected)
+{
+	printf("%s: %ld (expected %ld).\n", what, value, expected);
+	if (value != expected)
+		failures++;
+}
+
+void *producer(void *arg)
+{
+	ring_t *r = arg;
+	int i;
+
+	for (i = 0; i < HANDED_OVER; i++)
+		while (ring_push(r, &i) != 0)
+			sched_yield();
+
+	return NULL;
+}
+
+int main()
+{
+	ring_t r;
+	int i, value;
+
+	/* The capacity is rounded up to a power of two. */
+	expect("Initialized", ring_init(&r, 5, sizeof(int)), 0);
+	expect("Capacity", (long)ring_capacity(&r), 8);
+	expect("Popped from an empty ring", ring_pop(&r, &value), -1);
+
+	/* Fill the ring, then wrap around it several times while it stays full. */
+	int pushed = 0, popped = 0, ordered = 1;
+	while (ring_push(&r, &pushed) == 0)
+		pushed++;
+	expect("Pushed until full", pushed, 8);
+	expect("Pushed to a full ring", ring_push(&r, &pushed), -1);
+
+	for (i = 0; i < 21; i++)
+	{
+		if (ring_pop(&r, &value) != 0 || value != popped++)
+			ordered = 0;
+		if (ring_push(&r, &pushed) != 0)
+			ordered = 0;
+		pushed++;
+		if (ring_push(&r, &pushed) != -1)
+			ordered = 0;
+	}
+	while (ring_pop(&r, &value) == 0)
+		if (value != popped++)
+			ordered = 0;
+	expect("Elements popped", popped, pushed);
+	expect("Popped in order across wrap-arounds", ordered, 1);
+
+	ring_destroy(&r);
+
+	/* One thread on each side, the ring filling up and running dry in turn. */
+	ring_init(&r, 64, sizeof(int));
+	pthread_t thread;
+	pthread_create(&thread, NULL, producer, &r);
+
+	long sum = 0;
+	ordered = 1;
+	for (i = 0; i < HANDED_OVER; i++)
+	{
+		while (ring_pop(&r, &value) != 0)
+			sched_yield();
+		if (value != i)
+			ordered = 0;
+		sum += value;
+	}
+	pthread_join(thread, NULL);
+	expect("Sum handed over between threads", sum, (long)HANDED_OVER * (HANDED_OVER - 1) / 2);
+	expect("Handed over in order", ordered, 1);
+	expect("Left in the ring", ring_pop(&r, &value), -1);
+
+	ring_destroy(&r);
+
+	if (failures > 0)
+		printf("%d check(s) failed.\n", failures);
+	return (failures > 0) ? 1 : 0;
+}
@@ -1,487 +1,2385 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <string.h>
-#include <assert.h>
-
-#include "libscheduler/libscheduler.h"
-
-
-typedef struct _simulator_job_list_t
-{
-	int job_id, arrival_time, run_time, priority;
-	int core_id, arrived;
-} simulator_job_list_t;
-
-void print_usage(char *program_name)
-{
-	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> <input file>\n", program_name);
-	fprintf(stderr, "       %s -c 2 -s fcfs examples/proc1.csv\n", program_name);
-	fprintf(stderr, "\n");
-	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#\n");
-}
-
-int set_active_job(int job_id, int core_id, simulator_job_list_t *jobs, int active_jobs)
-{
-	int i;
-	for (i = 0; i < active_jobs; i++)
-	{
-		if (jobs[i].job_id == job_id && jobs[i].arrived)
-		{
-			jobs[i].core_id = core_id;
-			return 1;
-		}
-	}
-
-	return 0;
-}
-
-void print_available_jobs(simulator_job_list_t *jobs, int active_jobs)
-{
-	printf("Active jobs are: ");
-
-	int i, first = 1;
-	for (i = 0; i < active_jobs; i++)
-	{
-		if (jobs[i].arrived)
-		{
-			if (first)
-			{
-				printf("%d", jobs[i].job_id);
-				first = 0;
-			}
-			else
-				printf(", %d", jobs[i].job_id);
-		}
-	}
-
-	if (!first)
-		printf("\n");
-}
-
-void print_available_cores(int cores)
-{
-	printf("Active cores are: ");
-
-	int i;
-	for (i = 0; i < cores; i++)
-	{
-		if (i == cores - 1)
-			printf("%d\n", i);
-		else
-			printf("%d, ", i);
-	}
-}
-
-
-int main(int argc, char **argv)
-{
-	int c;
-	int cores = 0, scheme = -1, quantum = 0;
-	char *file_name;
-
-	/*
-	 * Parse command line options.
-	 */
-	while ((c = getopt(argc, argv, "c:s:")) != -1)
-	{
-		switch (c)
-		{
-			case 'c':
-				cores = atoi(optarg);
-
-				if (cores <= 0)
-				{
-					fprintf(stderr, "Option -c <cores> require a positive number.\n");
-					print_usage(argv[0]);
-					return 1;
-				}
-				break;
-
-			case 's':
-				if (strcasecmp(optarg, "FCFS") == 0) { scheme = FCFS; }
-				else if (strcasecmp(optarg, "SJF") == 0) { scheme = SJF; }
-				else if (strcasecmp(optarg, "PSJF") == 0) { scheme = PSJF; }
-				else if (strcasecmp(optarg, "PRI") == 0) { scheme = PRI; }
-				else if (strcasecmp(optarg, "PPRI") == 0) { scheme = PPRI; }
-				else if (strncasecmp(optarg, "RR", 2) == 0)
-				{
-					scheme = RR;
-					quantum = atoi(optarg + 2);
-
-					if (quantum <= 0)
-					{
-						fprintf(stderr, "Option -s <scheme> requires a positive number for the quantum of RR. (Eg: -s RR2)\n");
-						print_usage(argv[0]);
-						return 1;
-					}
-				}
-				break;
-
-			case '?':
-				print_usage(argv[0]);
-				return 1;
-
-			default:
-				printf("...\n");
-				break;
-		}
-	}
-
-	if (cores == 0)
-	{
-		fprintf(stderr, "Required option -c <cores> is not present.\n");
-		print_usage(argv[0]);
-		return 1;
-	}
-
-	if (scheme == -1)
-	{
-		fprintf(stderr, "Required option -s <scheme> is not present.\n");
-		print_usage(argv[0]);
-		return 1;
-	}
-
-	if (optind == argc - 1)
-		file_name = argv[optind];
-	else
-	{
-		fprintf(stderr, "A single input file is required.\n");
-		print_usage(argv[0]);
-		return 1;
-	}
-
-
-	/*
-	 * Open the file, read the file, and populate the jobs data structure.
-	 */
-	FILE *file = fopen(file_name, "r");
-	if (file == NULL)
-	{
-		fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
-		return 2;
-	}
-
-
-	int job_id = 0;
-	int jobs_ct = 10;
-	simulator_job_list_t* jobs = malloc(jobs_ct * sizeof(simulator_job_list_t));
-
-	char line[1024 + 1];
-	fgets(line, 1024, file);  // Ignore the first (header) line
-	while (fgets(line, 1024, file) != NULL)
-	{
-		char *arrival_time = strtok(line, ",");
-		char *run_time = strtok(NULL, ",");
-		char *priority = strtok(NULL, ",");
-
-		if (arrival_time != NULL && run_time != NULL && priority != NULL)
-		{
-			if (job_id == jobs_ct)
-			{
-				jobs_ct *= 2;
-				jobs = realloc(jobs, jobs_ct * sizeof(simulator_job_list_t));
-
-				if (!jobs)
-				{
-					fprintf(stderr, "Out of memory.\n");
-					return 2;
-				}
-			}
-
-			jobs[job_id].job_id = job_id;
-			jobs[job_id].arrival_time = atoi(arrival_time);
-			jobs[job_id].run_time = atoi(run_time);
-			jobs[job_id].priority = atoi(priority);
-			jobs[job_id].core_id = -1;
-			jobs[job_id].arrived = 0;
-
-			job_id++;
-		}
-		else
-		{
-			fprintf(stderr, "Illegal file format.\n");
-			return 2;
-		}
-	}
-
-	fclose(file);
-
-
-	/*
-	 * Run the simulation.
-	 */
-
-	printf("Loaded %d core(s) and %d job(s) using ", cores, job_id);
-	if (scheme == FCFS) { printf("First Come First Served (FCFS)"); }
-	else if (scheme == SJF) { printf("Non-preemptive Shortest Job First (SJF)"); }
-	else if (scheme == PSJF) { printf("Preemptive Shortest Job First (PSJF)"); }
-	else if (scheme == PRI) { printf("Non-preemptive Priority (PRI)"); }
-	else if (scheme == PPRI) { printf("Preemptive Priority (PPRI)"); }
-	else if (scheme == RR) { printf("Round Robin (RR) with a quantum of %d", quantum); }
-	printf(" scheduling...\n\n");
-
-	scheduler_start_up(cores, scheme);
-
-
-	int time = 0, i, j;
-	int active_jobs = job_id, jobs_alive = 0;
-
-	int *quantum_clock = malloc(cores * sizeof(int));
-	char **core_timing_diagram = malloc(cores * sizeof(char *));
-	int core_timing_diagram_size = 1024;
-
-	for (i = 0; i < cores; i++)
-	{
-		quantum_clock[i] = -1;
-		core_timing_diagram[i] = malloc(core_timing_diagram_size + 1);
-		core_timing_diagram[i][0] = '\0';
-	}
-
-	while (active_jobs > 0)
-	{
-		printf("=== [TIME %d] ===\n", time);
-
-		/*
-		 * 1. Check if any jobs finished in the last time unit.
-		 */
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].run_time == 0)
-			{
-				// Notify the scheduler has finished
-				int job_id = jobs[i].job_id;
-				int core_id = jobs[i].core_id;
-				int new_job_id = scheduler_job_finished(jobs[i].core_id, jobs[i].job_id, time);
-
-				if (scheme == RR)
-					quantum_clock[jobs[i].core_id] = quantum;
-
-				// Delete the finished jobs, decrease the number of active jobs
-				if (i != active_jobs - 1)
-					memcpy(&jobs[i], &jobs[active_jobs - 1], sizeof(simulator_job_list_t));
-				active_jobs--;
-				jobs_alive--;
-				i--;
-
-				// Set the new job
-				if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
-				{
-					printf("The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
-					print_available_jobs(jobs, active_jobs);
-					return 3;
-				}
-				else
-				{
-					printf("Job %d, running on core %d, finished. Core %d is now running job %d.\n", job_id, core_id, core_id, new_job_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-				}
-			}
-		}
-
-		/*
-		 * Check to see if we finished our last job.  (If we don't check here, we would run an extra time unit that will be totally idle.)
-		 */
-		if (active_jobs == 0)
-			break;
-
-		/*
-		 * 2. Check of any quantums expired in the last time unit.
-		 */
-		if (scheme == RR)
-		{
-			for (i = 0; i < cores; i++)
-			{
-				if (quantum_clock[i] == 0)
-				{
-					for (j = 0; j < active_jobs; j++)
-					{
-						if (jobs[j].core_id == i)
-						{
-							// Notify the scheduler the quantum has expired
-							int core_id = jobs[j].core_id;
-							int old_job_id = jobs[j].job_id;
-							int new_job_id = scheduler_quantum_expired(jobs[j].core_id, time);
-
-							jobs[j].core_id = -1;
-
-							quantum_clock[core_id] = quantum;
-
-							// Set the new job
-							if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
-							{
-								printf("The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
-								print_available_jobs(jobs, active_jobs);
-								return 3;
-							}
-							else
-							{
-								printf("Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
-								printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-							}
-
-							break;
-						}
-					}
-				}
-			}
-		}
-
-
-		/*
-		 * 3. Check for any new jobs that arrive in this time unit
-		 */
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].arrival_time == time)
-			{
-				int new_job_core_id = scheduler_new_job(jobs[i].job_id, time, jobs[i].run_time, jobs[i].priority);
-				jobs[i].arrived = 1;
-				jobs_alive++;
-
-				if (new_job_core_id >= 0 && new_job_core_id < cores)
-				{
-					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is now running on core %d.\n",
-							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id, new_job_core_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-
-					// Find if anyone is currently using the core.
-					for (j = 0; j < active_jobs; j++)
-						if (jobs[j].core_id == new_job_core_id)
-							jobs[j].core_id = -1;
-
-					// Assign the core to the new job
-					jobs[i].core_id = new_job_core_id;
-
-					if (scheme == RR)
-						quantum_clock[new_job_core_id] = quantum;
-				}
-				else if (new_job_core_id == -1)
-				{
-					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is set to idle (-1).\n",
-							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-				}
-				else
-				{
-					printf("The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
-					print_available_cores(cores);
-					return 3;
-				}
-			}
-		}
-
-
-		/*
-		 * 4. Run the time unit.
-		 */
-		char time_string[cores][11];
-		int cores_working = 0;
-
-		for (i = 0; i < cores; i++)
-			time_string[i][0] = '\0';
-
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].core_id != -1)
-			{
-				cores_working++;
-				jobs[i].run_time--;
-				quantum_clock[jobs[i].core_id]--;
-
-				assert(time_string[jobs[i].core_id][0] == '\0');
-
-				if (jobs[i].job_id < 10)
-					sprintf(time_string[jobs[i].core_id], "%d", jobs[i].job_id);
-				else if (jobs[i].job_id < 10 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 + 'a');
-				else if (jobs[i].job_id < 10 + 26 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 - 26 + 'A');
-				else
-					snprintf(time_string[jobs[i].core_id], 10, "(%d)", jobs[i].job_id);
-			}
-		}
-
-		for (i = 0; i < cores; i++)
-		{
-			// If the core is idle, print a '-'
-			if (time_string[i][0] == '\0')
-				strcpy(time_string[i], "-");
-
-			// Ensure we have enough memory
-			while (strlen(core_timing_diagram[i]) + strlen(time_string[i]) >= (unsigned int)core_timing_diagram_size)
-			{
-				core_timing_diagram_size *= 2;
-
-				for (j = 0; j < cores; j++)
-				{
-					core_timing_diagram[j] = realloc(core_timing_diagram[j], core_timing_diagram_size + 1);
-
-					if (core_timing_diagram[j] == NULL)
-					{
-						fprintf(stderr, "Out of memory.\n");
-						return 3;
-					}
-				}
-			}
-
-			strcat( core_timing_diagram[i], time_string[i] );
-		}
-
-
-		/*
-		 * 5. Print data!
-		 */
-		printf("At the end of time unit %d...\n", time);
-
-		for (i = 0; i < cores; i++)
-			printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
-
-		printf("\n");
-
-		printf("  Queue: ");
-		scheduler_show_queue();
-		printf("\n");
-		printf("\n");
-
-
-		/*
-		 * 6. Sanity Checking
-		 *
-		 * - If there's a job alive (needing to be ran) and all CPUs are idle, the scheduler failed to schedule properly.
-		 */
-		if (jobs_alive > 0 && cores_working == 0)
-		{
-			printf("All cores are idle and at least one job remains unscheduled.\n");
-			print_available_jobs(jobs, active_jobs);
-			return 3;
-		}
-
-
-		/*
-		 * 7. Increase time
-		 */
-		time++;
-	}
-
-
-	printf("FINAL TIMING DIAGRAM:\n");
-	for (i = 0; i < cores; i++)
-		printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
-
-	printf("\n");
-	printf("Average Waiting Time: %.2f\n", scheduler_average_waiting_time());
-	printf("Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time());
-	printf("Average Response Time: %.2f\n", scheduler_average_response_time());
-
-	scheduler_clean_up();
-
-
-	free(quantum_clock);
-	for (i=0; i < cores; i++)
-		free(core_timing_diagram[i]);
-	free(core_timing_diagram);
-	free(jobs);
-
-	return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libeventq/libeventq.h"
+#include "libtimerwheel/libtimerwheel.h"
+#include "libworkload/libworkload.h"
+#include "libtrace/libtrace.h"
+
+
+typedef struct _simulator_job_list_t
+{
+	int job_id, arrival_time, run_time, priority;
+	int core_id, arrived, finished;
+	int switches;           // times a core switched to the job
+} simulator_job_list_t;
+
+/**
+  Where a job is in its CPU bursts and I/O waits.  Only workloads with bursts
+  have these, apart from the job list, so runs without I/O carry none of it.
+*/
+typedef struct _simulator_io_t
+{
+	int burst_run;          // run time left in the current CPU burst
+	const int *bursts;      // the I/O waits and CPU bursts that follow it, in turn
+	int bursts_left;        // entries left in bursts, always even
+	int blocked;
+} simulator_io_t;
+
+/**
+  A job's place in the arrival order.
+*/
+typedef struct _simulator_arrival_t
+{
+	int arrival_time, job_id;
+} simulator_arrival_t;
+
+/**
+  A run of consecutive time units in which a core ran the same job.
+*/
+typedef struct _timing_segment_t
+{
+	int job_id, start, end;
+} timing_segment_t;
+
+/**
+  Per-core record of which job ran in each time unit, stored as run-length
+  segments so that memory grows with the number of context switches rather
+  than with elapsed time.  Idle time is the gaps between segments.
+*/
+typedef struct _timing_diagram_t
+{
+	int cores;
+	timing_segment_t **segments;  // finished segments of each core, in time order
+	int *count, *size;
+	int *open_job, *open_start;   // job each core has been running since open_start, or -1
+	int window_start, window_end; // time units to render (window_end == -1 means no end)
+	int width;                    // if positive, only the last width time units are rendered
+} timing_diagram_t;
+
+/**
+  Engines that drive the simulation clock.
+*/
+typedef enum {TICK_DRIVEN = 0, EVENT_DRIVEN} engine_t;
+
+/**
+  How much the simulator reports while it runs.  Every level ends with the
+  final timing diagram and the average metrics.
+*/
+typedef enum {OUTPUT_SUMMARY = 0, OUTPUT_EVENTS, OUTPUT_FULL} output_t;
+
+/**
+  Size of the buffer all simulator output is written through.
+*/
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/**
+  Number of parsed jobs the loader thread (-L) may run ahead of the simulation.
+*/
+#define LOADER_RING_CAPACITY 4096
+
+/**
+  Values getopt_long() returns for the options that only have a long form.
+*/
+#define OPTION_STATS 256
+#define OPTION_TRACE 257
+#define OPTION_SWITCH_COST 258
+
+/**
+  Kinds of deadlines a core can have.  Deadlines sharing a time are delivered
+  in this order, and before any arrivals at that time.
+*/
+typedef enum {EVENT_COMPLETION = 0, EVENT_QUANTUM_EXPIRY} event_type_t;
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> [-m <engine>] [-o <output>] [-w <window>] [-S] [-L] [--stats] [--trace <trace file>] [--switch-cost <ticks>] <input file>\n", program_name);
+	fprintf(stderr, "       %s -c <cores> -s <scheme> [options] -g <workload specification>\n", program_name);
+	fprintf(stderr, "       %s -x <grid> [-m <engine>] <input file>\n", program_name);
+	fprintf(stderr, "       %s -c 2 -s fcfs examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s -c 4 -s rr2 -S -o summary -g n=1000000,arrival=bursty:0.4:8,run=pareto:1.5:2\n", program_name);
+	fprintf(stderr, "       %s -x schemes=fcfs/psjf/rr,cores=1/2/4,quanta=1/4,format=json examples/proc1.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#\n");
+	fprintf(stderr, "Acceptable engines are: tick (default), event\n");
+	fprintf(stderr, "Acceptable outputs are: full (default, every time unit), events (scheduler calls only), summary (results only)\n");
+	fprintf(stderr, "Timing diagram windows are: <start>:<end> (time units start to end-1), <start>: or <width> (the last width time units)\n");
+	fprintf(stderr, "With -o summary, the timing diagram is left out unless a window is given with -w\n");
+	fprintf(stderr, "Input files are CSV or binary workloads written by workloadconv, or - for the standard input\n");
+	fprintf(stderr, "With -S, jobs are streamed: read as their arrival time is reached (in arrival order) and freed when they finish\n");
+	fprintf(stderr, "With -L, jobs are streamed and parsed ahead on a loader thread\n");
+	fprintf(stderr, "With --stats, the scheduler's counters (calls, allocations, comparisons, queue depth, preemptions and\n");
+	fprintf(stderr, "context switches) are printed after the averages\n");
+	fprintf(stderr, "With --trace, the schedule is also written as Chrome Trace Event JSON, for chrome://tracing or Perfetto:\n");
+	fprintf(stderr, "a track per core with a slice per run of a job, and instant events for arrivals, preemptions and quantum\n");
+	fprintf(stderr, "expiries.  One time unit is shown as one microsecond\n");
+	fprintf(stderr, "With --switch-cost, a core spends that many time units switching whenever it runs a job other than the last\n");
+	fprintf(stderr, "one it ran, before the job makes progress; the switches by core and the time lost to them are reported\n");
+	fprintf(stderr, "Jobs with CPU bursts and I/O waits (a Bursts column, or io= with -g) block on I/O between bursts, leaving their\n");
+	fprintf(stderr, "core free; the I/O overlapped with work, CPU utilization and throughput are reported.  -S and -L refuse bursts\n");
+	fprintf(stderr, "With -x, every configuration of a grid is simulated in parallel and a comparison table is printed.  The grid is a\n");
+	fprintf(stderr, "comma-separated list of schemes=<scheme>/... (rr takes every quantum), cores=<n>/..., quanta=<n>/..., threads=<n>\n");
+	fprintf(stderr, "and format=csv|json; it may be combined with --switch-cost\n");
+	fprintf(stderr, "With -g, jobs are generated instead of read from a file.  ");
+	workgen_usage(stderr);
+}
+
+void print_scheduler_stats(scheduler_t *scheduler)
+{
+	scheduler_stats_t stats;
+	int i;
+
+	scheduler_get_stats_r(scheduler, &stats);
+
+	printf("\n");
+	printf("Scheduler statistics:\n");
+	printf("  New job calls: %lu\n", stats.m_new_job_calls);
+	printf("  Job finished calls: %lu\n", stats.m_job_finished_calls);
+	printf("  Quantum expired calls: %lu\n", stats.m_quantum_expired_calls);
+	if (stats.m_job_blocked_calls > 0)
+	{
+		printf("  Job blocked calls: %lu\n", stats.m_job_blocked_calls);
+		printf("  Job woke calls: %lu\n", stats.m_job_woke_calls);
+	}
+	printf("  Job allocations: %lu\n", stats.m_job_allocations);
+	printf("  Queue node allocations: %lu\n", stats.m_node_allocations);
+	printf("  Comparisons: %lu\n", stats.m_comparisons);
+	printf("  Queue depth: %d (max %d, mean %.2f)\n", stats.m_queue_depth, stats.m_max_queue_depth, stats.m_mean_queue_depth);
+	printf("  Preemptions: %lu\n", stats.m_preemptions);
+	printf("  Context switches:");
+	for (i = 0; i < stats.m_cores; i++)
+		printf(" %lu", stats.m_context_switches[i]);
+	printf(" (by core)\n");
+}
+
+void print_available_jobs(simulator_job_list_t *jobs, int job_count)
+{
+	printf("Active jobs are: ");
+
+	int i, first = 1;
+	for (i = 0; i < job_count; i++)
+	{
+		if (jobs[i].arrived && !jobs[i].finished)
+		{
+			if (first)
+			{
+				printf("%d", jobs[i].job_id);
+				first = 0;
+			}
+			else
+				printf(", %d", jobs[i].job_id);
+		}
+	}
+
+	if (!first)
+		printf("\n");
+}
+
+void print_available_cores(int cores)
+{
+	printf("Active cores are: ");
+
+	int i;
+	for (i = 0; i < cores; i++)
+	{
+		if (i == cores - 1)
+			printf("%d\n", i);
+		else
+			printf("%d, ", i);
+	}
+}
+
+/**
+  Jobs that have arrived and not yet finished, keyed by job_id, used when
+  jobs are streamed rather than loaded up front.  Open addressing with linear
+  probing; removal shifts later entries back rather than leaving tombstones,
+  and the table shrinks as it empties, so its size stays proportional to the
+  number of jobs in flight.
+*/
+typedef struct _job_table_t
+{
+	simulator_job_list_t *slots;  // job_id == -1 marks an empty slot
+	int size, count;
+} job_table_t;
+
+#define JOB_TABLE_MIN_SIZE 16
+
+static unsigned int job_table_hash(job_table_t *table, int job_id)
+{
+	return ((unsigned int)job_id * 2654435761u) & (table->size - 1);
+}
+
+int job_table_init(job_table_t *table, int size)
+{
+	int i;
+
+	table->slots = malloc(size * sizeof(simulator_job_list_t));
+	table->size = size;
+	table->count = 0;
+	if (table->slots == NULL)
+		return -1;
+
+	for (i = 0; i < size; i++)
+		table->slots[i].job_id = -1;
+	return 0;
+}
+
+/**
+  Returns the job with the given job_id, or NULL if it is not in the table.
+ */
+simulator_job_list_t *job_table_find(job_table_t *table, int job_id)
+{
+	unsigned int i = job_table_hash(table, job_id);
+
+	while (table->slots[i].job_id != -1)
+	{
+		if (table->slots[i].job_id == job_id)
+			return &table->slots[i];
+		i = (i + 1) & (table->size - 1);
+	}
+
+	return NULL;
+}
+
+/**
+  Rebuilds the table with a new power-of-two size.
+ */
+int job_table_resize(job_table_t *table, int size)
+{
+	job_table_t resized;
+	int i;
+
+	if (job_table_init(&resized, size) != 0)
+		return -1;
+
+	for (i = 0; i < table->size; i++)
+	{
+		if (table->slots[i].job_id != -1)
+		{
+			unsigned int j = job_table_hash(&resized, table->slots[i].job_id);
+			while (resized.slots[j].job_id != -1)
+				j = (j + 1) & (size - 1);
+			resized.slots[j] = table->slots[i];
+		}
+	}
+
+	resized.count = table->count;
+	free(table->slots);
+	*table = resized;
+	return 0;
+}
+
+/**
+  Adds a job to the table.  Pointers into the table are invalidated.
+
+  @return the job's entry in the table, or NULL if out of memory
+ */
+simulator_job_list_t *job_table_insert(job_table_t *table, simulator_job_list_t *job)
+{
+	if (2 * (table->count + 1) > table->size && job_table_resize(table, 2 * table->size) != 0)
+		return NULL;
+
+	unsigned int i = job_table_hash(table, job->job_id);
+	while (table->slots[i].job_id != -1)
+		i = (i + 1) & (table->size - 1);
+
+	table->slots[i] = *job;
+	table->count++;
+	return &table->slots[i];
+}
+
+/**
+  Removes a job from the table.  Pointers into the table are invalidated.
+ */
+void job_table_remove(job_table_t *table, int job_id)
+{
+	simulator_job_list_t *job = job_table_find(table, job_id);
+	if (job == NULL)
+		return;
+
+	unsigned int hole = job - table->slots, i = hole;
+	unsigned int mask = table->size - 1;
+
+	// Shift back every later entry of the probe run that may sit in the hole
+	for (;;)
+	{
+		i = (i + 1) & mask;
+		if (table->slots[i].job_id == -1)
+			break;
+
+		unsigned int home = job_table_hash(table, table->slots[i].job_id);
+		if (((i - home) & mask) >= ((i - hole) & mask))
+		{
+			table->slots[hole] = table->slots[i];
+			hole = i;
+		}
+	}
+
+	table->slots[hole].job_id = -1;
+	table->count--;
+
+	if (table->size > JOB_TABLE_MIN_SIZE && 8 * table->count < table->size)
+		job_table_resize(table, table->size / 2);
+}
+
+void job_table_destroy(job_table_t *table)
+{
+	free(table->slots);
+}
+
+int compare_job_ids(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+int compare_arrivals(const void *a, const void *b)
+{
+	const simulator_arrival_t *x = a, *y = b;
+
+	if (x->arrival_time != y->arrival_time)
+		return (x->arrival_time < y->arrival_time) ? -1 : 1;
+	return x->job_id - y->job_id;
+}
+
+/**
+  Builds the arrival order of the jobs: by arrival time, ties broken by job_id.
+  Traces are usually already in arrival order, in which case no sort is done.
+
+  @return the arrivals array, or NULL if out of memory
+ */
+simulator_arrival_t *sort_arrivals(simulator_job_list_t *jobs, int job_count)
+{
+	simulator_arrival_t *arrivals = malloc((job_count > 0 ? job_count : 1) * sizeof(simulator_arrival_t));
+	int i, sorted = 1;
+
+	if (arrivals == NULL)
+		return NULL;
+
+	for (i = 0; i < job_count; i++)
+	{
+		arrivals[i].arrival_time = jobs[i].arrival_time;
+		arrivals[i].job_id = jobs[i].job_id;
+
+		if (i > 0 && arrivals[i].arrival_time < arrivals[i - 1].arrival_time)
+			sorted = 0;
+	}
+
+	if (!sorted)
+		qsort(arrivals, job_count, sizeof(simulator_arrival_t), compare_arrivals);
+
+	return arrivals;
+}
+
+void job_symbol(int job_id, char *symbol)
+{
+	if (job_id < 0)
+		strcpy(symbol, "-");
+	else if (job_id < 10)
+		sprintf(symbol, "%d", job_id);
+	else if (job_id < 10 + 26)
+		sprintf(symbol, "%c", job_id - 10 + 'a');
+	else if (job_id < 10 + 26 + 26)
+		sprintf(symbol, "%c", job_id - 10 - 26 + 'A');
+	else
+		snprintf(symbol, 16, "(%d)", job_id);
+}
+
+void timing_diagram_init(timing_diagram_t *diagram, int cores)
+{
+	int i;
+
+	diagram->cores = cores;
+	diagram->segments = malloc(cores * sizeof(timing_segment_t *));
+	diagram->count = malloc(cores * sizeof(int));
+	diagram->size = malloc(cores * sizeof(int));
+	diagram->open_job = malloc(cores * sizeof(int));
+	diagram->open_start = malloc(cores * sizeof(int));
+	diagram->window_start = 0;
+	diagram->window_end = -1;
+	diagram->width = 0;
+
+	for (i = 0; i < cores; i++)
+	{
+		diagram->count[i] = 0;
+		diagram->size[i] = 16;
+		diagram->segments[i] = malloc(diagram->size[i] * sizeof(timing_segment_t));
+		diagram->open_job[i] = -1;
+		diagram->open_start[i] = 0;
+	}
+}
+
+/**
+  Records that a core starts running a job at time.  A job that resumes on the
+  core it just left continues its previous segment.
+ */
+void timing_diagram_start(timing_diagram_t *diagram, int core_id, int job_id, int time)
+{
+	int last = diagram->count[core_id] - 1;
+
+	if (last >= 0 && diagram->segments[core_id][last].job_id == job_id && diagram->segments[core_id][last].end == time)
+	{
+		diagram->open_start[core_id] = diagram->segments[core_id][last].start;
+		diagram->count[core_id]--;
+	}
+	else
+		diagram->open_start[core_id] = time;
+
+	diagram->open_job[core_id] = job_id;
+}
+
+/**
+  Returns the time before which no segment will ever be rendered, given the
+  window the diagram is limited to and that the clock has reached time.
+ */
+int timing_diagram_horizon(timing_diagram_t *diagram, int time)
+{
+	int horizon = diagram->window_start;
+
+	if (diagram->width > 0)
+	{
+		int to = (diagram->window_end != -1 && diagram->window_end < time) ? diagram->window_end : time;
+		if (to - diagram->width > horizon)
+			horizon = to - diagram->width;
+	}
+
+	return horizon;
+}
+
+/**
+  Drops the segments of a core that end before the horizon.  With a window
+  configured, this keeps the diagram's memory bounded however long the
+  simulation runs.
+ */
+void timing_diagram_prune(timing_diagram_t *diagram, int core_id, int time)
+{
+	timing_segment_t *segments = diagram->segments[core_id];
+	int horizon = timing_diagram_horizon(diagram, time);
+	int count = diagram->count[core_id], dropped = 0;
+
+	while (dropped < count && segments[dropped].end <= horizon)
+		dropped++;
+
+	if (dropped > 0)
+	{
+		memmove(segments, segments + dropped, (count - dropped) * sizeof(timing_segment_t));
+		diagram->count[core_id] = count - dropped;
+	}
+}
+
+/**
+  Records that a core stops running its job at time.  Segments past the end
+  of the window are not recorded.
+ */
+void timing_diagram_stop(timing_diagram_t *diagram, int core_id, int time)
+{
+	if (diagram->open_job[core_id] == -1)
+		return;
+
+	if (time > diagram->open_start[core_id] && (diagram->window_end == -1 || diagram->open_start[core_id] < diagram->window_end))
+	{
+		if (diagram->count[core_id] == diagram->size[core_id])
+		{
+			// Make room by dropping segments that can no longer be rendered,
+			// growing only if that frees less than half of the array
+			timing_diagram_prune(diagram, core_id, time);
+
+			if (diagram->count[core_id] > diagram->size[core_id] / 2)
+			{
+				diagram->size[core_id] *= 2;
+				diagram->segments[core_id] = realloc(diagram->segments[core_id], diagram->size[core_id] * sizeof(timing_segment_t));
+				if (diagram->segments[core_id] == NULL)
+				{
+					fprintf(stderr, "Out of memory.\n");
+					exit(3);
+				}
+			}
+		}
+
+		timing_segment_t *segment = &diagram->segments[core_id][diagram->count[core_id]++];
+		segment->job_id = diagram->open_job[core_id];
+		segment->start = diagram->open_start[core_id];
+		segment->end = time;
+	}
+
+	diagram->open_job[core_id] = -1;
+}
+
+void print_repeated(const char *symbol, int count)
+{
+	while (count-- > 0)
+		fputs(symbol, stdout);
+}
+
+/**
+  Renders one core's line covering the time units [from, to).
+ */
+void timing_diagram_print_core(timing_diagram_t *diagram, int core_id, int from, int to)
+{
+	timing_segment_t *segments = diagram->segments[core_id];
+	int count = diagram->count[core_id];
+	int low = 0, high = count, position = from;
+	char symbol[16];
+
+	// Find the first segment that ends after from
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (segments[middle].end <= from)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	for (; position < to; low++)
+	{
+		int job_id, start, end;
+
+		if (low < count)
+		{
+			job_id = segments[low].job_id;
+			start = segments[low].start;
+			end = segments[low].end;
+		}
+		else if (low == count && diagram->open_job[core_id] != -1)
+		{
+			job_id = diagram->open_job[core_id];
+			start = diagram->open_start[core_id];
+			end = to;
+		}
+		else
+		{
+			job_id = -1;
+			start = end = to;
+		}
+
+		if (start > to)
+			start = to;
+		if (end > to)
+			end = to;
+
+		if (start > position)
+		{
+			print_repeated("-", start - position);
+			position = start;
+		}
+
+		if (end > position)
+		{
+			job_symbol(job_id, symbol);
+			print_repeated(symbol, end - position);
+			position = end;
+		}
+	}
+}
+
+/**
+  Prints the diagram of every core up to (but not including) time until,
+  limited to the window and width the diagram was configured with.  Lines cut
+  short by the window are marked with "...".
+ */
+void timing_diagram_print(timing_diagram_t *diagram, int until)
+{
+	int from = diagram->window_start, to = until;
+	int i;
+
+	if (diagram->window_end != -1 && diagram->window_end < to)
+		to = diagram->window_end;
+	if (diagram->width > 0 && to - diagram->width > from)
+		from = to - diagram->width;
+	if (from > to)
+		from = to;
+
+	for (i = 0; i < diagram->cores; i++)
+	{
+		printf("  Core %2d: ", i);
+		if (from > 0)
+			printf("...");
+		timing_diagram_print_core(diagram, i, from, to);
+		if (to < until)
+			printf("...");
+		printf("\n");
+	}
+}
+
+void timing_diagram_destroy(timing_diagram_t *diagram)
+{
+	int i;
+	for (i = 0; i < diagram->cores; i++)
+		free(diagram->segments[i]);
+	free(diagram->segments);
+	free(diagram->count);
+	free(diagram->size);
+	free(diagram->open_job);
+	free(diagram->open_start);
+}
+
+
+/**
+  A completion or quantum expiry that is due in the current time unit.
+*/
+typedef struct _simulator_due_t
+{
+	int type, core_id, generation;
+} simulator_due_t;
+
+/**
+  State of a running simulation.
+
+  Jobs are indexed by job_id and arrivals are consumed from the time-sorted
+  arrivals array through a cursor.  When jobs are streamed instead, the next
+  job is read from the reader only once the previous one has arrived, and
+  jobs live in a job table from their arrival until they finish.  Each core has at most one pending
+  completion and, under RR, one pending quantum expiry; the tick-driven engine
+  keeps them on a timing wheel and the event-driven engine in an event queue.
+  With bursts (io non-NULL), a job's completion deadline is the end of its
+  current CPU burst; if I/O follows, the job blocks and both engines keep its
+  wake-up in the wakes queue, keyed by job_id.
+*/
+typedef struct _simulation_t
+{
+	simulator_job_list_t *jobs;
+	int job_count;
+	simulator_arrival_t *arrivals;
+	int next_arrival;
+
+	workload_reader_t *reader;  // non-NULL when jobs are streamed
+	job_table_t table;
+	simulator_job_list_t next_job;
+	int has_next_job;
+
+	int cores, scheme, quantum;
+	engine_t engine;
+	output_t output;
+	int header_time;       // last time unit whose header was printed
+
+	int *core_job;         // job_id running on each core, or -1
+	int *core_since;       // time the running job was placed on each core
+	int *core_generation;  // bumped whenever a core changes jobs, invalidating its pending deadlines
+	int cores_working, jobs_alive;
+
+	int switch_cost;       // time units a core spends switching to a job other than its last
+	int *core_last_job;    // job_id each core last ran, or -1
+	int *core_overhead;    // switching time the running job was placed with on each core
+	long long *core_switches;
+	long long busy;        // time units cores spent running jobs, switching included
+	long long switch_lost; // of those, time units spent switching
+	int max_job_switches;
+
+	timerwheel_t wheel;
+	wheel_timer_t *timers; // completion and quantum timer of each core (tick-driven)
+	eventq_t events;       // deadlines of each core (event-driven)
+
+	simulator_due_t *due;
+	int due_count;
+
+	timing_diagram_t *diagram;
+	trace_t *trace;        // non-NULL when the schedule is traced
+	scheduler_t *scheduler;
+	long long calls;       // scheduler calls made so far
+	int time;              // the earliest time unit still to be visited
+
+	// Only used with bursts, after everything a run without I/O touches
+	simulator_io_t *io;    // bursts of each job by job_id, or NULL if the jobs have none
+	int jobs_blocked;
+	eventq_t wakes;        // I/O completions of blocked jobs
+	long long blocks;      // times jobs blocked on I/O
+	long long io_time;     // time units in which I/O was in progress
+	long long io_overlap;  // of those, time units in which a core was busy too
+	int io_since;          // time the I/O totals were last brought up to
+} simulation_t;
+
+/**
+  Initializes a simulation of the jobs on a number of cores.
+
+  @return 0 on success, -1 if out of memory
+ */
+int simulation_init(simulation_t *sim, simulator_job_list_t *jobs, int job_count, simulator_arrival_t *arrivals,
+		int cores, int scheme, int quantum, engine_t engine, output_t output, timing_diagram_t *diagram, scheduler_t *scheduler)
+{
+	int i, queued;
+
+	sim->jobs = jobs;
+	sim->job_count = job_count;
+	sim->arrivals = arrivals;
+	sim->next_arrival = 0;
+	sim->reader = NULL;
+	sim->has_next_job = 0;
+	sim->cores = cores;
+	sim->scheme = scheme;
+	sim->quantum = quantum;
+	sim->engine = engine;
+	sim->output = output;
+	sim->header_time = -1;
+
+	sim->core_job = malloc(cores * sizeof(int));
+	sim->core_since = malloc(cores * sizeof(int));
+	sim->core_generation = malloc(cores * sizeof(int));
+	sim->cores_working = 0;
+	sim->jobs_alive = 0;
+	sim->jobs_blocked = 0;
+
+	sim->switch_cost = 0;
+	sim->core_last_job = malloc(cores * sizeof(int));
+	sim->core_overhead = malloc(cores * sizeof(int));
+	sim->core_switches = malloc(cores * sizeof(long long));
+	sim->busy = 0;
+	sim->switch_lost = 0;
+	sim->max_job_switches = 0;
+
+	sim->io = NULL;
+	queued = eventq_init(&sim->wakes, 16);
+	sim->blocks = 0;
+	sim->io_time = 0;
+	sim->io_overlap = 0;
+	sim->io_since = 0;
+
+	sim->timers = malloc(2 * cores * sizeof(wheel_timer_t));
+	sim->due = malloc(2 * cores * sizeof(simulator_due_t));
+	sim->due_count = 0;
+
+	if (eventq_init(&sim->events, 2 * cores) != 0)
+		queued = -1;
+	if (queued != 0 || sim->core_job == NULL || sim->core_since == NULL || sim->core_generation == NULL || sim->core_last_job == NULL
+			|| sim->core_overhead == NULL || sim->core_switches == NULL || sim->timers == NULL || sim->due == NULL)
+		return -1;
+
+	for (i = 0; i < cores; i++)
+	{
+		sim->core_job[i] = -1;
+		sim->core_since[i] = 0;
+		sim->core_generation[i] = 0;
+		sim->core_last_job[i] = -1;
+		sim->core_overhead[i] = 0;
+		sim->core_switches[i] = 0;
+	}
+
+	for (i = 0; i < 2 * cores; i++)
+		timerwheel_timer(&sim->timers[i], i);
+
+	timerwheel_init(&sim->wheel, 0);
+
+	sim->diagram = diagram;
+	sim->trace = NULL;
+	sim->scheduler = scheduler;
+	sim->calls = 0;
+	sim->time = 0;
+	return 0;
+}
+
+void simulation_destroy(simulation_t *sim)
+{
+	if (sim->reader != NULL)
+		job_table_destroy(&sim->table);
+	eventq_destroy(&sim->events);
+	eventq_destroy(&sim->wakes);
+	free(sim->core_job);
+	free(sim->core_since);
+	free(sim->core_generation);
+	free(sim->core_last_job);
+	free(sim->core_overhead);
+	free(sim->core_switches);
+	free(sim->timers);
+	free(sim->due);
+}
+
+/**
+  Prints why a workload could not be read, or, for WORKLOAD_ERROR_COLUMN, why
+  the optional column named by column cannot be simulated.
+ */
+void print_workload_error(workload_status_t status, const char *file_name, const char *spec, int line, const char *column)
+{
+	if (status == WORKLOAD_ERROR_COLUMN && strcmp(column, "Cores") == 0)
+		fprintf(stderr, "The workload has a \"Cores\" column; jobs that need several cores are only simulated by ./backfill.\n");
+	else if (status == WORKLOAD_ERROR_COLUMN && strcmp(column, "Bursts") == 0)
+		fprintf(stderr, "The workload has CPU bursts, which are not simulated with -S or -L.\n");
+	else if (status == WORKLOAD_ERROR_COLUMN && strcmp(column, "Dependencies") == 0)
+		fprintf(stderr, "The workload has a \"Dependencies\" column; jobs that depend on others are only simulated by ./dag.\n");
+	else if (spec != NULL && status == WORKLOAD_ERROR_FORMAT)
+		fprintf(stderr, "Illegal workload specification \"%s\".\n", spec);
+	else if (status == WORKLOAD_ERROR_OPEN)
+		fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+	else if (status == WORKLOAD_ERROR_FORMAT && line > 0)
+		fprintf(stderr, "Illegal file format on line %d.\n", line);
+	else if (status == WORKLOAD_ERROR_FORMAT)
+		fprintf(stderr, "Illegal file format.\n");
+	else
+		fprintf(stderr, "Out of memory.\n");
+}
+
+/**
+  Reads the job that will arrive next from the reader of a streamed simulation.
+
+  @return 0 on success or at the end of the workload, 2 if the workload could not be read
+ */
+int simulation_read_job(simulation_t *sim)
+{
+	int job_id = sim->next_job.job_id + 1;
+	int previous_arrival = sim->next_job.arrival_time;
+	simulator_job_list_t *job = &sim->next_job;
+
+	workload_status_t status = workload_reader_next(sim->reader, &job->arrival_time, &job->run_time, &job->priority);
+	if (status == WORKLOAD_END)
+	{
+		sim->has_next_job = 0;
+		return 0;
+	}
+	else if (status != WORKLOAD_OK)
+	{
+		print_workload_error(status, "", NULL, sim->reader->m_error_line, sim->reader->m_column);
+		return 2;
+	}
+
+	if (sim->has_next_job && job->arrival_time < previous_arrival)
+	{
+		fprintf(stderr, "Job %d arrives before the job preceding it; streamed workloads must be in arrival order.\n", job_id);
+		return 2;
+	}
+
+	job->job_id = job_id;
+	job->core_id = -1;
+	job->arrived = 0;
+	job->finished = 0;
+	job->switches = 0;
+	sim->has_next_job = 1;
+	return 0;
+}
+
+/**
+  Switches a simulation to stream its jobs from a reader.
+
+  @return 0 on success, 2 if the workload could not be read
+ */
+int simulation_stream(simulation_t *sim, workload_reader_t *reader)
+{
+	if (job_table_init(&sim->table, JOB_TABLE_MIN_SIZE) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	sim->reader = reader;
+	sim->next_job.job_id = -1;
+	sim->has_next_job = 0;
+	return simulation_read_job(sim);
+}
+
+/**
+  Returns the job with the given job_id if it has been loaded (or, when
+  streaming, arrived and not yet finished), or NULL.
+ */
+simulator_job_list_t *simulation_job(simulation_t *sim, int job_id)
+{
+	if (sim->reader != NULL)
+		return job_table_find(&sim->table, job_id);
+	if (job_id < 0 || job_id >= sim->job_count)
+		return NULL;
+	return &sim->jobs[job_id];
+}
+
+int simulation_active_job(simulation_t *sim, int job_id)
+{
+	simulator_job_list_t *job = simulation_job(sim, job_id);
+	return job != NULL && job->arrived && !job->finished;
+}
+
+/**
+  Returns nonzero if the job may be placed on a core: it is active and not
+  blocked on I/O.
+ */
+int simulation_runnable_job(simulation_t *sim, int job_id)
+{
+	return simulation_active_job(sim, job_id) && (sim->io == NULL || !sim->io[job_id].blocked);
+}
+
+void simulation_print_available_jobs(simulation_t *sim)
+{
+	int i, count = 0;
+
+	if (sim->reader == NULL)
+	{
+		print_available_jobs(sim->jobs, sim->job_count);
+		return;
+	}
+
+	int *job_ids = malloc((sim->table.count + 1) * sizeof(int));
+	if (job_ids == NULL)
+		return;
+
+	for (i = 0; i < sim->table.size; i++)
+		if (sim->table.slots[i].job_id != -1 && sim->table.slots[i].arrived)
+			job_ids[count++] = sim->table.slots[i].job_id;
+	qsort(job_ids, count, sizeof(int), compare_job_ids);
+
+	printf("Active jobs are: ");
+	for (i = 0; i < count; i++)
+		printf(i == 0 ? "%d" : ", %d", job_ids[i]);
+	if (count > 0)
+		printf("\n");
+
+	free(job_ids);
+}
+
+/**
+  Returns the arrival time of the job that arrives next, or -1 if every job
+  has arrived.
+ */
+int simulation_next_arrival(simulation_t *sim)
+{
+	if (sim->reader != NULL)
+		return sim->has_next_job ? sim->next_job.arrival_time : -1;
+	if (sim->next_arrival < sim->job_count)
+		return sim->arrivals[sim->next_arrival].arrival_time;
+	return -1;
+}
+
+/**
+  Consumes the job that arrives next.  When streaming, the job is moved into
+  the job table and the job after it is read.
+
+  @return the job, or NULL if the workload could not be read
+ */
+simulator_job_list_t *simulation_take_arrival(simulation_t *sim)
+{
+	if (sim->reader == NULL)
+		return &sim->jobs[sim->arrivals[sim->next_arrival++].job_id];
+
+	simulator_job_list_t *job = job_table_insert(&sim->table, &sim->next_job);
+	if (job == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return NULL;
+	}
+
+	return (simulation_read_job(sim) == 0) ? job : NULL;
+}
+
+/**
+  Brings the I/O totals up to time.  They are brought up to date just before
+  the jobs blocked or the cores working change, rather than on every time
+  unit visited, so the state they count held all along.
+ */
+void simulation_account_io(simulation_t *sim, int time)
+{
+	if (sim->jobs_blocked > 0)
+	{
+		sim->io_time += time - sim->io_since;
+		if (sim->cores_working > 0)
+			sim->io_overlap += time - sim->io_since;
+	}
+	sim->io_since = time;
+}
+
+/**
+  Takes the job off a core, charging it for the time it ran after the core
+  switched to it.
+ */
+void simulation_vacate(simulation_t *sim, int core_id, int time)
+{
+	int job = sim->core_job[core_id];
+	if (job == -1)
+		return;
+
+	int ran = time - sim->core_since[core_id];
+	int lost = (ran < sim->core_overhead[core_id]) ? ran : sim->core_overhead[core_id];
+	sim->busy += ran;
+	sim->switch_lost += lost;
+
+	simulator_job_list_t *vacated = simulation_job(sim, job);
+	vacated->run_time -= ran - lost;
+	if (sim->io != NULL)
+	{
+		sim->io[job].burst_run -= ran - lost;
+		simulation_account_io(sim, time);
+	}
+	vacated->core_id = -1;
+	timing_diagram_stop(sim->diagram, core_id, time);
+	if (sim->trace != NULL)
+		trace_slice(sim->trace, core_id, job, sim->core_since[core_id], time);
+	sim->core_job[core_id] = -1;
+	sim->core_generation[core_id]++;
+	sim->cores_working--;
+
+	if (sim->engine == TICK_DRIVEN)
+	{
+		timerwheel_cancel(&sim->wheel, &sim->timers[2 * core_id + EVENT_COMPLETION]);
+		timerwheel_cancel(&sim->wheel, &sim->timers[2 * core_id + EVENT_QUANTUM_EXPIRY]);
+	}
+}
+
+/**
+  Arms a completion or quantum expiry deadline for a core.
+
+  @return 0 on success, -1 if out of memory
+ */
+int simulation_schedule(simulation_t *sim, int core_id, int type, int time)
+{
+	if (sim->engine == TICK_DRIVEN)
+	{
+		timerwheel_add(&sim->wheel, &sim->timers[2 * core_id + type], time);
+		return 0;
+	}
+	return eventq_push(&sim->events, time, type, core_id, sim->core_generation[core_id]);
+}
+
+/**
+  Places an arrived job on a core, taking it off any core it was running on,
+  and arms its completion (the end of its CPU burst) and, under RR, its
+  quantum expiry.  A job other than
+  the one the core last ran first costs the core a switch, which delays both
+  its completion and its quantum.
+
+  @return 0 on success, 2 if out of memory
+ */
+int simulation_place(simulation_t *sim, int core_id, int job, int time)
+{
+	if (simulation_job(sim, job)->core_id != -1)
+		simulation_vacate(sim, simulation_job(sim, job)->core_id, time);
+	if (sim->trace != NULL && sim->core_job[core_id] != -1)
+		trace_instant(sim->trace, "Preempted", core_id, sim->core_job[core_id], time);
+	simulation_vacate(sim, core_id, time);
+
+	simulator_job_list_t *placed = simulation_job(sim, job);
+	placed->core_id = core_id;
+	sim->core_job[core_id] = job;
+	sim->core_since[core_id] = time;
+	sim->core_generation[core_id]++;
+	if (sim->io != NULL)
+		simulation_account_io(sim, time);
+	sim->cores_working++;
+	timing_diagram_start(sim->diagram, core_id, job, time);
+
+	sim->core_overhead[core_id] = 0;
+	if (sim->core_last_job[core_id] != job)
+	{
+		sim->core_overhead[core_id] = sim->switch_cost;
+		sim->core_last_job[core_id] = job;
+		sim->core_switches[core_id]++;
+		if (++placed->switches > sim->max_job_switches)
+			sim->max_job_switches = placed->switches;
+	}
+
+	int run = (sim->io != NULL) ? sim->io[job].burst_run : placed->run_time;
+	if (simulation_schedule(sim, core_id, EVENT_COMPLETION, time + sim->core_overhead[core_id] + run) != 0
+			|| (sim->scheme == RR && simulation_schedule(sim, core_id, EVENT_QUANTUM_EXPIRY, time + sim->core_overhead[core_id] + sim->quantum) != 0))
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	return 0;
+}
+
+/**
+  Discards deadlines of cores that have since changed jobs, leaving the next
+  live event at the front of the event queue.
+ */
+event_t *simulation_next_event(simulation_t *sim)
+{
+	event_t *event;
+
+	while ((event = eventq_peek(&sim->events)) != NULL)
+	{
+		if (event->m_generation == sim->core_generation[event->m_key])
+			return event;
+		eventq_pop(&sim->events, NULL);
+	}
+
+	return NULL;
+}
+
+/**
+  Returns the next time unit in which anything happens, or -1 if nothing will.
+ */
+int simulation_next_time(simulation_t *sim)
+{
+	event_t *next = simulation_next_event(sim);
+	int time = simulation_next_arrival(sim);
+
+	if (next != NULL && (time == -1 || next->m_time <= time))
+		time = next->m_time;
+	if (sim->io != NULL)
+	{
+		event_t *wake = eventq_peek(&sim->wakes);
+		if (wake != NULL && (time == -1 || wake->m_time <= time))
+			time = wake->m_time;
+	}
+	return time;
+}
+
+/**
+  Takes a job that ended a CPU burst off its core until its I/O wait is
+  over, and moves it on to its next CPU burst.
+
+  @return 0 on success, 2 if out of memory
+ */
+int simulation_block(simulation_t *sim, int core_id, int job_id, int time)
+{
+	simulator_io_t *io = &sim->io[job_id];
+
+	// Vacating the core brings the I/O totals up to time
+	simulation_vacate(sim, core_id, time);
+
+	if (eventq_push(&sim->wakes, time + io->bursts[0], 0, job_id, 0) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	io->burst_run = io->bursts[1];
+	io->bursts += 2;
+	io->bursts_left -= 2;
+	io->blocked = 1;
+	sim->jobs_blocked++;
+	sim->blocks++;
+
+	if (sim->trace != NULL)
+		trace_instant(sim->trace, "Blocked", core_id, job_id, time);
+	return 0;
+}
+
+int compare_due(const void *a, const void *b)
+{
+	const simulator_due_t *x = a, *y = b;
+
+	if (x->type != y->type)
+		return x->type - y->type;
+	return x->core_id - y->core_id;
+}
+
+/**
+  Collects the completions and quantum expiries due at time, ordered as the
+  simulator delivers them: completions first, then expiries, each by core.
+  The cost is proportional to the number of deadlines due.
+ */
+void simulation_collect_due(simulation_t *sim, int time)
+{
+	sim->due_count = 0;
+
+	if (sim->engine == TICK_DRIVEN)
+	{
+		wheel_timer_t *timer;
+		for (timer = timerwheel_advance(&sim->wheel, time); timer != NULL; timer = timer->m_next)
+		{
+			simulator_due_t *due = &sim->due[sim->due_count++];
+			due->type = timer->m_key % 2;
+			due->core_id = timer->m_key / 2;
+			due->generation = sim->core_generation[due->core_id];
+		}
+
+		if (sim->due_count > 1)
+			qsort(sim->due, sim->due_count, sizeof(simulator_due_t), compare_due);
+	}
+	else
+	{
+		event_t *next;
+		while ((next = simulation_next_event(sim)) != NULL && next->m_time == time)
+		{
+			event_t event;
+			eventq_pop(&sim->events, &event);
+
+			simulator_due_t *due = &sim->due[sim->due_count++];
+			due->type = event.m_type;
+			due->core_id = event.m_key;
+			due->generation = event.m_generation;
+		}
+	}
+}
+
+/**
+  Returns nonzero if scheduler calls are reported at the output level of the
+  simulation, printing the header of the time unit before the first one.
+ */
+int simulation_reporting(simulation_t *sim, int time)
+{
+	if (sim->output < OUTPUT_EVENTS)
+		return 0;
+
+	if (sim->header_time != time)
+	{
+		printf("=== [TIME %d] ===\n", time);
+		sim->header_time = time;
+	}
+
+	return 1;
+}
+
+/**
+  Notifies the scheduler that the job on a core ended a CPU burst and blocked
+  on I/O, and places the job it picks in its stead.
+
+  @return 0 on success, 2 if out of memory, 3 if the scheduler made an invalid decision
+ */
+int simulation_notify_blocked(simulation_t *sim, int core_id, int time)
+{
+	int job_id = sim->core_job[core_id];
+	int new_job_id = scheduler_job_blocked_r(sim->scheduler, core_id, job_id, time);
+	sim->calls++;
+
+	int wake_time = time + sim->io[job_id].bursts[0];
+	if (simulation_block(sim, core_id, job_id, time) != 0)
+		return 2;
+
+	// Set the new job
+	if ( new_job_id != -1 && !simulation_runnable_job(sim, new_job_id) )
+	{
+		printf("The scheduler_job_blocked() selected an invalid job (job_id == %d).\n", new_job_id);
+		simulation_print_available_jobs(sim);
+		return 3;
+	}
+
+	if (new_job_id != -1 && simulation_place(sim, core_id, new_job_id, time) != 0)
+		return 2;
+
+	if (simulation_reporting(sim, time))
+	{
+		printf("Job %d, running on core %d, blocked on I/O until time %d. Core %d is now running job %d.\n", job_id, core_id, wake_time, core_id, new_job_id);
+		printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+	}
+	return 0;
+}
+
+/**
+  Hands the blocked jobs whose I/O is over by time back to the scheduler.
+
+  @return 0 on success, 2 if out of memory, 3 if the scheduler made an invalid decision
+ */
+int simulation_notify_woken(simulation_t *sim, int time)
+{
+	event_t *wake;
+
+	while ((wake = eventq_peek(&sim->wakes)) != NULL && wake->m_time <= time)
+	{
+		int job_id = wake->m_key;
+		eventq_pop(&sim->wakes, NULL);
+
+		sim->io[job_id].blocked = 0;
+		simulation_account_io(sim, time);
+		sim->jobs_blocked--;
+		int new_job_core_id = scheduler_job_woke_r(sim->scheduler, job_id, time);
+		sim->calls++;
+
+		if (sim->trace != NULL)
+			trace_instant(sim->trace, "Woke", -1, job_id, time);
+
+		if (new_job_core_id >= 0 && new_job_core_id < sim->cores)
+		{
+			if (simulation_reporting(sim, time))
+			{
+				printf("Job %d woke from I/O. Job %d is now running on core %d.\n", job_id, job_id, new_job_core_id);
+				printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+			}
+
+			if (simulation_place(sim, new_job_core_id, job_id, time) != 0)
+				return 2;
+		}
+		else if (new_job_core_id == -1)
+		{
+			if (simulation_reporting(sim, time))
+			{
+				printf("Job %d woke from I/O. Job %d is set to idle (-1).\n", job_id, job_id);
+				printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+			}
+		}
+		else
+		{
+			printf("The scheduler_job_woke() selected an invalid core (core_id == %d).\n", new_job_core_id);
+			print_available_cores(sim->cores);
+			return 3;
+		}
+	}
+
+	return 0;
+}
+
+/**
+  Runs the simulation.
+
+  In every time unit that is visited, the simulator:
+   1. notifies the scheduler of jobs that finished, or blocked on I/O, in the
+      last time unit,
+   2. notifies the scheduler of quantums that expired in the last time unit,
+   3. notifies the scheduler of blocked jobs whose I/O is over,
+   4. hands the jobs arriving in this time unit to the scheduler, and
+   5. runs the time unit on every core.
+  A core's remaining work and quantum are not counted down; they are deadlines
+  armed when a job is placed on the core, so visiting a time unit costs only
+  the deadlines and arrivals due in it.
+
+  The tick-driven engine visits every time unit.  The event-driven engine
+  jumps from one time unit in which something happens to the next; the
+  scheduler sees the same sequence of calls and produces the same metrics.
+
+  Below OUTPUT_FULL, time units are not printed and below OUTPUT_EVENTS,
+  neither are scheduler calls, so the queue is never walked for display.
+
+  @return 0 on success, 2 if a streamed workload could not be read or out of memory,
+  @return 3 if the scheduler made an invalid decision
+ */
+int run_simulation(simulation_t *sim)
+{
+	int cores = sim->cores;
+	int time = 0, i, arrival, result;
+	int io = (sim->io != NULL);  // without bursts, the I/O steps are skipped altogether
+
+	while ((arrival = simulation_next_arrival(sim)) != -1 || sim->jobs_alive > 0)
+	{
+		if (sim->engine == EVENT_DRIVEN)
+		{
+			time = simulation_next_time(sim);
+			if (time < sim->time)
+				time = sim->time;
+		}
+
+		if (sim->output == OUTPUT_FULL)
+			simulation_reporting(sim, time);
+
+		/*
+		 * 1. and 2. Check if any jobs finished or any quantums expired in the last time unit.
+		 */
+		simulation_collect_due(sim, time);
+
+		for (i = 0; i < sim->due_count; i++)
+		{
+			int core_id = sim->due[i].core_id;
+
+			// A completion on this core already replaced the job
+			if (sim->due[i].generation != sim->core_generation[core_id])
+				continue;
+
+			if (io && sim->due[i].type == EVENT_COMPLETION && sim->io[sim->core_job[core_id]].bursts_left > 0)
+			{
+				if ((result = simulation_notify_blocked(sim, core_id, time)) != 0)
+					return result;
+			}
+			else if (sim->due[i].type == EVENT_COMPLETION)
+			{
+				// Notify the scheduler has finished
+				int job_id = sim->core_job[core_id];
+				int new_job_id = scheduler_job_finished_r(sim->scheduler, core_id, job_id, time);
+				sim->calls++;
+
+				simulation_vacate(sim, core_id, time);
+				simulation_job(sim, job_id)->finished = 1;
+				sim->jobs_alive--;
+				if (sim->reader != NULL)
+					job_table_remove(&sim->table, job_id);
+
+				// Set the new job
+				if ( new_job_id != -1 && !simulation_runnable_job(sim, new_job_id) )
+				{
+					printf("The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
+					simulation_print_available_jobs(sim);
+					return 3;
+				}
+				else
+				{
+					if (new_job_id != -1 && simulation_place(sim, core_id, new_job_id, time) != 0)
+						return 2;
+
+					if (simulation_reporting(sim, time))
+					{
+						printf("Job %d, running on core %d, finished. Core %d is now running job %d.\n", job_id, core_id, core_id, new_job_id);
+						printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+					}
+				}
+			}
+			else
+			{
+				// Notify the scheduler the quantum has expired
+				int old_job_id = sim->core_job[core_id];
+				int new_job_id = scheduler_quantum_expired_r(sim->scheduler, core_id, time);
+				sim->calls++;
+
+				if (sim->trace != NULL)
+					trace_instant(sim->trace, "Quantum expired", core_id, old_job_id, time);
+
+				simulation_vacate(sim, core_id, time);
+
+				// Set the new job
+				if ( new_job_id != -1 && !simulation_runnable_job(sim, new_job_id) )
+				{
+					printf("The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
+					simulation_print_available_jobs(sim);
+					return 3;
+				}
+				else
+				{
+					if (new_job_id != -1 && simulation_place(sim, core_id, new_job_id, time) != 0)
+						return 2;
+
+					if (simulation_reporting(sim, time))
+					{
+						printf("Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
+						printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+					}
+				}
+			}
+		}
+
+		/*
+		 * Check to see if we finished our last job.  (If we don't check here, we would run an extra time unit that will be totally idle.)
+		 *   Handling the deadlines takes no arrivals, so the arrival looked up by the loop still holds.
+		 */
+		if (arrival == -1 && sim->jobs_alive == 0)
+		{
+			sim->time = time;
+			break;
+		}
+
+
+		/*
+		 * 3. Hand the jobs whose I/O is over back to the scheduler.
+		 */
+		if (io && (result = simulation_notify_woken(sim, time)) != 0)
+			return result;
+
+
+		/*
+		 * 4. Hand the jobs that arrive in this time unit to the scheduler.
+		 */
+		while ((arrival = simulation_next_arrival(sim)) != -1 && arrival <= time)
+		{
+			simulator_job_list_t *job = simulation_take_arrival(sim);
+			if (job == NULL)
+				return 2;
+
+			int new_job_core_id = scheduler_new_job_r(sim->scheduler, job->job_id, time, job->run_time, job->priority);
+			sim->calls++;
+			job->arrived = 1;
+			sim->jobs_alive++;
+
+			if (sim->trace != NULL)
+				trace_instant(sim->trace, "Arrived", -1, job->job_id, time);
+
+			if (new_job_core_id >= 0 && new_job_core_id < cores)
+			{
+				if (simulation_reporting(sim, time))
+				{
+					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is now running on core %d.\n",
+							job->job_id, job->run_time, job->priority, job->job_id, new_job_core_id);
+					printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+				}
+
+				// Assign the core to the new job, preempting anyone currently using it
+				if (simulation_place(sim, new_job_core_id, job->job_id, time) != 0)
+					return 2;
+			}
+			else if (new_job_core_id == -1)
+			{
+				if (simulation_reporting(sim, time))
+				{
+					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is set to idle (-1).\n",
+							job->job_id, job->run_time, job->priority, job->job_id);
+					printf("  Queue: "); scheduler_show_queue_r(sim->scheduler); printf("\n\n");
+				}
+			}
+			else
+			{
+				printf("The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
+				print_available_cores(cores);
+				return 3;
+			}
+		}
+
+
+		/*
+		 * 5. Run the time unit.  (Cores run their jobs until the next deadline; nothing to do here.)
+		 */
+
+
+		/*
+		 * 6. Print data!
+		 */
+		if (sim->output == OUTPUT_FULL)
+		{
+			printf("At the end of time unit %d...\n", time);
+
+			timing_diagram_print(sim->diagram, time + 1);
+
+			printf("\n");
+
+			printf("  Queue: ");
+			scheduler_show_queue_r(sim->scheduler);
+			printf("\n");
+			printf("\n");
+		}
+
+
+		/*
+		 * 7. Sanity Checking
+		 *
+		 * - If there's a job alive (needing to be ran) and all CPUs are idle, the scheduler failed to schedule properly.
+		 *   Jobs blocked on I/O do not need to be ran.
+		 */
+		if (sim->jobs_alive > 0 && sim->cores_working == 0 && sim->jobs_alive > sim->jobs_blocked)
+		{
+			printf("All cores are idle and at least one job remains unscheduled.\n");
+			simulation_print_available_jobs(sim);
+			return 3;
+		}
+
+
+		/*
+		 * 8. Increase time
+		 */
+		time++;
+		sim->time = time;
+	}
+
+	return 0;
+}
+
+/**
+  Prints the context switches of a finished simulation and the CPU time they
+  cost.
+ */
+void print_switching(simulation_t *sim)
+{
+	long long switches = 0;
+	int i;
+
+	for (i = 0; i < sim->cores; i++)
+		switches += sim->core_switches[i];
+
+	printf("Context Switches: %lld (at most %d for one job)\n", switches, sim->max_job_switches);
+	printf("Context Switches by Core:");
+	for (i = 0; i < sim->cores; i++)
+		printf(" %lld", sim->core_switches[i]);
+	printf("\n");
+	printf("CPU Time Lost to Switching: %lld of %lld time unit(s) (%.2f%%)\n", sim->switch_lost, sim->busy,
+			(sim->busy > 0) ? 100.0 * sim->switch_lost / sim->busy : 0.0);
+}
+
+/**
+  Prints how often the jobs of a finished simulation blocked on I/O, how much
+  of the I/O the cores overlapped with work, and the throughput.
+ */
+void print_io(simulation_t *sim)
+{
+	printf("I/O Blocks: %lld\n", sim->blocks);
+	printf("I/O Overlapped with CPU Work: %lld of %lld time unit(s) (%.2f%%)\n", sim->io_overlap, sim->io_time,
+			(sim->io_time > 0) ? 100.0 * sim->io_overlap / sim->io_time : 0.0);
+	printf("CPU Utilization: %.2f%%\n", (sim->time > 0) ? 100.0 * sim->busy / ((long long) sim->cores * sim->time) : 0.0);
+	printf("Throughput: %.2f job(s) per 1000 time units\n", (sim->time > 0) ? 1000.0 * sim->job_count / sim->time : 0.0);
+}
+
+/**
+  Names of the schemes, as printed in sweep tables.
+*/
+static const char *scheme_names[] = {"FCFS", "SJF", "PSJF", "PRI", "PPRI", "RR"};
+
+/**
+  Parses a scheme name as given to -s.  For RR, the quantum is taken from the
+  digits following the name and is 0 if there are none.
+
+  @return the scheme, or -1 if the name is not a scheme
+ */
+int parse_scheme(const char *name, int *quantum)
+{
+	*quantum = 0;
+
+	if (strcasecmp(name, "FCFS") == 0) { return FCFS; }
+	else if (strcasecmp(name, "SJF") == 0) { return SJF; }
+	else if (strcasecmp(name, "PSJF") == 0) { return PSJF; }
+	else if (strcasecmp(name, "PRI") == 0) { return PRI; }
+	else if (strcasecmp(name, "PPRI") == 0) { return PPRI; }
+	else if (strncasecmp(name, "RR", 2) == 0)
+	{
+		*quantum = atoi(name + 2);
+		return RR;
+	}
+
+	return -1;
+}
+
+/**
+  One configuration of a sweep and, once it has run, its results.
+*/
+typedef struct _sweep_config_t
+{
+	int scheme, quantum, cores;
+
+	int status;            // result of run_simulation()
+	int makespan;
+	long long events;
+	float waiting_time, turnaround_time, response_time;
+	double wall_ms, cpu_ms;
+} sweep_config_t;
+
+/**
+  A parameter sweep: every combination of the schemes, RR quanta and core
+  counts of a grid, simulated over one loaded workload.  Configurations are
+  handed out to the threads of a pool through next_config; each runs with its
+  own scheduler instance and its own copy of the jobs, sharing only the
+  arrival order.
+*/
+typedef struct _sweep_t
+{
+	sweep_config_t *configs;
+	int config_count;
+	int threads;
+	int json;
+	engine_t engine;
+	int switch_cost;
+
+	simulator_job_list_t *jobs;
+	simulator_io_t *io;    // bursts of the jobs, or NULL
+	int job_count;
+	simulator_arrival_t *arrivals;
+
+	atomic_int next_config;
+} sweep_t;
+
+/**
+  Parses a list of positive numbers separated by '/'.
+
+  @return the number of values, or -1 if the list is malformed
+ */
+int sweep_parse_list(char *list, int *values, int size)
+{
+	int count = 0;
+	char *value, *save;
+
+	for (value = strtok_r(list, "/", &save); value != NULL; value = strtok_r(NULL, "/", &save))
+	{
+		char *end;
+		long number = strtol(value, &end, 10);
+		if (*end != '\0' || number <= 0 || number > 1000000 || count == size)
+			return -1;
+		values[count++] = number;
+	}
+
+	return count > 0 ? count : -1;
+}
+
+/**
+  Expands a grid specification into the configurations of a sweep.
+
+  The grid is a comma-separated list of key=value pairs, where lists are
+  separated by '/':
+    schemes=<scheme>/...  schemes to run (default: all of them); rr runs with
+                          every quantum in quanta, rr# with the one given
+    cores=<n>/...         core counts (default: 1)
+    quanta=<n>/...        RR quanta (default: 1/2/4)
+    threads=<n>           size of the thread pool (default: one per processor)
+    format=csv|json       format of the comparison table (default: csv)
+
+  @return 0 on success, -1 if the grid is malformed
+ */
+int sweep_init(sweep_t *sweep, const char *grid)
+{
+	int length = strlen(grid) + 1;
+	int *schemes = malloc((length + 6) * sizeof(int));
+	int *scheme_quanta = malloc((length + 6) * sizeof(int));
+	int *cores = malloc(length * sizeof(int));
+	int *quanta = malloc(length * sizeof(int));
+	char *copy = strdup(grid);
+	int scheme_count = 0, core_count = 1, quantum_count = 3;
+	int i, j, k, result = -1;
+	char *pair, *save;
+
+	sweep->configs = NULL;
+	sweep->config_count = 0;
+	sweep->threads = sysconf(_SC_NPROCESSORS_ONLN);
+	sweep->json = 0;
+	atomic_init(&sweep->next_config, 0);
+
+	if (schemes == NULL || scheme_quanta == NULL || cores == NULL || quanta == NULL || copy == NULL)
+		goto done;
+
+	cores[0] = 1;
+	quanta[0] = 1; quanta[1] = 2; quanta[2] = 4;
+
+	for (pair = strtok_r(copy, ",", &save); pair != NULL; pair = strtok_r(NULL, ",", &save))
+	{
+		char *value = strchr(pair, '=');
+		if (value == NULL)
+			goto done;
+		*value++ = '\0';
+
+		if (strcmp(pair, "schemes") == 0)
+		{
+			char *name, *names_save;
+			scheme_count = 0;
+			for (name = strtok_r(value, "/", &names_save); name != NULL; name = strtok_r(NULL, "/", &names_save))
+			{
+				schemes[scheme_count] = parse_scheme(name, &scheme_quanta[scheme_count]);
+				if (schemes[scheme_count] == -1 || (schemes[scheme_count] != RR && name[strlen(name) - 1] >= '0' && name[strlen(name) - 1] <= '9'))
+					goto done;
+				scheme_count++;
+			}
+			if (scheme_count == 0)
+				goto done;
+		}
+		else if (strcmp(pair, "cores") == 0)
+		{
+			if ((core_count = sweep_parse_list(value, cores, length)) == -1)
+				goto done;
+		}
+		else if (strcmp(pair, "quanta") == 0)
+		{
+			if ((quantum_count = sweep_parse_list(value, quanta, length)) == -1)
+				goto done;
+		}
+		else if (strcmp(pair, "threads") == 0)
+		{
+			if (sweep_parse_list(value, &sweep->threads, 1) != 1)
+				goto done;
+		}
+		else if (strcmp(pair, "format") == 0)
+		{
+			if (strcasecmp(value, "csv") == 0) { sweep->json = 0; }
+			else if (strcasecmp(value, "json") == 0) { sweep->json = 1; }
+			else
+				goto done;
+		}
+		else
+			goto done;
+	}
+
+	if (scheme_count == 0)
+	{
+		for (i = FCFS; i <= RR; i++)
+		{
+			schemes[scheme_count] = i;
+			scheme_quanta[scheme_count++] = 0;
+		}
+	}
+
+	// Expand the grid, scheme by scheme, then by quantum, then by core count
+	for (i = 0; i < scheme_count; i++)
+		sweep->config_count += (schemes[i] == RR && scheme_quanta[i] == 0 ? quantum_count : 1) * core_count;
+
+	sweep->configs = calloc(sweep->config_count, sizeof(sweep_config_t));
+	if (sweep->configs == NULL)
+		goto done;
+
+	sweep->config_count = 0;
+	for (i = 0; i < scheme_count; i++)
+	{
+		int count = (schemes[i] == RR && scheme_quanta[i] == 0) ? quantum_count : 1;
+		for (j = 0; j < count; j++)
+		{
+			for (k = 0; k < core_count; k++)
+			{
+				sweep_config_t *config = &sweep->configs[sweep->config_count++];
+				config->scheme = schemes[i];
+				config->quantum = (schemes[i] != RR) ? 0 : (scheme_quanta[i] != 0) ? scheme_quanta[i] : quanta[j];
+				config->cores = cores[k];
+			}
+		}
+	}
+
+	if (sweep->threads < 1)
+		sweep->threads = 1;
+	if (sweep->threads > sweep->config_count)
+		sweep->threads = sweep->config_count;
+	result = 0;
+
+done:
+	free(schemes);
+	free(scheme_quanta);
+	free(cores);
+	free(quanta);
+	free(copy);
+	return result;
+}
+
+double elapsed_ms(struct timespec *from, struct timespec *to)
+{
+	return (to->tv_sec - from->tv_sec) * 1e3 + (to->tv_nsec - from->tv_nsec) / 1e6;
+}
+
+/**
+  Simulates one configuration of a sweep, recording its metrics and how long
+  it took.  Nothing is printed unless the scheduler makes an invalid decision.
+ */
+void sweep_run(sweep_t *sweep, sweep_config_t *config)
+{
+	struct timespec wall_start, wall_end, cpu_start, cpu_end;
+	clock_gettime(CLOCK_MONOTONIC, &wall_start);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+	simulator_job_list_t *jobs = malloc((sweep->job_count + 1) * sizeof(simulator_job_list_t));
+	if (jobs == NULL)
+	{
+		config->status = 2;
+		return;
+	}
+	memcpy(jobs, sweep->jobs, sweep->job_count * sizeof(simulator_job_list_t));
+
+	simulator_io_t *io = NULL;
+	if (sweep->io != NULL)
+	{
+		if ((io = malloc((sweep->job_count + 1) * sizeof(simulator_io_t))) == NULL)
+		{
+			free(jobs);
+			config->status = 2;
+			return;
+		}
+		memcpy(io, sweep->io, sweep->job_count * sizeof(simulator_io_t));
+	}
+
+	scheduler_t scheduler;
+	scheduler_start_up_r(&scheduler, config->cores, config->scheme);
+
+	// The diagram is never printed, so no segment is recorded
+	timing_diagram_t diagram;
+	timing_diagram_init(&diagram, config->cores);
+	diagram.window_end = 0;
+
+	simulation_t sim;
+	int result = simulation_init(&sim, jobs, sweep->job_count, sweep->arrivals, config->cores, config->scheme, config->quantum,
+			sweep->engine, OUTPUT_SUMMARY, &diagram, &scheduler);
+	sim.switch_cost = sweep->switch_cost;
+	sim.io = io;
+
+	config->status = (result == 0) ? run_simulation(&sim) : 2;
+	config->makespan = sim.time;
+	config->events = sim.calls;
+	if (config->status == 0 && sweep->job_count > 0)
+	{
+		config->waiting_time = scheduler_average_waiting_time_r(&scheduler);
+		config->turnaround_time = scheduler_average_turnaround_time_r(&scheduler);
+		config->response_time = scheduler_average_response_time_r(&scheduler);
+	}
+
+	scheduler_clean_up_r(&scheduler);
+	simulation_destroy(&sim);
+	timing_diagram_destroy(&diagram);
+	free(jobs);
+	free(io);
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	config->wall_ms = elapsed_ms(&wall_start, &wall_end);
+	config->cpu_ms = elapsed_ms(&cpu_start, &cpu_end);
+}
+
+void *sweep_worker(void *arg)
+{
+	sweep_t *sweep = arg;
+	int i;
+
+	while ((i = atomic_fetch_add(&sweep->next_config, 1)) < sweep->config_count)
+		sweep_run(sweep, &sweep->configs[i]);
+
+	return NULL;
+}
+
+/**
+  Prints the comparison table of a sweep that has run, one row per
+  configuration in grid order.  Metrics of configurations that failed are
+  left empty.
+ */
+void sweep_print(sweep_t *sweep)
+{
+	int i;
+
+	if (sweep->json)
+		printf("[\n");
+	else
+		printf("\"Scheme\",\"Quantum\",\"Cores\",\"Jobs\",\"Makespan\",\"Events\",\"Average Waiting Time\",\"Average Turnaround Time\",\"Average Response Time\",\"Wall Time (ms)\",\"CPU Time (ms)\",\"Status\"\n");
+
+	for (i = 0; i < sweep->config_count; i++)
+	{
+		sweep_config_t *config = &sweep->configs[i];
+		int ok = (config->status == 0);
+
+		if (sweep->json)
+		{
+			printf("  {\"scheme\": \"%s\", ", scheme_names[config->scheme]);
+			if (config->scheme == RR)
+				printf("\"quantum\": %d, ", config->quantum);
+			else
+				printf("\"quantum\": null, ");
+			printf("\"cores\": %d, \"jobs\": %d, ", config->cores, sweep->job_count);
+			if (ok)
+				printf("\"makespan\": %d, \"events\": %lld, \"average_waiting_time\": %.2f, \"average_turnaround_time\": %.2f, \"average_response_time\": %.2f, ",
+						config->makespan, config->events, config->waiting_time, config->turnaround_time, config->response_time);
+			else
+				printf("\"makespan\": null, \"events\": null, \"average_waiting_time\": null, \"average_turnaround_time\": null, \"average_response_time\": null, ");
+			printf("\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"status\": \"%s\"}%s\n",
+					config->wall_ms, config->cpu_ms, ok ? "ok" : "failed", (i < sweep->config_count - 1) ? "," : "");
+		}
+		else
+		{
+			printf("%s,", scheme_names[config->scheme]);
+			if (config->scheme == RR)
+				printf("%d", config->quantum);
+			printf(",%d,%d,", config->cores, sweep->job_count);
+			if (ok)
+				printf("%d,%lld,%.2f,%.2f,%.2f,", config->makespan, config->events, config->waiting_time, config->turnaround_time, config->response_time);
+			else
+				printf(",,,,,");
+			printf("%.3f,%.3f,%s\n", config->wall_ms, config->cpu_ms, ok ? "ok" : "failed");
+		}
+	}
+
+	if (sweep->json)
+		printf("]\n");
+}
+
+/**
+  Runs every configuration of a sweep on its thread pool, the calling thread
+  included, and prints the comparison table.
+
+  @return 0 if every configuration ran, 3 if any of them failed
+ */
+int sweep_run_all(sweep_t *sweep)
+{
+	pthread_t *threads = malloc(sweep->threads * sizeof(pthread_t));
+	struct timespec start, end;
+	int i, started = 0, result = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 1; threads != NULL && i < sweep->threads; i++)
+		if (pthread_create(&threads[started], NULL, sweep_worker, sweep) == 0)
+			started++;
+
+	sweep_worker(sweep);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	sweep_print(sweep);
+	fflush(stdout);
+	fprintf(stderr, "Ran %d configuration(s) of %d job(s) on %d thread(s) in %.3f ms.\n",
+			sweep->config_count, sweep->job_count, started + 1, elapsed_ms(&start, &end));
+
+	for (i = 0; i < sweep->config_count; i++)
+		if (sweep->configs[i].status != 0)
+			result = 3;
+
+	free(threads);
+	return result;
+}
+
+void sweep_destroy(sweep_t *sweep)
+{
+	free(sweep->configs);
+}
+
+int main(int argc, char **argv)
+{
+	static char output_buffer[OUTPUT_BUFFER_SIZE];
+	int c;
+	int cores = 0, scheme = -1, quantum = 0;
+	engine_t engine = TICK_DRIVEN;
+	output_t output = OUTPUT_FULL;
+	int window_start = 0, window_end = -1, window_width = 0, windowed = 0;
+	int streaming = 0, loader = 0, show_stats = 0, switch_cost = -1;
+	char *file_name = NULL, *spec = NULL, *grid = NULL, *trace_name = NULL;
+
+	static const struct option long_options[] = {
+		{"stats", no_argument, NULL, OPTION_STATS},
+		{"trace", required_argument, NULL, OPTION_TRACE},
+		{"switch-cost", required_argument, NULL, OPTION_SWITCH_COST},
+		{NULL, 0, NULL, 0}
+	};
+
+	/*
+	 * Parse command line options.
+	 */
+	while ((c = getopt_long(argc, argv, "c:s:m:o:w:SLg:x:", long_options, NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				cores = atoi(optarg);
+
+				if (cores <= 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 's':
+			{
+				int parsed_quantum, parsed = parse_scheme(optarg, &parsed_quantum);
+				if (parsed == -1)
+					break;
+
+				scheme = parsed;
+				quantum = parsed_quantum;
+				if (scheme == RR && quantum <= 0)
+				{
+					fprintf(stderr, "Option -s <scheme> requires a positive number for the quantum of RR. (Eg: -s RR2)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+			}
+
+			case 'm':
+				if (strcasecmp(optarg, "tick") == 0) { engine = TICK_DRIVEN; }
+				else if (strcasecmp(optarg, "event") == 0) { engine = EVENT_DRIVEN; }
+				else
+				{
+					fprintf(stderr, "Option -m <engine> requires either tick or event.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'o':
+				if (strcasecmp(optarg, "full") == 0) { output = OUTPUT_FULL; }
+				else if (strcasecmp(optarg, "events") == 0) { output = OUTPUT_EVENTS; }
+				else if (strcasecmp(optarg, "summary") == 0) { output = OUTPUT_SUMMARY; }
+				else
+				{
+					fprintf(stderr, "Option -o <output> requires one of full, events or summary.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'w':
+			{
+				char *colon = strchr(optarg, ':');
+
+				if (colon != NULL)
+				{
+					window_start = atoi(optarg);
+					window_end = (colon[1] != '\0') ? atoi(colon + 1) : -1;
+				}
+				else
+					window_width = atoi(optarg);
+				windowed = 1;
+
+				if (window_start < 0 || (window_end != -1 && window_end <= window_start) || (colon == NULL && window_width <= 0))
+				{
+					fprintf(stderr, "Option -w <window> requires <start>:<end> with 0 <= start < end, or a positive width.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+			}
+
+			case 'S':
+				streaming = 1;
+				break;
+
+			case 'L':
+				streaming = loader = 1;
+				break;
+
+			case 'g':
+				spec = optarg;
+				break;
+
+			case 'x':
+				grid = optarg;
+				break;
+
+			case OPTION_STATS:
+				show_stats = 1;
+				break;
+
+			case OPTION_TRACE:
+				trace_name = optarg;
+				break;
+
+			case OPTION_SWITCH_COST:
+				switch_cost = atoi(optarg);
+
+				if (switch_cost < 0)
+				{
+					fprintf(stderr, "Option --switch-cost <ticks> requires a number that is not negative.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case '?':
+				print_usage(argv[0]);
+				return 1;
+
+			default:
+				printf("...\n");
+				break;
+		}
+	}
+
+	if (grid != NULL && (cores != 0 || scheme != -1 || streaming || show_stats || trace_name != NULL))
+	{
+		fprintf(stderr, "Option -x <grid> cannot be combined with -c, -s, -S, -L, --stats or --trace.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (grid == NULL && cores == 0)
+	{
+		fprintf(stderr, "Required option -c <cores> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (grid == NULL && scheme == -1)
+	{
+		fprintf(stderr, "Required option -s <scheme> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (spec == NULL && optind == argc - 1)
+		file_name = argv[optind];
+	else if (spec == NULL || optind != argc)
+	{
+		fprintf(stderr, "A single input file, or -g and no input file, is required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+
+	/*
+	 * Load the file and populate the jobs data structure, or open it to be
+	 * streamed.
+	 */
+	workload_t workload;
+	workload_reader_t reader;
+	workload_status_t status;
+	simulator_job_list_t* jobs = NULL;
+	simulator_io_t *io = NULL;
+	int *bursts = NULL;
+	int job_id = 0;
+
+	if (streaming)
+	{
+		if (spec != NULL)
+			status = workload_reader_generate(&reader, spec);
+		else
+			status = workload_reader_open(&reader, file_name);
+		if (status == WORKLOAD_OK && loader)
+			status = workload_reader_start(&reader, LOADER_RING_CAPACITY);
+		if (status != WORKLOAD_OK)
+		{
+			print_workload_error(status, file_name, spec, 0, reader.m_column);
+			return 2;
+		}
+	}
+	else
+	{
+		workload_init(&workload);
+
+		if (spec != NULL)
+			status = workload_generate(&workload, spec);
+		else
+			status = workload_load(&workload, file_name);
+		if (status != WORKLOAD_OK)
+		{
+			print_workload_error(status, file_name, spec, workload.m_error_line, NULL);
+			return 2;
+		}
+		if (workload.m_cores != NULL || workload.m_dependency_start != NULL)
+		{
+			print_workload_error(WORKLOAD_ERROR_COLUMN, file_name, spec, 0, (workload.m_cores != NULL) ? "Cores" : "Dependencies");
+			return 2;
+		}
+
+		jobs = malloc((workload.m_count + 1) * sizeof(simulator_job_list_t));
+		if (jobs == NULL)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+
+		for (job_id = 0; job_id < workload.m_count; job_id++)
+		{
+			jobs[job_id].job_id = job_id;
+			jobs[job_id].arrival_time = workload.m_arrival_time[job_id];
+			jobs[job_id].run_time = workload.m_run_time[job_id];
+			jobs[job_id].priority = workload.m_priority[job_id];
+			jobs[job_id].core_id = -1;
+			jobs[job_id].arrived = 0;
+			jobs[job_id].finished = 0;
+			jobs[job_id].switches = 0;
+		}
+
+		if (workload.m_burst_start != NULL)
+		{
+			if ((io = malloc((workload.m_count + 1) * sizeof(simulator_io_t))) == NULL)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				return 2;
+			}
+
+			for (job_id = 0; job_id < workload.m_count; job_id++)
+			{
+				io[job_id].burst_run = jobs[job_id].run_time;
+				io[job_id].bursts = NULL;
+				io[job_id].bursts_left = 0;
+				io[job_id].blocked = 0;
+
+				if (workload.m_burst_start[job_id + 1] > workload.m_burst_start[job_id])
+				{
+					int *job_bursts = &workload.m_bursts[workload.m_burst_start[job_id]];
+					io[job_id].burst_run = job_bursts[0];
+					io[job_id].bursts = job_bursts + 1;
+					io[job_id].bursts_left = workload.m_burst_start[job_id + 1] - workload.m_burst_start[job_id] - 1;
+				}
+			}
+		}
+
+		// The jobs point into the bursts, so they outlive the workload
+		bursts = workload.m_bursts;
+		workload.m_bursts = NULL;
+		workload_destroy(&workload);
+	}
+
+
+	/*
+	 * Sweep the grid over the loaded jobs instead of running one simulation.
+	 */
+	if (grid != NULL)
+	{
+		sweep_t sweep;
+		if (sweep_init(&sweep, grid) != 0)
+		{
+			fprintf(stderr, "Illegal sweep grid \"%s\".\n", grid);
+			print_usage(argv[0]);
+			return 1;
+		}
+
+		sweep.engine = engine;
+		sweep.switch_cost = (switch_cost > 0) ? switch_cost : 0;
+		sweep.jobs = jobs;
+		sweep.io = io;
+		sweep.job_count = job_id;
+		if ((sweep.arrivals = sort_arrivals(jobs, job_id)) == NULL)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+
+		setvbuf(stdout, output_buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
+		int result = sweep_run_all(&sweep);
+
+		sweep_destroy(&sweep);
+		free(sweep.arrivals);
+		free(jobs);
+		free(io);
+		free(bursts);
+		return result;
+	}
+
+
+	/*
+	 * Run the simulation.  All output goes through one large buffer rather
+	 * than being flushed line by line.
+	 */
+	setvbuf(stdout, output_buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+	if (streaming)
+		printf("Loaded %d core(s) and streaming jobs using ", cores);
+	else
+		printf("Loaded %d core(s) and %d job(s) using ", cores, job_id);
+	if (scheme == FCFS) { printf("First Come First Served (FCFS)"); }
+	else if (scheme == SJF) { printf("Non-preemptive Shortest Job First (SJF)"); }
+	else if (scheme == PSJF) { printf("Preemptive Shortest Job First (PSJF)"); }
+	else if (scheme == PRI) { printf("Non-preemptive Priority (PRI)"); }
+	else if (scheme == PPRI) { printf("Preemptive Priority (PPRI)"); }
+	else if (scheme == RR) { printf("Round Robin (RR) with a quantum of %d", quantum); }
+	printf(" scheduling...\n\n");
+
+	scheduler_t scheduler;
+	scheduler_start_up_r(&scheduler, cores, scheme);
+
+	simulator_arrival_t *arrivals = NULL;
+	if (!streaming && (arrivals = sort_arrivals(jobs, job_id)) == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	timing_diagram_t diagram;
+	timing_diagram_init(&diagram, cores);
+	diagram.window_start = window_start;
+	diagram.window_end = window_end;
+	diagram.width = window_width;
+
+	// A summary leaves the diagram out unless a window asks for it, so no segment is recorded
+	int show_diagram = (output != OUTPUT_SUMMARY || windowed);
+	if (!show_diagram)
+		diagram.window_end = 0;
+
+	simulation_t sim;
+	if (simulation_init(&sim, jobs, job_id, arrivals, cores, scheme, quantum, engine, output, &diagram, &scheduler) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+	if (switch_cost > 0)
+		sim.switch_cost = switch_cost;
+	sim.io = io;
+	if (streaming && simulation_stream(&sim, &reader) != 0)
+		return 2;
+
+	trace_t trace;
+	if (trace_name != NULL)
+	{
+		if (trace_open(&trace, trace_name, cores) != 0)
+		{
+			fprintf(stderr, "Unable to create file \"%s\".\n", trace_name);
+			return 2;
+		}
+		sim.trace = &trace;
+	}
+
+	int result = run_simulation(&sim);
+
+	// A failed simulation still leaves a readable trace of what led up to it
+	if (trace_name != NULL && trace_close(&trace) != 0)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", trace_name);
+		if (result == 0)
+			result = 2;
+	}
+	if (result != 0)
+		return result;
+
+
+	if (show_diagram)
+	{
+		printf("FINAL TIMING DIAGRAM:\n");
+		timing_diagram_print(&diagram, sim.time);
+
+		printf("\n");
+	}
+	printf("Average Waiting Time: %.2f\n", scheduler_average_waiting_time_r(&scheduler));
+	printf("Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time_r(&scheduler));
+	printf("Average Response Time: %.2f\n", scheduler_average_response_time_r(&scheduler));
+
+	if (switch_cost != -1)
+		print_switching(&sim);
+
+	if (io != NULL)
+		print_io(&sim);
+
+	if (show_stats)
+		print_scheduler_stats(&scheduler);
+
+	scheduler_clean_up_r(&scheduler);
+
+
+	simulation_destroy(&sim);
+	timing_diagram_destroy(&diagram);
+	free(arrivals);
+	free(jobs);
+	free(io);
+	free(bursts);
+	if (streaming)
+		workload_reader_close(&reader);
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+/** @file wheeltest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libtimerwheel/libtimerwheel.h"
+
+#define TIMERS 8
+
+int failures = 0;
+
+void expect(const char *what, int value, int expected)
+{
+	printf("%s: %d (expected %d).\n", what, value, expected);
+	if (value != expected)
+		failures++;
+}
+
+int main()
+{
+	timerwheel_t w;
+	wheel_timer_t timers[TIMERS];
+	int fired[TIMERS], fired_count[TIMERS];
+
+	/* Expiries on either side of each level's span, so every level is cascaded. */
+	int expires[TIMERS] = { 5, 63, 64, 65, 4095, 4096, 262147, 16777300 };
+
+	int i, time;
+	timerwheel_init(&w, 0);
+	for (i = 0; i < TIMERS; i++)
+	{
+		timerwheel_timer(&timers[i], i);
+		timerwheel_add(&w, &timers[i], expires[i]);
+		fired[i] = -1;
+		fired_count[i] = 0;
+	}
+	expect("Pending timers", timerwheel_size(&w), TIMERS);
+
+	/* Re-arm one timer and cancel another before either expires. */
+	timerwheel_add(&w, &timers[1], 100);
+	expires[1] = 100;
+	timerwheel_cancel(&w, &timers[3]);
+	timerwheel_cancel(&w, &timers[3]);
+	expires[3] = -1;
+	expect("Pending timers after a cancel", timerwheel_size(&w), TIMERS - 1);
+
+	/* Visit every time unit, as the tick-driven engine does. */
+	for (time = 0; time <= expires[TIMERS - 1]; time++)
+	{
+		wheel_timer_t *t;
+		for (t = timerwheel_advance(&w, time); t != NULL; t = t->m_next)
+		{
+			fired[t->m_key] = time;
+			fired_count[t->m_key]++;
+		}
+	}
+
+	for (i = 0; i < TIMERS; i++)
+	{
+		char what[64];
+		sprintf(what, "Timer %d fired at", i);
+		expect(what, fired[i], expires[i]);
+		sprintf(what, "Timer %d fired times", i);
+		expect(what, fired_count[i], (expires[i] == -1) ? 0 : 1);
+	}
+	expect("Pending timers at the end", timerwheel_size(&w), 0);
+
+	/* A jump over many time units still returns every timer due in between. */
+	timerwheel_init(&w, 0);
+	for (i = 0; i < TIMERS; i++)
+		timerwheel_add(&w, &timers[i], 1000 * (i + 1));
+	int count = 0;
+	wheel_timer_t *t;
+	for (t = timerwheel_advance(&w, 5000); t != NULL; t = t->m_next)
+		count++;
+	expect("Timers returned by one jump to 5000", count, 5);
+	expect("Pending timers after the jump", timerwheel_size(&w), TIMERS - 5);
+
+	if (failures > 0)
+		printf("%d check(s) failed.\n", failures);
+	return (failures > 0) ? 1 : 0;
+}
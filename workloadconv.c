@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libworkload/libworkload.h"
+
+
+/**
+  Converts a workload (CSV, or an existing binary workload) into the binary
+  workload format, which the simulator maps and uses without parsing.
+
+  Usage: workloadconv <input file> <output file>
+ */
+int main(int argc, char **argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <input file> <output file>\n", argv[0]);
+		fprintf(stderr, "       %s examples/proc1.csv examples/proc1.wkl\n", argv[0]);
+		return 1;
+	}
+
+	workload_t workload;
+	workload_init(&workload);
+
+	switch (workload_load(&workload, argv[1]))
+	{
+		case WORKLOAD_OK:
+			break;
+
+		case WORKLOAD_ERROR_OPEN:
+			fprintf(stderr, "Unable to open file \"%s\".\n", argv[1]);
+			return 2;
+
+		case WORKLOAD_ERROR_FORMAT:
+			if (workload.m_error_line > 0)
+				fprintf(stderr, "Illegal file format on line %d.\n", workload.m_error_line);
+			else
+				fprintf(stderr, "Illegal file format.\n");
+			return 2;
+
+		case WORKLOAD_ERROR_MEMORY:
+		default:
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+	}
+
+	workload_status_t status = workload_save_binary(&workload, argv[2]);
+	if (status == WORKLOAD_ERROR_FORMAT)
+	{
+		fprintf(stderr, "The jobs of \"%s\" have bursts or dependencies, which binary workloads cannot hold.\n", argv[1]);
+		workload_destroy(&workload);
+		return 2;
+	}
+	else if (status != WORKLOAD_OK)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", argv[2]);
+		workload_destroy(&workload);
+		return 2;
+	}
+
+	printf("Converted %d job(s) from \"%s\" to \"%s\".\n", workload.m_count, argv[1], argv[2]);
+
+	workload_destroy(&workload);
+	return 0;
+}
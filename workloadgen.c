@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libworkload/libworkload.h"
+
+
+/**
+  Formats a non-negative or negative integer at p, returning the end.
+ */
+char *format_int(char *p, int value)
+{
+	char digits[12];
+	unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+	int count = 0;
+
+	if (value < 0)
+		*p++ = '-';
+	do
+	{
+		digits[count++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude > 0);
+
+	while (count > 0)
+		*p++ = digits[--count];
+	return p;
+}
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-b] <workload specification> [<output file>]\n", program_name);
+	fprintf(stderr, "       %s n=100000,seed=7,arrival=poisson:0.2,run=exp:4 > jobs.csv\n", program_name);
+	fprintf(stderr, "       %s -b n=100000000,arrival=bursty:0.5:16 jobs.wkl\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Writes CSV to the output file (default: the standard output), or with -b a binary workload.\n");
+	workgen_usage(stderr);
+}
+
+
+/**
+  Generates a synthetic workload, seeded and deterministic, as CSV that the
+  simulator (or anything else) can read, or as a binary workload.
+ */
+int main(int argc, char **argv)
+{
+	int c, binary = 0;
+
+	while ((c = getopt(argc, argv, "b")) != -1)
+	{
+		if (c == 'b')
+			binary = 1;
+		else
+		{
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind != argc - 1 && optind != argc - 2)
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const char *spec = argv[optind];
+	const char *file_name = (optind == argc - 2) ? argv[optind + 1] : NULL;
+
+	if (binary)
+	{
+		workload_t workload;
+		workload_init(&workload);
+
+		workload_status_t status = workload_generate(&workload, spec);
+		if (status == WORKLOAD_ERROR_FORMAT)
+		{
+			fprintf(stderr, "Illegal workload specification \"%s\".\n", spec);
+			return 2;
+		}
+		else if (status != WORKLOAD_OK)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+
+		if (workload.m_burst_start != NULL)
+		{
+			fprintf(stderr, "The jobs of \"%s\" have bursts, which binary workloads cannot hold.\n", spec);
+			workload_destroy(&workload);
+			return 2;
+		}
+
+		if (file_name == NULL || workload_save_binary(&workload, file_name) != WORKLOAD_OK)
+		{
+			fprintf(stderr, "Unable to write file \"%s\".\n", file_name == NULL ? "" : file_name);
+			workload_destroy(&workload);
+			return 2;
+		}
+
+		workload_destroy(&workload);
+		return 0;
+	}
+
+	workgen_t generator;
+	if (workgen_init(&generator, spec) != 0)
+	{
+		fprintf(stderr, "Illegal workload specification \"%s\".\n", spec);
+		return 2;
+	}
+
+	FILE *file = (file_name != NULL) ? fopen(file_name, "w") : stdout;
+	if (file == NULL)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", file_name);
+		return 2;
+	}
+
+	/*
+	 * Jobs are formatted by hand into a large buffer; printf would dominate
+	 * the cost of generating large traces.
+	 */
+	static char buffer[1 << 16];
+	char *p = buffer;
+	int arrival_time, run_time, priority, failed = 0, i;
+	int has_bursts = (generator.m_io_bursts > 1);
+
+	fputs(has_bursts ? "\"Arrival time\",\"Run time\",\"Priority\",\"Bursts\"\n" : "\"Arrival time\",\"Run time\",\"Priority\"\n", file);
+	while (!failed && workgen_next(&generator, &arrival_time, &run_time, &priority))
+	{
+		p = format_int(p, arrival_time);
+		*p++ = ',';
+		p = format_int(p, run_time);
+		*p++ = ',';
+		p = format_int(p, priority);
+		if (has_bursts)
+		{
+			*p++ = ',';
+			for (i = 0; i < generator.m_burst_count; i++)
+			{
+				if (i > 0)
+					*p++ = '/';
+				p = format_int(p, generator.m_bursts[i]);
+			}
+		}
+		*p++ = '\n';
+
+		// Room for the longest line: three numbers and a full burst list
+		if (p - buffer > (int)sizeof(buffer) - 64 - 12 * 2 * WORKGEN_MAX_BURSTS)
+		{
+			failed = (fwrite(buffer, 1, p - buffer, file) != (size_t)(p - buffer));
+			p = buffer;
+		}
+	}
+
+	if (!failed && p > buffer)
+		failed = (fwrite(buffer, 1, p - buffer, file) != (size_t)(p - buffer));
+	if (fclose(file) != 0 || failed)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", file_name != NULL ? file_name : "<stdout>");
+		return 2;
+	}
+
+	return 0;
+}
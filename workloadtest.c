@@ -0,0 +1,91 @@
+/** @file workloadtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libworkload/libworkload.h"
+
+#define SAVED "workloadtest.wkl"
+
+int failures = 0;
+
+void expect(const char *what, int value, int expected)
+{
+	printf("%s: %d (expected %d).\n", what, value, expected);
+	if (value != expected)
+		failures++;
+}
+
+int same_column(const int *a, const int *b, int count)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+	return memcmp(a, b, count * sizeof(int)) == 0;
+}
+
+/**
+  Saves a workload as a binary file, loads it back and checks every column
+  came back as it was.
+ */
+void round_trip(const char *name, workload_t *w)
+{
+	workload_t loaded;
+	char what[128];
+
+	sprintf(what, "%s saved", name);
+	expect(what, workload_save_binary(w, SAVED), WORKLOAD_OK);
+
+	workload_init(&loaded);
+	sprintf(what, "%s loaded back", name);
+	expect(what, workload_load(&loaded, SAVED), WORKLOAD_OK);
+
+	sprintf(what, "%s jobs", name);
+	expect(what, loaded.m_count, w->m_count);
+	sprintf(what, "%s columns identical", name);
+	expect(what, loaded.m_count == w->m_count && same_column(loaded.m_arrival_time, w->m_arrival_time, w->m_count)
+			&& same_column(loaded.m_run_time, w->m_run_time, w->m_count) && same_column(loaded.m_priority, w->m_priority, w->m_count)
+			&& same_column(loaded.m_cores, w->m_cores, w->m_count), 1);
+
+	workload_destroy(&loaded);
+	remove(SAVED);
+}
+
+int main()
+{
+	static const char *files[] = { "examples/proc1.csv", "examples/proc2.csv", "examples/proc3.csv" };
+	static const char cores[] = "\"Arrival time\",\"Run time\",\"Priority\",\"Cores\"\n0,8,4,2\n4,6,1,1\n4,6,1,4\n9,1,0,3\n";
+	static const char bursts[] = "\"Arrival time\",\"Run time\",\"Priority\",\"Bursts\"\n0,4,1,2/5/2\n";
+	workload_t w;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+	{
+		workload_init(&w);
+		expect(files[i], workload_load_csv(&w, files[i]), WORKLOAD_OK);
+		round_trip(files[i], &w);
+		workload_destroy(&w);
+	}
+
+	workload_init(&w);
+	expect("Workload with cores parsed", workload_parse_csv(&w, cores, strlen(cores)), WORKLOAD_OK);
+	expect("Cores of job 2", (w.m_cores != NULL) ? w.m_cores[2] : -1, 4);
+	round_trip("Workload with cores", &w);
+	workload_destroy(&w);
+
+	workload_init(&w);
+	expect("Generated workload", workload_generate(&w, "n=10000,seed=7"), WORKLOAD_OK);
+	round_trip("Generated workload", &w);
+	workload_destroy(&w);
+
+	/* The binary format has no bursts column, so saving must refuse rather than drop them. */
+	workload_init(&w);
+	expect("Workload with bursts parsed", workload_parse_csv(&w, bursts, strlen(bursts)), WORKLOAD_OK);
+	expect("Workload with bursts saved", workload_save_binary(&w, SAVED), WORKLOAD_ERROR_FORMAT);
+	workload_destroy(&w);
+
+	if (failures > 0)
+		printf("%d check(s) failed.\n", failures);
+	return (failures > 0) ? 1 : 0;
+}